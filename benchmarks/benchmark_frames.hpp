@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include "frame/frame_template.hpp"
+
+/*
+    Synthetic frames for the benchmarks
+
+    The bullets move on rings around a few emitters, like the spell cards
+    of the game, so consecutive frames change slowly and the objects have
+    the value ranges the compressor and the delta codec see in practice
+*/
+inline Frame make_benchmark_frame(uint32_t timestamp, uint32_t bullet_count) {
+    constexpr uint32_t EMITTER_COUNT = 4;
+    constexpr uint32_t ENEMY_COUNT = 32;
+    constexpr float TICK_SECONDS = 1.0f / 60.0f;
+
+    Frame frame = {};
+    frame.client_id = 1;
+    frame.opponent_id = 2;
+    frame.timestamp = timestamp;
+    frame.score = timestamp * 10;
+    frame.stage.id = 1;
+    frame.stage.timestamp = timestamp;
+
+    frame.player_vector.resize(1);
+    frame.player_vector[0].id = 1;
+    frame.player_vector[0].pos = { 320.0f, 400.0f };
+    frame.player_vector[0].radius = 4.0f;
+    frame.player_vector[0].lives = 3;
+    frame.player_count = 1;
+
+    frame.enemy_vector.resize(ENEMY_COUNT);
+
+    for (uint32_t i = 0; i < ENEMY_COUNT; i++)
+    {
+        auto& enemy = frame.enemy_vector[i];
+        enemy.id = i;
+        enemy.pos = { 20.0f * static_cast<float>(i), 80.0f + std::sin(static_cast<float>(timestamp + i) * TICK_SECONDS) * 16.0f };
+        enemy.radius = 12.0f;
+        enemy.health = 100;
+    }
+
+    frame.enemy_count = ENEMY_COUNT;
+
+    frame.bullet_vector.resize(bullet_count);
+
+    for (uint32_t i = 0; i < bullet_count; i++)
+    {
+        auto& bullet = frame.bullet_vector[i];
+        const auto emitter = i % EMITTER_COUNT;
+        const auto angle = static_cast<float>(i) * 0.05f;
+        const auto distance = static_cast<float>((i * 7 + timestamp) % 400);
+
+        bullet.id = i;
+        bullet.pos = { 160.0f * static_cast<float>(emitter + 1) + std::cos(angle) * distance, 120.0f + std::sin(angle) * distance };
+        bullet.vel = { std::cos(angle) * 2.0f, std::sin(angle) * 2.0f };
+        bullet.radius = 3.0f;
+        bullet.angle = angle;
+        bullet.damage = 1;
+        bullet.name = static_cast<uint8_t>(emitter);
+        bullet.flight_pattern = 2;
+        bullet.owner = 2;
+    }
+
+    frame.bullet_count = bullet_count;
+
+    return frame;
+}
\ No newline at end of file
@@ -0,0 +1,98 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include "benchmark_frames.hpp"
+#include "frame/frame_compression.hpp"
+#include "frame/frame_serializer.hpp"
+
+/*
+    Compression ratio and codec throughput of every FrameCompression mode
+
+    usage: compression_benchmark [frame count] [bullets per frame]
+*/
+namespace {
+    constexpr uint32_t BENCHMARK_MAGIC_NUMBER = 0x7F3B29D1;
+    constexpr uint32_t DEFAULT_FRAME_COUNT = 600;
+    constexpr uint32_t DEFAULT_BULLET_COUNT = 2000;
+
+    const char* compression_name(FrameCompression compression) {
+        switch (compression)
+        {
+            case FrameCompression::None:        return "none";
+            case FrameCompression::Lz:          return "lz";
+            case FrameCompression::ShuffledLz:  return "shuffled_lz";
+        }
+
+        return "unknown";
+    }
+
+    bool run_benchmark(FrameCompression compression, const std::vector<Frame>& frames) {
+        FrameCompressor compressor(compression);
+        FrameDecompressor decompressor(PACKET_BODY_SIZE_MASK);
+
+        std::vector<std::byte> packet;
+        uint64_t packet_bytes = 0;
+
+        for (const auto& frame : frames)
+        {
+            packet.clear();
+
+            if (!serialize_frame_packet(frame, BENCHMARK_MAGIC_NUMBER, compressor, packet))
+            {
+                return false;
+            }
+
+            packet_bytes += packet.size();
+
+            PacketHeader header;
+            memcpy(&header, packet.data(), sizeof(PacketHeader));
+
+            // Checks the round trip as well, a fast codec that loses data is worth nothing
+            if (has_packet_flag(packet_flags(header), PacketFlag::Compressed) &&
+                !decompressor.decompress(packet.data() + sizeof(PacketHeader), packet.size() - sizeof(PacketHeader), packet_flags(header)))
+            {
+                std::cerr << "Failed to decompress frame " << frame.timestamp << "\n";
+
+                return false;
+            }
+        }
+
+        const auto& compressor_stats = compressor.stats();
+        const auto& decompressor_stats = decompressor.stats();
+
+        std::cout << compression_name(compression)
+            << " packet_bytes " << packet_bytes
+            << " ratio " << compression_ratio(compressor_stats)
+            << " incompressible " << compressor_stats.incompressible_packets
+            << " compress_mb_s " << compression_throughput(compressor_stats)
+            << " decompress_mb_s " << compression_throughput(decompressor_stats) << "\n";
+
+        return true;
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const auto frame_count = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : DEFAULT_FRAME_COUNT;
+    const auto bullet_count = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : DEFAULT_BULLET_COUNT;
+
+    std::vector<Frame> frames;
+    frames.reserve(frame_count);
+
+    for (uint32_t i = 0; i < frame_count; i++)
+    {
+        frames.push_back(make_benchmark_frame(i, bullet_count));
+    }
+
+    std::cout << "frames " << frame_count << " bullets " << bullet_count << " frame_bytes " << serialized_frame_size(frames.front()) << "\n";
+
+    for (auto compression : { FrameCompression::None, FrameCompression::Lz, FrameCompression::ShuffledLz })
+    {
+        if (!run_benchmark(compression, frames))
+        {
+            return EXIT_FAILURE;
+        }
+    }
+
+    return EXIT_SUCCESS;
+}
\ No newline at end of file
@@ -0,0 +1,47 @@
+#include <cstdlib>
+#include <iostream>
+#include "stream_benchmark.hpp"
+
+/*
+    Receive throughput and system calls per frame of the recv and the
+    io_uring backends over TCP loopback
+
+    usage: receive_backend_benchmark [frame count] [max bullets per frame] [port]
+*/
+namespace {
+    constexpr uint32_t DEFAULT_FRAME_COUNT = 20000;
+    constexpr uint32_t DEFAULT_BULLET_COUNT = 400;
+    constexpr uint16_t DEFAULT_PORT = 29500;
+}
+
+int main(int argc, char* argv[]) {
+    const auto frame_count = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : DEFAULT_FRAME_COUNT;
+    const auto bullet_count = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : DEFAULT_BULLET_COUNT;
+    const auto port = argc > 3 ? static_cast<uint16_t>(std::strtoul(argv[3], nullptr, 10)) : DEFAULT_PORT;
+
+    const auto packets = make_benchmark_packets(frame_count, bullet_count);
+
+    for (auto backend : { SocketReceiveBackend::Recv, SocketReceiveBackend::IoUring })
+    {
+        SocketOptions socket_options;
+        socket_options.receive_backend = backend;
+
+        auto result_opt = run_stream_benchmark("127.0.0.1", port, socket_options, packets);
+
+        if (!result_opt)
+        {
+            return EXIT_FAILURE;
+        }
+
+        const auto& result = result_opt.value();
+
+        if (result.receive_backend != backend)
+        {
+            std::cerr << "io_uring is not available, measured recv instead" << "\n";
+        }
+
+        print_stream_benchmark(result.receive_backend == SocketReceiveBackend::IoUring ? "io_uring" : "recv", result);
+    }
+
+    return EXIT_SUCCESS;
+}
\ No newline at end of file
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <iostream>
+#include <optional>
+#include <string_view>
+#include "benchmark_frames.hpp"
+#include "frame/frame_pool.hpp"
+#include "frame/frame_serializer.hpp"
+#include "packet_stream/packet_stream.hpp"
+
+/*
+    Streams pre-serialized frames from a local server thread to a
+    PacketStreamClient and measures how fast the client takes them in.
+    The server sends one packet per call like the game server does, so
+    the numbers include the system calls of both ends
+*/
+constexpr uint32_t STREAM_BENCHMARK_MAGIC_NUMBER = 0x7F3B29D1;
+constexpr uint32_t STREAM_BENCHMARK_MAX_PACKET_SIZE = 4 * 1024 * 1024;
+
+struct StreamBenchmarkResult {
+    uint32_t                frames          = 0;
+    uint64_t                bytes           = 0;
+    double                  elapsed_ms      = 0.0;
+    PacketStreamStats       stats;
+
+    // The backend actually used, io_uring falls back to recv where the kernel lacks it
+    SocketReceiveBackend    receive_backend = SocketReceiveBackend::Recv;
+};
+
+// Frame packets with a varying number of bullets, so the reads never line up with the packets
+inline std::vector<std::vector<std::byte>> make_benchmark_packets(uint32_t frame_count, uint32_t max_bullet_count) {
+    FrameCompressor compressor(FrameCompression::None);
+    std::vector<std::vector<std::byte>> packets(frame_count);
+
+    for (uint32_t i = 0; i < frame_count; i++)
+    {
+        const auto frame = make_benchmark_frame(i, (i * 37) % (max_bullet_count + 1));
+        serialize_frame_packet(frame, STREAM_BENCHMARK_MAGIC_NUMBER, compressor, packets[i]);
+    }
+
+    return packets;
+}
+
+inline std::optional<StreamBenchmarkResult> run_stream_benchmark(
+    std::string_view server_addr,
+    uint16_t server_port,
+    const SocketOptions& socket_options,
+    const std::vector<std::vector<std::byte>>& packets)
+{
+    ServerSocket server_socket(server_addr, server_port);
+
+    if (!server_socket.initialize())
+    {
+        std::cerr << "Failed to listen on " << server_addr << " port " << server_port << "\n";
+
+        return std::nullopt;
+    }
+
+    std::thread server_thread([&]() {
+        auto client_opt = server_socket.accept_client();
+
+        if (!client_opt)
+        {
+            return;
+        }
+
+        for (const auto& packet : packets)
+        {
+            client_opt->send_data(packet);
+        }
+
+        // Lets the client drain the socket before the connection goes away
+        std::this_thread::sleep_for(std::chrono::milliseconds(500));
+        client_opt->disconnect();
+    });
+
+    PacketStreamClient client(server_addr, server_port, STREAM_BENCHMARK_MAGIC_NUMBER, STREAM_BENCHMARK_MAX_PACKET_SIZE);
+    client.set_packet_read_timeout(std::chrono::milliseconds(1000));
+    client.set_socket_options(socket_options);
+
+    StreamBenchmarkResult result;
+
+    if (client.connect_to_server())
+    {
+        FramePool frame_pool;
+        std::vector<Frame> frames;
+
+        const auto start = std::chrono::steady_clock::now();
+
+        while (result.frames < packets.size() && client.is_connected())
+        {
+            client.retrieve_all_frames(frames, frame_pool, 1);
+
+            for (const auto& frame : frames)
+            {
+                result.bytes += packets[frame.timestamp].size();
+            }
+
+            result.frames += static_cast<uint32_t>(frames.size());
+            frame_pool.release(frames);
+        }
+
+        result.elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        result.stats = client.stats();
+        result.receive_backend = client.receive_backend();
+    }
+
+    client.disconnect();
+    server_thread.join();
+
+    if (result.frames != packets.size())
+    {
+        std::cerr << "Received " << result.frames << " of " << packets.size() << " frames" << "\n";
+
+        return std::nullopt;
+    }
+
+    return result;
+}
+
+inline void print_stream_benchmark(std::string_view name, const StreamBenchmarkResult& result) {
+    const auto syscalls = result.stats.recv_calls + result.stats.wait_calls + result.stats.ring_enter_calls;
+
+    std::cout << name
+        << " frames " << result.frames
+        << " ms " << result.elapsed_ms
+        << " mb_s " << (static_cast<double>(result.bytes) / (1024.0 * 1024.0)) / (result.elapsed_ms * 1e-3)
+        << " frames_s " << static_cast<double>(result.frames) / (result.elapsed_ms * 1e-3)
+        << " syscalls_per_frame " << static_cast<double>(syscalls) / static_cast<double>(result.frames) << "\n";
+}
\ No newline at end of file
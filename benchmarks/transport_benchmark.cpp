@@ -0,0 +1,48 @@
+#include <string>
+#include <utility>
+#include <cstdlib>
+#include <iostream>
+#include <unistd.h>
+#include "stream_benchmark.hpp"
+
+/*
+    Receive throughput and system calls per frame of a Unix domain socket
+    against TCP loopback, both read through the recv backend
+
+    usage: transport_benchmark [frame count] [max bullets per frame] [port]
+*/
+namespace {
+    constexpr uint32_t DEFAULT_FRAME_COUNT = 20000;
+    constexpr uint32_t DEFAULT_BULLET_COUNT = 400;
+    constexpr uint16_t DEFAULT_PORT = 29501;
+}
+
+int main(int argc, char* argv[]) {
+    const auto frame_count = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : DEFAULT_FRAME_COUNT;
+    const auto bullet_count = argc > 2 ? static_cast<uint32_t>(std::strtoul(argv[2], nullptr, 10)) : DEFAULT_BULLET_COUNT;
+    const auto port = argc > 3 ? static_cast<uint16_t>(std::strtoul(argv[3], nullptr, 10)) : DEFAULT_PORT;
+
+    const auto packets = make_benchmark_packets(frame_count, bullet_count);
+
+    // One path per process, so concurrent runs do not remove each other's socket file
+    const auto unix_addr = "unix:/tmp/bullet_hell_benchmark_" + std::to_string(getpid()) + ".sock";
+
+    const std::pair<const char*, std::string> transports[] = {
+        { "tcp_loopback", "127.0.0.1" },
+        { "unix", unix_addr },
+    };
+
+    for (const auto& [name, server_addr] : transports)
+    {
+        auto result_opt = run_stream_benchmark(server_addr, port, SocketOptions(), packets);
+
+        if (!result_opt)
+        {
+            return EXIT_FAILURE;
+        }
+
+        print_stream_benchmark(name, result_opt.value());
+    }
+
+    return EXIT_SUCCESS;
+}
\ No newline at end of file
@@ -0,0 +1,72 @@
+#include <new>
+#include <cstdlib>
+#include "allocation_counter.hpp"
+
+#ifdef BULLET_HELL_COUNT_ALLOCATIONS
+namespace {
+    // Trivial type, so accessing it never allocates by itself
+    thread_local uint64_t t_allocation_count = 0;
+}
+
+void* operator new(std::size_t size) {
+    t_allocation_count++;
+
+    // malloc(0) may return nullptr, operator new must not
+    if (void* memory = std::malloc(size == 0 ? 1 : size))
+    {
+        return memory;
+    }
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+// Over-aligned types (alignas above __STDCPP_DEFAULT_NEW_ALIGNMENT__) come through these
+void* operator new(std::size_t size, std::align_val_t alignment) {
+    t_allocation_count++;
+
+    const auto align = static_cast<std::size_t>(alignment);
+    const auto alloc_size = size == 0 ? 1 : size;
+
+#ifdef _WIN32
+    void* memory = _aligned_malloc(alloc_size, align);
+#else
+    // aligned_alloc wants the size to be a multiple of the alignment
+    void* memory = std::aligned_alloc(align, (alloc_size + align - 1) / align * align);
+#endif
+
+    if (memory)
+    {
+        return memory;
+    }
+
+    throw std::bad_alloc();
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept {
+#ifdef _WIN32
+    _aligned_free(memory);
+#else
+    std::free(memory);
+#endif
+}
+
+void operator delete(void* memory, std::size_t, std::align_val_t alignment) noexcept {
+    operator delete(memory, alignment);
+}
+
+uint64_t thread_allocation_count() {
+    return t_allocation_count;
+}
+#else
+uint64_t thread_allocation_count() {
+    return 0;
+}
+#endif
\ No newline at end of file
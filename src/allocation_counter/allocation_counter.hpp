@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+
+/*
+    Opt-in heap allocation counter
+
+    Configuring with -DBULLET_HELL_COUNT_ALLOCATIONS=ON replaces the global
+    operator new (including the aligned overloads) by one that counts every
+    allocation of the calling thread, which makes it possible to check that
+    a code path stops allocating after warm-up. Otherwise the default
+    operator new is kept and the counter always reads 0
+*/
+constexpr bool ALLOCATION_COUNTER_ENABLED =
+#ifdef BULLET_HELL_COUNT_ALLOCATIONS
+    true;
+#else
+    false;
+#endif
+
+// Number of heap allocations made by the calling thread so far
+uint64_t thread_allocation_count();
\ No newline at end of file
@@ -0,0 +1,141 @@
+#include <algorithm>
+#include "clock_sync.hpp"
+#include "../frame/frame_serializer.hpp"
+
+namespace {
+    // Pongs answering older pings are ignored, their samples would be stale
+    constexpr uint32_t MAX_PING_AGE = 64;
+
+    std::chrono::nanoseconds ticks_to_duration(double ticks, double ticks_per_second) {
+        return std::chrono::nanoseconds(static_cast<int64_t>(ticks * 1e9 / ticks_per_second));
+    }
+}
+
+std::optional<LocalClock::time_point> ClockEstimate::server_to_local(uint32_t timestamp) const {
+    if (!valid)
+    {
+        return std::nullopt;
+    }
+
+    // Serial number arithmetic, survives the wrap around of the server clock
+    const auto ticks = static_cast<int32_t>(timestamp - reference_server_time);
+
+    return reference_local_time + ticks_to_duration(ticks, server_ticks_per_second);
+}
+
+ClockSync::ClockSync(double server_ticks_per_second)
+    : m_server_ticks_per_second(server_ticks_per_second)
+    , m_epoch(LocalClock::now())
+    , m_next_sequence(0)
+    , m_samples{}
+    , m_sample_count(0)
+{
+    m_estimate.server_ticks_per_second = server_ticks_per_second;
+}
+
+ClockPing ClockSync::make_ping() {
+    ClockPing ping = {};
+    ping.sequence = m_next_sequence++;
+    ping.client_time_us = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(LocalClock::now() - m_epoch).count());
+
+    return ping;
+}
+
+bool ClockSync::add_pong(const ClockPong& pong, LocalClock::time_point receive_time) {
+    const auto age = m_next_sequence - pong.sequence;
+
+    if (age == 0 || age > MAX_PING_AGE)
+    {
+        return false;
+    }
+
+    const auto send_time = m_epoch + std::chrono::microseconds(pong.client_time_us);
+    const auto server_ticks = static_cast<int32_t>(pong.server_send_time - pong.server_receive_time);
+
+    if (send_time > receive_time || server_ticks < 0)
+    {
+        return false;
+    }
+
+    const auto round_trip = receive_time - send_time;
+    const auto server_time = ticks_to_duration(server_ticks, m_server_ticks_per_second);
+
+    // A coarse server clock can make the server time exceed the round trip
+    const auto rtt = std::max(std::chrono::duration_cast<std::chrono::nanoseconds>(round_trip - server_time), std::chrono::nanoseconds::zero());
+
+    // The midpoint of the exchange on both clocks, moved back to the server receive time
+    Sample sample;
+    sample.rtt = rtt;
+    sample.server_time = pong.server_receive_time;
+    sample.local_time = send_time + round_trip / 2 - server_time / 2;
+
+    m_samples[m_sample_count % SAMPLE_WINDOW] = sample;
+    m_sample_count++;
+
+    update_rtt(rtt);
+
+    const auto window_end = m_samples.begin() + static_cast<ptrdiff_t>(std::min<uint64_t>(m_sample_count, SAMPLE_WINDOW));
+    const auto& best = *std::min_element(m_samples.begin(), window_end, [](const Sample& a, const Sample& b) {
+        return a.rtt < b.rtt;
+    });
+
+    m_estimate.valid = true;
+    m_estimate.reference_server_time = best.server_time;
+    m_estimate.reference_local_time = best.local_time;
+
+    return true;
+}
+
+const ClockEstimate& ClockSync::estimate() const {
+    return m_estimate;
+}
+
+std::optional<LocalClock::time_point> ClockSync::server_to_local(uint32_t timestamp) const {
+    return m_estimate.server_to_local(timestamp);
+}
+
+uint64_t ClockSync::sample_count() const {
+    return m_sample_count;
+}
+
+void ClockSync::reset() {
+    m_sample_count = 0;
+    m_estimate = ClockEstimate();
+    m_estimate.server_ticks_per_second = m_server_ticks_per_second;
+}
+
+void ClockSync::update_rtt(std::chrono::nanoseconds rtt) {
+    using std::chrono::microseconds;
+
+    const auto rtt_us = std::chrono::duration_cast<microseconds>(rtt);
+
+    // Smoothed like TCP's retransmission timer (RFC 6298)
+    if (m_sample_count == 1)
+    {
+        m_estimate.rtt = rtt_us;
+        m_estimate.rtt_jitter = rtt_us / 2;
+
+        return;
+    }
+
+    const auto deviation = rtt_us > m_estimate.rtt ? rtt_us - m_estimate.rtt : m_estimate.rtt - rtt_us;
+
+    m_estimate.rtt_jitter = (m_estimate.rtt_jitter * 3 + deviation) / 4;
+    m_estimate.rtt = (m_estimate.rtt * 7 + rtt_us) / 8;
+}
+
+void append_clock_pong(
+    std::vector<std::byte>& bytes,
+    uint32_t magic_number,
+    const ClockPing& ping,
+    uint32_t server_receive_time,
+    uint32_t server_send_time)
+{
+    ClockPong pong = {};
+    pong.sequence = ping.sequence;
+    pong.server_receive_time = server_receive_time;
+    pong.server_send_time = server_send_time;
+    pong.client_time_us = ping.client_time_us;
+
+    append_packet(bytes, magic_number, PacketType::ClockPong, reinterpret_cast<const std::byte*>(&pong), sizeof(pong));
+}
\ No newline at end of file
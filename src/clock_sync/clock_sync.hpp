@@ -0,0 +1,95 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include "../frame/frame_template.hpp"
+
+using LocalClock = std::chrono::steady_clock;
+
+/*
+    Relation between the server clock (Frame::timestamp, Stage::timestamp)
+    and the local steady clock, as a value that can be copied to other threads
+*/
+struct ClockEstimate {
+    bool                    valid                   = false;
+
+    // A server time and the local time it corresponds to
+    uint32_t                reference_server_time   = 0;
+    LocalClock::time_point  reference_local_time;
+    double                  server_ticks_per_second = 1000.0;
+
+    // Smoothed round trip time and its mean deviation (jitter)
+    std::chrono::microseconds rtt                   = std::chrono::microseconds::zero();
+    std::chrono::microseconds rtt_jitter            = std::chrono::microseconds::zero();
+
+    /*
+        Local time at which the server clock showed timestamp. Timestamps
+        within 2^31 ticks of the reference are mapped correctly across the
+        wrap around of the 32 bit server clock
+    */
+    std::optional<LocalClock::time_point> server_to_local(uint32_t timestamp) const;
+};
+
+/*
+    NTP-style clock synchronization
+
+    Every ping/pong exchange yields four times: client send (t0), server
+    receive (t1), server send (t2) and client receive (t3). The server
+    time halfway between t1 and t2 is assumed to correspond to the local
+    time halfway between t0 and t3, which is exact when both directions
+    take equally long. Queuing delay makes a sample asymmetric, and it
+    also makes the round trip longer, so of the last few samples the one
+    with the shortest round trip defines the estimate
+*/
+class ClockSync {
+public:
+    // server_ticks_per_second is the rate of the server clock, 1000 for milliseconds
+    ClockSync(double server_ticks_per_second = 1000.0);
+
+    // Fills in a ping for now and remembers when it was sent
+    ClockPing make_ping();
+
+    // Returns false if the pong does not answer a ping or its times do not add up
+    bool add_pong(const ClockPong& pong, LocalClock::time_point receive_time = LocalClock::now());
+
+    const ClockEstimate& estimate() const;
+    std::optional<LocalClock::time_point> server_to_local(uint32_t timestamp) const;
+
+    // Accepted samples so far
+    uint64_t sample_count() const;
+
+    void reset();
+
+private:
+    struct Sample {
+        std::chrono::nanoseconds    rtt;
+        uint32_t                    server_time;
+        LocalClock::time_point      local_time;
+    };
+
+    static constexpr size_t SAMPLE_WINDOW = 8;
+
+    void update_rtt(std::chrono::nanoseconds rtt);
+
+    double                              m_server_ticks_per_second;
+    LocalClock::time_point              m_epoch;
+    uint32_t                            m_next_sequence;
+
+    std::array<Sample, SAMPLE_WINDOW>   m_samples;
+    uint64_t                            m_sample_count;
+
+    ClockEstimate                       m_estimate;
+};
+
+// Server side, appends the pong answering ping
+void append_clock_pong(
+    std::vector<std::byte>& bytes,
+    uint32_t magic_number,
+    const ClockPing& ping,
+    uint32_t server_receive_time,
+    uint32_t server_send_time
+);
\ No newline at end of file
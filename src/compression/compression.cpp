@@ -0,0 +1,279 @@
+#include <array>
+#include <algorithm>
+#include <cstring>
+#include "compression.hpp"
+
+namespace {
+    constexpr size_t    MIN_MATCH       = 4;
+    constexpr size_t    MAX_OFFSET      = 65535;
+    constexpr uint32_t  RUN_MASK        = 15;
+    constexpr uint32_t  HASH_BITS       = 12;
+
+    // Literals are scanned faster the longer no match has been found
+    constexpr uint32_t  SKIP_TRIGGER    = 6;
+
+    uint32_t read_u32(const std::byte* data) {
+        uint32_t value;
+        memcpy(&value, data, sizeof(value));
+
+        return value;
+    }
+
+    uint32_t hash_sequence(uint32_t sequence) {
+        return (sequence * 2654435761u) >> (32 - HASH_BITS);
+    }
+
+    class BlockWriter {
+    public:
+        BlockWriter(std::byte* dst, size_t capacity) : m_offset(dst), m_end(dst + capacity) {}
+
+        bool write_byte(uint8_t value) {
+            if (m_offset == m_end)
+            {
+                return false;
+            }
+
+            *m_offset++ = static_cast<std::byte>(value);
+
+            return true;
+        }
+
+        bool write_bytes(const std::byte* data, size_t size) {
+            if (static_cast<size_t>(m_end - m_offset) < size)
+            {
+                return false;
+            }
+
+            // An empty literal run may come with a null data pointer, which memcpy does not allow
+            if (size > 0)
+            {
+                memcpy(m_offset, data, size);
+                m_offset += size;
+            }
+
+            return true;
+        }
+
+        // Continuation bytes of a length whose nibble was saturated
+        bool write_length(size_t length) {
+            for (; length >= 255; length -= 255)
+            {
+                if (!write_byte(255))
+                {
+                    return false;
+                }
+            }
+
+            return write_byte(static_cast<uint8_t>(length));
+        }
+
+        bool write_sequence(const std::byte* literals, size_t literal_length, size_t offset, size_t match_length) {
+            const auto literal_nibble = std::min<size_t>(literal_length, RUN_MASK);
+            const auto match_nibble = match_length > 0 ? std::min<size_t>(match_length - MIN_MATCH, RUN_MASK) : 0;
+
+            auto succeed = write_byte(static_cast<uint8_t>((literal_nibble << 4) | match_nibble));
+
+            if (succeed && literal_nibble == RUN_MASK)
+            {
+                succeed = write_length(literal_length - RUN_MASK);
+            }
+
+            succeed = succeed && write_bytes(literals, literal_length);
+
+            if (succeed && match_length > 0)
+            {
+                succeed = write_byte(static_cast<uint8_t>(offset & 0xFF)) &&
+                    write_byte(static_cast<uint8_t>(offset >> 8));
+
+                if (succeed && match_nibble == RUN_MASK)
+                {
+                    succeed = write_length(match_length - MIN_MATCH - RUN_MASK);
+                }
+            }
+
+            return succeed;
+        }
+
+        std::byte* position() const { return m_offset; }
+
+    private:
+        std::byte*          m_offset;
+        std::byte* const    m_end;
+    };
+
+    // Reads the continuation bytes of a saturated length
+    bool read_length(const std::byte*& offset, const std::byte* end, size_t& length) {
+        uint8_t value;
+
+        do
+        {
+            if (offset == end)
+            {
+                return false;
+            }
+
+            value = static_cast<uint8_t>(*offset++);
+            length += value;
+        } while (value == 255);
+
+        return true;
+    }
+}
+
+size_t lz_compress_bound(size_t size) {
+    return size + size / 255 + 16;
+}
+
+size_t lz_compress(const std::byte* src, size_t size, std::byte* dst, size_t capacity) {
+    BlockWriter writer(dst, capacity);
+
+    std::array<uint32_t, 1u << HASH_BITS> table;
+    table.fill(0);
+
+    size_t anchor = 0;
+    size_t position = 0;
+    uint32_t misses = 0;
+
+    while (size >= MIN_MATCH && position <= size - MIN_MATCH)
+    {
+        const auto sequence = read_u32(src + position);
+        const auto hash = hash_sequence(sequence);
+        const size_t candidate = table[hash];
+
+        table[hash] = static_cast<uint32_t>(position);
+
+        // The table starts zeroed, so the candidate is always verified
+        if (candidate >= position || position - candidate > MAX_OFFSET || read_u32(src + candidate) != sequence)
+        {
+            position += 1 + (misses++ >> SKIP_TRIGGER);
+
+            continue;
+        }
+
+        auto match_length = MIN_MATCH;
+
+        while (position + match_length < size && src[candidate + match_length] == src[position + match_length])
+        {
+            match_length++;
+        }
+
+        if (!writer.write_sequence(src + anchor, position - anchor, position - candidate, match_length))
+        {
+            return 0;
+        }
+
+        position += match_length;
+        anchor = position;
+        misses = 0;
+    }
+
+    if (!writer.write_sequence(src + anchor, size - anchor, 0, 0))
+    {
+        return 0;
+    }
+
+    return static_cast<size_t>(writer.position() - dst);
+}
+
+std::optional<size_t> lz_decompress(const std::byte* src, size_t size, std::byte* dst, size_t capacity) {
+    auto offset = src;
+    const auto end = src + size;
+    size_t output_size = 0;
+
+    while (offset < end)
+    {
+        const auto token = static_cast<uint8_t>(*offset++);
+
+        // Literals
+        size_t literal_length = token >> 4;
+
+        if (literal_length == RUN_MASK && !read_length(offset, end, literal_length))
+        {
+            return std::nullopt;
+        }
+
+        if (static_cast<size_t>(end - offset) < literal_length || capacity - output_size < literal_length)
+        {
+            return std::nullopt;
+        }
+
+        // A sequence may start with a match, dst is null when decoding into an empty buffer
+        if (literal_length > 0)
+        {
+            memcpy(dst + output_size, offset, literal_length);
+            offset += literal_length;
+            output_size += literal_length;
+        }
+
+        // The last sequence has no match
+        if (offset == end)
+        {
+            break;
+        }
+
+        // Match
+        if (end - offset < 2)
+        {
+            return std::nullopt;
+        }
+
+        const size_t match_offset = static_cast<size_t>(offset[0]) | (static_cast<size_t>(offset[1]) << 8);
+        offset += 2;
+
+        size_t match_length = (token & RUN_MASK) + MIN_MATCH;
+
+        if ((token & RUN_MASK) == RUN_MASK && !read_length(offset, end, match_length))
+        {
+            return std::nullopt;
+        }
+
+        if (match_offset == 0 || match_offset > output_size || capacity - output_size < match_length)
+        {
+            return std::nullopt;
+        }
+
+        auto match = dst + output_size - match_offset;
+        auto out = dst + output_size;
+
+        if (match_offset >= match_length)
+        {
+            memcpy(out, match, match_length);
+        }
+        else
+        {
+            // Overlapping match, e.g. a run of the same object repeated
+            for (size_t i = 0; i < match_length; i++)
+            {
+                out[i] = match[i];
+            }
+        }
+
+        output_size += match_length;
+    }
+
+    return output_size;
+}
+
+void shuffle_bytes(const std::byte* src, size_t count, size_t element_size, std::byte* dst) {
+    for (size_t byte = 0; byte < element_size; byte++)
+    {
+        auto dst_offset = dst + byte * count;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            dst_offset[i] = src[i * element_size + byte];
+        }
+    }
+}
+
+void unshuffle_bytes(const std::byte* src, size_t count, size_t element_size, std::byte* dst) {
+    for (size_t byte = 0; byte < element_size; byte++)
+    {
+        auto src_offset = src + byte * count;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            dst[i * element_size + byte] = src_offset[i];
+        }
+    }
+}
\ No newline at end of file
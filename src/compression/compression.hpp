@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+
+/*
+    Fast LZ block codec
+
+    A block is a sequence of (literals, match) pairs in the spirit of LZ4.
+    Every sequence starts with a token byte whose high nibble is the literal
+    length and whose low nibble is the match length minus 4, a nibble of 15
+    is continued by 255-valued bytes. The literals follow the token, then a
+    2 byte little-endian offset back into the output. The last sequence of
+    a block only carries literals.
+
+    Matches are found through a single-entry hash table, which trades ratio
+    for speed. Frame bodies are mostly arrays of equally sized objects, so
+    even short offsets (one object back) produce long matches
+*/
+
+// Worst-case compressed size of size input bytes
+size_t lz_compress_bound(size_t size);
+
+// Returns the compressed size, or 0 if the result does not fit in capacity
+size_t lz_compress(const std::byte* src, size_t size, std::byte* dst, size_t capacity);
+
+// Returns the decompressed size, or std::nullopt if the block is malformed or does not fit
+std::optional<size_t> lz_decompress(const std::byte* src, size_t size, std::byte* dst, size_t capacity);
+
+/*
+    Byte-shuffle filter
+
+    Transposes count elements of element_size bytes so that the first byte
+    of every element comes first, then every second byte and so on. Fields
+    that barely change between objects (ids, states, high bytes of floats)
+    turn into long runs that the LZ codec compresses well
+*/
+void shuffle_bytes(const std::byte* src, size_t count, size_t element_size, std::byte* dst);
+void unshuffle_bytes(const std::byte* src, size_t count, size_t element_size, std::byte* dst);
\ No newline at end of file
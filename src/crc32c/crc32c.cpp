@@ -0,0 +1,124 @@
+#include <array>
+#include <cstring>
+#include "crc32c.hpp"
+
+#if defined(__GNUC__) && defined(__x86_64__)
+    #define CRC32C_X86 1
+    #include <immintrin.h>
+#else
+    #define CRC32C_X86 0
+#endif
+
+namespace {
+    using CrcFunction = uint32_t (*)(const std::byte*, size_t, uint32_t);
+    using CrcTables = std::array<std::array<uint32_t, 256>, 8>;
+
+    // Reflected Castagnoli polynomial
+    constexpr uint32_t CRC32C_POLYNOMIAL = 0x82F63B78;
+
+    /*
+        tables[0] is the classic byte-at-a-time table, tables[k] advances
+        the checksum of a byte by k more zero bytes, so 8 lookups that do
+        not depend on each other consume 8 bytes at once
+    */
+    constexpr CrcTables make_crc_tables() {
+        CrcTables tables = {};
+
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t crc = i;
+
+            for (int bit = 0; bit < 8; bit++)
+            {
+                crc = (crc >> 1) ^ ((crc & 1) != 0 ? CRC32C_POLYNOMIAL : 0);
+            }
+
+            tables[0][i] = crc;
+        }
+
+        for (size_t k = 1; k < tables.size(); k++)
+        {
+            for (uint32_t i = 0; i < 256; i++)
+            {
+                tables[k][i] = (tables[k - 1][i] >> 8) ^ tables[0][tables[k - 1][i] & 0xFF];
+            }
+        }
+
+        return tables;
+    }
+
+    constexpr CrcTables CRC_TABLES = make_crc_tables();
+
+    uint32_t crc32c_slicing_by_8(const std::byte* data, size_t size, uint32_t crc) {
+        crc = ~crc;
+
+        for (; size >= 8; size -= 8, data += 8)
+        {
+            // Little-endian loads, the tables are indexed by the bytes in stream order
+            uint32_t low;
+            uint32_t high;
+            memcpy(&low, data, sizeof(low));
+            memcpy(&high, data + 4, sizeof(high));
+
+            low ^= crc;
+
+            crc = CRC_TABLES[7][low & 0xFF] ^
+                CRC_TABLES[6][(low >> 8) & 0xFF] ^
+                CRC_TABLES[5][(low >> 16) & 0xFF] ^
+                CRC_TABLES[4][low >> 24] ^
+                CRC_TABLES[3][high & 0xFF] ^
+                CRC_TABLES[2][(high >> 8) & 0xFF] ^
+                CRC_TABLES[1][(high >> 16) & 0xFF] ^
+                CRC_TABLES[0][high >> 24];
+        }
+
+        for (; size > 0; size--, data++)
+        {
+            crc = (crc >> 8) ^ CRC_TABLES[0][(crc ^ static_cast<uint8_t>(*data)) & 0xFF];
+        }
+
+        return ~crc;
+    }
+
+#if CRC32C_X86
+    __attribute__((target("sse4.2")))
+    uint32_t crc32c_sse42(const std::byte* data, size_t size, uint32_t crc) {
+        uint64_t crc64 = ~crc;
+
+        for (; size >= 8; size -= 8, data += 8)
+        {
+            uint64_t word;
+            memcpy(&word, data, sizeof(word));
+
+            crc64 = _mm_crc32_u64(crc64, word);
+        }
+
+        auto crc32 = static_cast<uint32_t>(crc64);
+
+        for (; size > 0; size--, data++)
+        {
+            crc32 = _mm_crc32_u8(crc32, static_cast<uint8_t>(*data));
+        }
+
+        return ~crc32;
+    }
+#endif
+
+    CrcFunction select_crc_function() {
+#if CRC32C_X86
+        __builtin_cpu_init();
+
+        if (__builtin_cpu_supports("sse4.2"))
+        {
+            return crc32c_sse42;
+        }
+#endif
+        return crc32c_slicing_by_8;
+    }
+}
+
+uint32_t crc32c(const std::byte* data, size_t size, uint32_t crc) {
+    static const CrcFunction crc_function = select_crc_function();
+
+    return crc_function(data, size, crc);
+}
\ No newline at end of file
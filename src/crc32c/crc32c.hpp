@@ -0,0 +1,14 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+    CRC-32C (Castagnoli), the checksum of iSCSI, SCTP and ext4
+
+    Uses the SSE4.2 crc32 instruction when the CPU supports it and falls
+    back to a slicing-by-8 table lookup otherwise, the implementation is
+    selected once at runtime. Passing the result of a previous call as crc
+    continues the checksum, so a buffer can be checksummed in pieces
+*/
+uint32_t crc32c(const std::byte* data, size_t size, uint32_t crc = 0);
\ No newline at end of file
@@ -0,0 +1,413 @@
+#include <cstring>
+#include <algorithm>
+#include "datagram.hpp"
+
+namespace {
+    // Largest possible UDP payload, anything bigger than a fragment is rejected instead of truncated
+    constexpr size_t RECEIVE_BUFFER_SIZE = 64 * 1024;
+
+    // Serial number arithmetic, survives the wrap around of the sequence number
+    bool is_newer_sequence(uint32_t sequence, uint32_t other) {
+        return static_cast<int32_t>(sequence - other) > 0;
+    }
+
+    size_t fragment_count_of(size_t packet_size) {
+        return (packet_size + DATAGRAM_MAX_PAYLOAD - 1) / DATAGRAM_MAX_PAYLOAD;
+    }
+}
+
+size_t fragment_packet(uint32_t magic_number, uint32_t sequence, const std::byte* packet, size_t size, std::vector<std::vector<std::byte>>& datagrams) {
+    const auto fragment_count = fragment_count_of(size);
+
+    if (datagrams.size() < fragment_count)
+    {
+        datagrams.resize(fragment_count);
+    }
+
+    for (size_t i = 0; i < fragment_count; i++)
+    {
+        const auto offset = i * DATAGRAM_MAX_PAYLOAD;
+        const auto payload_size = std::min(DATAGRAM_MAX_PAYLOAD, size - offset);
+
+        DatagramHeader header;
+        header.magic_number     = magic_number;
+        header.sequence         = sequence;
+        header.fragment_index   = static_cast<uint16_t>(i);
+        header.fragment_count   = static_cast<uint16_t>(fragment_count);
+        header.packet_size      = static_cast<uint32_t>(size);
+
+        auto& datagram = datagrams[i];
+        datagram.resize(sizeof(DatagramHeader) + payload_size);
+
+        memcpy(datagram.data(), &header, sizeof(DatagramHeader));
+        memcpy(datagram.data() + sizeof(DatagramHeader), packet + offset, payload_size);
+    }
+
+    return fragment_count;
+}
+
+double datagram_loss_rate(const DatagramStats& stats) {
+    const auto total = stats.packets_lost + stats.packets_delivered;
+
+    if (total == 0)
+    {
+        return 0.0;
+    }
+
+    return static_cast<double>(stats.packets_lost) / static_cast<double>(total);
+}
+
+DatagramReassembler::DatagramReassembler(uint32_t magic_number, uint32_t max_packet_size)
+    : m_magic_number(magic_number)
+    , m_max_packet_size(max_packet_size)
+    , m_slots()
+    , m_has_delivered(false)
+    , m_last_delivered(0)
+{}
+
+bool DatagramReassembler::add(const std::byte* datagram, size_t size) {
+    m_stats.datagrams_received++;
+
+    DatagramHeader header;
+
+    if (size < sizeof(DatagramHeader))
+    {
+        m_stats.invalid_datagrams++;
+
+        return false;
+    }
+
+    memcpy(&header, datagram, sizeof(DatagramHeader));
+
+    // The fragment layout is fully determined by the packet size, anything else is malformed
+    const auto payload = datagram + sizeof(DatagramHeader);
+    const auto payload_size = size - sizeof(DatagramHeader);
+    const auto offset = static_cast<size_t>(header.fragment_index) * DATAGRAM_MAX_PAYLOAD;
+
+    auto valid = header.magic_number == m_magic_number &&
+        header.packet_size > 0 &&
+        header.packet_size <= m_max_packet_size &&
+        header.fragment_count == fragment_count_of(header.packet_size) &&
+        header.fragment_index < header.fragment_count &&
+        payload_size == std::min(DATAGRAM_MAX_PAYLOAD, header.packet_size - offset);
+
+    if (!valid)
+    {
+        m_stats.invalid_datagrams++;
+
+        return false;
+    }
+
+    if (m_has_delivered && !is_newer_sequence(header.sequence, m_last_delivered))
+    {
+        m_stats.stale_datagrams++;
+
+        return false;
+    }
+
+    auto slot = find_slot(header.sequence);
+
+    if (slot == nullptr)
+    {
+        slot = claim_slot(header.sequence);
+
+        if (slot == nullptr)
+        {
+            m_stats.stale_datagrams++;
+
+            return false;
+        }
+
+        slot->received.assign(header.fragment_count, 0);
+        slot->data.resize(header.packet_size);
+    }
+    else if (slot->data.size() != header.packet_size)
+    {
+        m_stats.invalid_datagrams++;
+
+        return false;
+    }
+
+    if (slot->received[header.fragment_index] != 0)
+    {
+        m_stats.duplicate_datagrams++;
+
+        return false;
+    }
+
+    memcpy(slot->data.data() + offset, payload, payload_size);
+    slot->received[header.fragment_index] = 1;
+    slot->fragments_received++;
+
+    if (slot->fragments_received < header.fragment_count)
+    {
+        return false;
+    }
+
+    deliver(*slot);
+
+    return true;
+}
+
+const std::vector<std::byte>& DatagramReassembler::packet() const {
+    return m_packet;
+}
+
+void DatagramReassembler::reset() {
+    for (auto& slot : m_slots)
+    {
+        slot.active = false;
+    }
+
+    m_has_delivered = false;
+}
+
+const DatagramStats& DatagramReassembler::stats() const {
+    return m_stats;
+}
+
+DatagramReassembler::Slot* DatagramReassembler::find_slot(uint32_t sequence) {
+    for (auto& slot : m_slots)
+    {
+        if (slot.active && slot.sequence == sequence)
+        {
+            return &slot;
+        }
+    }
+
+    return nullptr;
+}
+
+DatagramReassembler::Slot* DatagramReassembler::claim_slot(uint32_t sequence) {
+    Slot* oldest = nullptr;
+
+    for (auto& slot : m_slots)
+    {
+        if (!slot.active)
+        {
+            oldest = &slot;
+            break;
+        }
+
+        if (oldest == nullptr || is_newer_sequence(oldest->sequence, slot.sequence))
+        {
+            oldest = &slot;
+        }
+    }
+
+    // Every slot holds a newer packet, this one is already outdated
+    if (oldest->active && !is_newer_sequence(sequence, oldest->sequence))
+    {
+        return nullptr;
+    }
+
+    // An evicted packet is never completed and shows up as a gap in the sequence
+    oldest->active = true;
+    oldest->sequence = sequence;
+    oldest->fragments_received = 0;
+
+    return oldest;
+}
+
+void DatagramReassembler::deliver(Slot& slot) {
+    if (m_has_delivered)
+    {
+        m_stats.packets_lost += slot.sequence - m_last_delivered - 1;
+    }
+
+    m_has_delivered = true;
+    m_last_delivered = slot.sequence;
+    m_stats.packets_delivered++;
+
+    // Keep the buffer of the previous packet for the next reassembly
+    m_packet.swap(slot.data);
+    slot.active = false;
+
+    // Packets older than the delivered one can never be delivered anymore
+    for (auto& other : m_slots)
+    {
+        if (other.active && !is_newer_sequence(other.sequence, m_last_delivered))
+        {
+            other.active = false;
+        }
+    }
+}
+
+DatagramLossEmulator::DatagramLossEmulator(const DatagramLossOptions& options)
+    : m_options(options)
+    , m_random(options.seed)
+    , m_distribution(0.0, 1.0)
+{}
+
+bool DatagramLossEmulator::is_enabled() const {
+    return m_options.drop_rate > 0.0 || m_options.duplicate_rate > 0.0 || m_options.reorder_rate > 0.0;
+}
+
+DatagramFate DatagramLossEmulator::next_fate() {
+    auto sample = m_distribution(m_random);
+
+    if (sample < m_options.drop_rate)
+    {
+        return DatagramFate::Drop;
+    }
+
+    sample -= m_options.drop_rate;
+
+    if (sample < m_options.duplicate_rate)
+    {
+        return DatagramFate::Duplicate;
+    }
+
+    sample -= m_options.duplicate_rate;
+
+    if (sample < m_options.reorder_rate)
+    {
+        return DatagramFate::Delay;
+    }
+
+    return DatagramFate::Deliver;
+}
+
+DatagramReceiver::DatagramReceiver(std::string_view server_addr, uint16_t server_port, uint32_t magic_number, uint32_t max_packet_size)
+    : m_server_addr(server_addr)
+    , m_server_port(server_port)
+    , m_magic_number(magic_number)
+    , m_reassembler(magic_number, max_packet_size)
+    , m_server_seen(false)
+    , m_datagram(RECEIVE_BUFFER_SIZE)
+    , m_has_delayed_datagram(false)
+    , m_emulated_drops(0)
+{}
+
+bool DatagramReceiver::open() {
+    if (!m_socket.open() || !m_socket.connect_to(m_server_addr, m_server_port))
+    {
+        m_socket.close();
+
+        return false;
+    }
+
+    // A new subscription starts a new sequence
+    m_reassembler.reset();
+    m_server_seen = false;
+    m_has_delayed_datagram = false;
+
+    return send_subscription();
+}
+
+void DatagramReceiver::close() {
+    m_socket.close();
+}
+
+bool DatagramReceiver::is_open() const {
+    return m_socket.is_open();
+}
+
+void DatagramReceiver::interrupt() {
+    m_socket.shutdown_socket();
+}
+
+ssize_t DatagramReceiver::receive_packet(SocketDeadline deadline) {
+    while (true)
+    {
+        auto received = m_socket.recv_datagram(m_datagram.data(), m_datagram.size(), deadline);
+
+        if (received == SOCKET_TIMEOUT)
+        {
+            // The subscription itself may have been lost
+            if (!m_server_seen)
+            {
+                send_subscription();
+            }
+
+            return SOCKET_TIMEOUT;
+        }
+
+        if (received <= 0)
+        {
+            return SOCKET_ERROR;
+        }
+
+        m_server_seen = true;
+
+        if (process_datagram(m_datagram.data(), static_cast<size_t>(received)))
+        {
+            return static_cast<ssize_t>(packet().size());
+        }
+    }
+}
+
+const std::vector<std::byte>& DatagramReceiver::packet() const {
+    return m_reassembler.packet();
+}
+
+void DatagramReceiver::set_loss_emulation(const DatagramLossOptions& options) {
+    m_loss_emulator = DatagramLossEmulator(options);
+}
+
+DatagramStats DatagramReceiver::stats() const {
+    auto stats = m_reassembler.stats();
+
+    stats.emulated_drops = m_emulated_drops;
+
+    return stats;
+}
+
+const SocketStats& DatagramReceiver::socket_stats() const {
+    return m_socket.stats();
+}
+
+bool DatagramReceiver::send_subscription() {
+    DatagramHeader header = {};
+    header.magic_number = m_magic_number;
+
+    return m_socket.send_datagram(reinterpret_cast<const std::byte*>(&header), sizeof(header)) == sizeof(header);
+}
+
+bool DatagramReceiver::process_datagram(const std::byte* datagram, size_t size) {
+    if (!m_loss_emulator.is_enabled())
+    {
+        return m_reassembler.add(datagram, size);
+    }
+
+    auto completed = false;
+
+    switch (m_loss_emulator.next_fate())
+    {
+        case DatagramFate::Drop:
+            m_emulated_drops++;
+
+            return false;
+
+        case DatagramFate::Duplicate:
+            completed = m_reassembler.add(datagram, size);
+            m_reassembler.add(datagram, size);
+
+            return completed;
+
+        case DatagramFate::Delay:
+            if (!m_has_delayed_datagram)
+            {
+                m_delayed_datagram.assign(datagram, datagram + size);
+                m_has_delayed_datagram = true;
+
+                return false;
+            }
+
+            // Only one datagram is held back at a time
+            [[fallthrough]];
+
+        case DatagramFate::Deliver:
+            completed = m_reassembler.add(datagram, size);
+
+            if (m_has_delayed_datagram)
+            {
+                m_has_delayed_datagram = false;
+                completed = m_reassembler.add(m_delayed_datagram.data(), m_delayed_datagram.size()) || completed;
+            }
+
+            return completed;
+    }
+
+    return completed;
+}
\ No newline at end of file
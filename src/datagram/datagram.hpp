@@ -0,0 +1,192 @@
+#pragma once
+
+#include <array>
+#include <random>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "../socket/socket.hpp"
+
+/*
+    Datagram header (16bytes)
+
+    Every complete packet (PacketHeader and body) gets a sequence number
+    and is split into fragments of at most DATAGRAM_MAX_PAYLOAD bytes, so
+    that a datagram never exceeds a typical MTU. A fragment carries the
+    bytes at fragment_index * DATAGRAM_MAX_PAYLOAD of the packet.
+
+    A header with fragment_count == 0 is a subscription sent by the client,
+    it tells the server where to send the datagrams
+*/
+struct DatagramHeader {
+    uint32_t    magic_number;
+    uint32_t    sequence;
+    uint16_t    fragment_index;
+    uint16_t    fragment_count;
+    uint32_t    packet_size;
+};
+
+static_assert(sizeof(DatagramHeader) == 16);
+
+// 1200 bytes of payload keep a datagram below the minimum IPv6 MTU including all headers
+constexpr size_t DATAGRAM_MAX_PAYLOAD   = 1200;
+constexpr size_t DATAGRAM_MAX_SIZE      = sizeof(DatagramHeader) + DATAGRAM_MAX_PAYLOAD;
+
+/*
+    Splits a complete packet into datagrams, the capacity of the
+    datagram buffers is reused. Returns the number of fragments
+*/
+size_t fragment_packet(uint32_t magic_number, uint32_t sequence, const std::byte* packet, size_t size, std::vector<std::vector<std::byte>>& datagrams);
+
+struct DatagramStats {
+    uint64_t datagrams_received     = 0;
+
+    // Wrong magic number or a fragment header that does not add up
+    uint64_t invalid_datagrams      = 0;
+    uint64_t duplicate_datagrams    = 0;
+
+    // Fragments of packets older than the newest delivered one
+    uint64_t stale_datagrams        = 0;
+
+    uint64_t packets_delivered      = 0;
+
+    // Sequence numbers skipped between two delivered packets, lost or never completed
+    uint64_t packets_lost           = 0;
+
+    // Datagrams the loss emulator dropped on purpose
+    uint64_t emulated_drops         = 0;
+};
+
+// packets_lost / (packets_lost + packets_delivered)
+double datagram_loss_rate(const DatagramStats& stats);
+
+/*
+    Reassembles packets from datagrams
+
+    Only the newest state matters, so a packet is delivered as soon as all
+    of its fragments arrived and everything older is dropped from then on.
+    A few packets can be reassembled at the same time to tolerate fragments
+    of consecutive packets arriving interleaved
+*/
+class DatagramReassembler {
+public:
+    DatagramReassembler(uint32_t magic_number, uint32_t max_packet_size);
+
+    // Returns true if the datagram completed a packet, which is then available through packet()
+    bool add(const std::byte* datagram, size_t size);
+    const std::vector<std::byte>& packet() const;
+
+    void reset();
+
+    const DatagramStats& stats() const;
+
+private:
+    struct Slot {
+        bool                    active              = false;
+        uint32_t                sequence            = 0;
+        uint32_t                fragments_received  = 0;
+        std::vector<uint8_t>    received;
+        std::vector<std::byte>  data;
+    };
+
+    Slot* find_slot(uint32_t sequence);
+    Slot* claim_slot(uint32_t sequence);
+    void deliver(Slot& slot);
+
+    uint32_t                m_magic_number;
+    uint32_t                m_max_packet_size;
+
+    std::array<Slot, 4>     m_slots;
+
+    bool                    m_has_delivered;
+    uint32_t                m_last_delivered;
+    std::vector<std::byte>  m_packet;
+
+    DatagramStats           m_stats;
+};
+
+/*
+    Loss emulator for testing over loopback, where nothing is ever lost.
+    Rates are probabilities per received datagram
+*/
+struct DatagramLossOptions {
+    double      drop_rate       = 0.0;
+    double      duplicate_rate  = 0.0;
+
+    // The datagram is held back and delivered after the next one
+    double      reorder_rate    = 0.0;
+
+    uint32_t    seed            = 1;
+};
+
+enum class DatagramFate {
+    Deliver,
+    Drop,
+    Duplicate,
+    Delay,
+};
+
+class DatagramLossEmulator {
+public:
+    DatagramLossEmulator(const DatagramLossOptions& options = DatagramLossOptions());
+
+    bool is_enabled() const;
+    DatagramFate next_fate();
+
+private:
+    DatagramLossOptions                     m_options;
+    std::mt19937                            m_random;
+    std::uniform_real_distribution<double>  m_distribution;
+};
+
+/*
+    Client side of the UDP transport
+
+    Subscribes to the server with a datagram from a connected UDP socket
+    and turns the received datagrams back into complete packets
+*/
+class DatagramReceiver {
+public:
+    DatagramReceiver(std::string_view server_addr, uint16_t server_port, uint32_t magic_number, uint32_t max_packet_size);
+
+    bool open();
+    void close();
+    bool is_open() const;
+
+    // Wakes up a receive that is waiting on another thread
+    void interrupt();
+
+    /*
+        Receives datagrams until a packet is complete and returns its size,
+        or SOCKET_TIMEOUT once the deadline has passed. The packet stays
+        available through packet() until the next call
+    */
+    ssize_t receive_packet(SocketDeadline deadline);
+    const std::vector<std::byte>& packet() const;
+
+    void set_loss_emulation(const DatagramLossOptions& options);
+
+    DatagramStats stats() const;
+    const SocketStats& socket_stats() const;
+
+private:
+    bool send_subscription();
+    bool process_datagram(const std::byte* datagram, size_t size);
+
+    std::string_view        m_server_addr;
+    uint16_t                m_server_port;
+    uint32_t                m_magic_number;
+
+    DatagramSocket          m_socket;
+    DatagramReassembler     m_reassembler;
+
+    // The subscription is repeated until the first datagram arrives
+    bool                    m_server_seen;
+
+    std::vector<std::byte>  m_datagram;
+
+    DatagramLossEmulator    m_loss_emulator;
+    std::vector<std::byte>  m_delayed_datagram;
+    bool                    m_has_delayed_datagram;
+    uint64_t                m_emulated_drops;
+};
\ No newline at end of file
@@ -0,0 +1,156 @@
+#include <cstring>
+#include "frame_batch.hpp"
+#include "frame_serializer.hpp"
+
+namespace {
+    constexpr size_t OFFSET_SIZE = sizeof(uint32_t);
+
+    void append_u32(std::vector<std::byte>& bytes, uint32_t value) {
+        auto value_bytes = reinterpret_cast<const std::byte*>(&value);
+        bytes.insert(bytes.end(), value_bytes, value_bytes + sizeof(value));
+    }
+
+    uint32_t read_u32(const std::byte* bytes) {
+        uint32_t value;
+        memcpy(&value, bytes, sizeof(value));
+
+        return value;
+    }
+
+    size_t batch_body_size(size_t frame_count, size_t frames_size) {
+        return sizeof(uint32_t) + (frame_count + 1) * OFFSET_SIZE + frames_size;
+    }
+}
+
+FrameBatchView::FrameBatchView(const std::byte* offsets, const std::byte* frames, uint32_t frame_count)
+    : m_offsets(offsets)
+    , m_frames(frames)
+    , m_frame_count(frame_count)
+{}
+
+uint32_t FrameBatchView::size() const {
+    return m_frame_count;
+}
+
+std::optional<FrameView> FrameBatchView::frame(uint32_t index) const {
+    if (index >= m_frame_count)
+    {
+        return std::nullopt;
+    }
+
+    const auto begin = offset(index);
+
+    return parse_frame_view(m_frames + begin, offset(index + 1) - begin);
+}
+
+uint32_t FrameBatchView::offset(uint32_t index) const {
+    return read_u32(m_offsets + index * OFFSET_SIZE);
+}
+
+std::optional<FrameBatchView> parse_frame_batch(const std::byte* bytes, size_t size) {
+    if (size < sizeof(uint32_t))
+    {
+        return std::nullopt;
+    }
+
+    const auto frame_count = read_u32(bytes);
+    const auto max_offset_count = (size - sizeof(uint32_t)) / OFFSET_SIZE;
+
+    // Checked before the table size is computed, so it cannot overflow
+    if (frame_count == 0 || frame_count >= max_offset_count)
+    {
+        return std::nullopt;
+    }
+
+    const auto offsets = bytes + sizeof(uint32_t);
+    const auto frames = offsets + (static_cast<size_t>(frame_count) + 1) * OFFSET_SIZE;
+    const auto frames_size = static_cast<size_t>(bytes + size - frames);
+
+    // Frames must follow each other and stay inside the body
+    uint32_t previous = 0;
+
+    for (uint32_t i = 0; i <= frame_count; i++)
+    {
+        const auto offset = read_u32(offsets + i * OFFSET_SIZE);
+
+        if (offset < previous || offset > frames_size)
+        {
+            return std::nullopt;
+        }
+
+        previous = offset;
+    }
+
+    return FrameBatchView(offsets, frames, frame_count);
+}
+
+FrameBatchWriter::FrameBatchWriter(uint32_t max_frames, size_t max_body_size)
+    : m_max_frames(max_frames)
+    , m_max_body_size(max_body_size)
+    , m_offsets(1, 0)
+{}
+
+bool FrameBatchWriter::add(const Frame& frame) {
+    if (size() >= m_max_frames)
+    {
+        return false;
+    }
+
+    // A frame too large for any batch is still taken alone, it is flushed as a plain Frame packet
+    if (!empty() && batch_body_size(size() + 1, m_frames.size() + serialized_frame_size(frame)) > m_max_body_size)
+    {
+        return false;
+    }
+
+    if (!append_serialized_frame(frame, m_frames))
+    {
+        return false;
+    }
+
+    m_offsets.push_back(static_cast<uint32_t>(m_frames.size()));
+
+    return true;
+}
+
+bool FrameBatchWriter::empty() const {
+    return size() == 0;
+}
+
+uint32_t FrameBatchWriter::size() const {
+    return static_cast<uint32_t>(m_offsets.size() - 1);
+}
+
+bool FrameBatchWriter::flush(std::vector<std::byte>& bytes, uint32_t magic_number, FrameCompressor& compressor) {
+    if (empty())
+    {
+        return true;
+    }
+
+    auto succeed = false;
+
+    if (size() == 1)
+    {
+        succeed = compressor.append_packet(bytes, magic_number, PacketType::Frame, m_frames.data(), m_frames.size());
+    }
+    else
+    {
+        m_body.clear();
+        m_body.reserve(batch_body_size(size(), m_frames.size()));
+
+        append_u32(m_body, size());
+
+        for (auto offset : m_offsets)
+        {
+            append_u32(m_body, offset);
+        }
+
+        m_body.insert(m_body.end(), m_frames.begin(), m_frames.end());
+
+        succeed = compressor.append_packet(bytes, magic_number, PacketType::FrameBatch, m_body.data(), m_body.size());
+    }
+
+    m_frames.clear();
+    m_offsets.resize(1);
+
+    return succeed;
+}
\ No newline at end of file
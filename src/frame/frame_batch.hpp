@@ -0,0 +1,85 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include "frame_template.hpp"
+#include "frame_view.hpp"
+#include "frame_compression.hpp"
+
+/*
+    Frame batch body (PacketType::FrameBatch)
+
+    [4bytes]    Number of frames (n)
+    [4bytes]    Offset of every frame plus the end of the last one, (n + 1) in total
+    Then the frames, each serialized like the body of a PacketType::Frame packet
+
+    Offsets count from the first frame, so frame i spans offsets[i] to
+    offsets[i + 1]. A batch shares one packet header, checksum and
+    compressed block among all of its frames, which is most of the cost
+    of sending small frames (menus, StageState::Intro) one by one
+*/
+
+// Oldest protocol version that understands batches, see Hello
+constexpr uint16_t FRAME_BATCH_PROTOCOL_VERSION = 2;
+
+constexpr uint32_t DEFAULT_MAX_FRAME_BATCH_SIZE = 16;
+
+/*
+    Client side. Only the offset table is validated by parse_frame_batch,
+    each frame is validated when it is taken with frame()
+*/
+class FrameBatchView {
+public:
+    FrameBatchView(const std::byte* offsets, const std::byte* frames, uint32_t frame_count);
+
+    uint32_t size() const;
+
+    // std::nullopt if the frame is malformed, the view points into the batch body
+    std::optional<FrameView> frame(uint32_t index) const;
+
+private:
+    uint32_t offset(uint32_t index) const;
+
+    const std::byte*    m_offsets;
+    const std::byte*    m_frames;
+    uint32_t            m_frame_count;
+};
+
+std::optional<FrameBatchView> parse_frame_batch(const std::byte* bytes, size_t size);
+
+/*
+    Server side. Collects the frames that become ready within one send
+    window and writes them as a single packet. The buffers are reused,
+    so a warmed up writer does not allocate
+*/
+class FrameBatchWriter {
+public:
+    FrameBatchWriter(uint32_t max_frames = DEFAULT_MAX_FRAME_BATCH_SIZE, size_t max_body_size = PACKET_BODY_SIZE_MASK);
+
+    /*
+        Returns false if the frame is invalid or would make the batch
+        exceed one of its limits, flush() and add it again in that case
+    */
+    bool add(const Frame& frame);
+
+    bool empty() const;
+    uint32_t size() const;
+
+    /*
+        Appends the collected frames as one packet and starts a new batch.
+        A single frame goes out as a plain PacketType::Frame packet.
+        Returns false if the packet was too large to send, the frames are
+        dropped either way
+    */
+    bool flush(std::vector<std::byte>& bytes, uint32_t magic_number, FrameCompressor& compressor);
+
+private:
+    uint32_t                m_max_frames;
+    size_t                  m_max_body_size;
+
+    std::vector<uint32_t>   m_offsets;
+    std::vector<std::byte>  m_frames;
+    std::vector<std::byte>  m_body;
+};
\ No newline at end of file
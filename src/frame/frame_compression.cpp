@@ -0,0 +1,209 @@
+#include <chrono>
+#include <algorithm>
+#include <cstring>
+#include "frame_compression.hpp"
+#include "frame_view.hpp"
+#include "frame_serializer.hpp"
+#include "frame_layout.hpp"
+#include "../compression/compression.hpp"
+
+namespace {
+    using CodecClock = std::chrono::steady_clock;
+
+    constexpr size_t RAW_SIZE_PREFIX = sizeof(uint32_t);
+
+    uint64_t elapsed_ns_since(CodecClock::time_point start) {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(CodecClock::now() - start).count());
+    }
+
+    template <typename T>
+    void shuffle_array(const PackedArrayView<T>& objects, const std::byte* body, std::byte* dst_body) {
+        const auto offset = static_cast<size_t>(objects.data() - body);
+
+        shuffle_bytes(objects.data(), objects.size(), sizeof(T), dst_body + offset);
+    }
+
+    template <typename T>
+    void unshuffle_array(const PackedArrayView<T>& objects, std::byte* body, std::vector<std::byte>& scratch) {
+        const auto offset = static_cast<size_t>(objects.data() - body);
+
+        scratch.assign(objects.data(), objects.data() + objects.size_bytes());
+        unshuffle_bytes(scratch.data(), objects.size(), sizeof(T), body + offset);
+    }
+}
+
+double compression_ratio(const FrameCompressionStats& stats) {
+    if (stats.compressed_bytes == 0)
+    {
+        return 0.0;
+    }
+
+    return static_cast<double>(stats.raw_bytes) / static_cast<double>(stats.compressed_bytes);
+}
+
+double compression_throughput(const FrameCompressionStats& stats) {
+    if (stats.elapsed_ns == 0)
+    {
+        return 0.0;
+    }
+
+    return (static_cast<double>(stats.raw_bytes) / (1024.0 * 1024.0)) / (static_cast<double>(stats.elapsed_ns) * 1e-9);
+}
+
+FrameCompressor::FrameCompressor(FrameCompression compression)
+    : m_compression(compression)
+    , m_checksum_enabled(false)
+{}
+
+bool FrameCompressor::append_packet(std::vector<std::byte>& bytes, uint32_t magic_number, PacketType packet_type, const std::byte* body, size_t body_size) {
+    uint8_t packet_flags = 0;
+
+    if (m_compression != FrameCompression::None && compress(packet_type, body, body_size, packet_flags))
+    {
+        body = m_compressed.data();
+        body_size = m_compressed.size();
+    }
+
+    // The checksum covers the body as sent, so corruption is caught before decompression
+    if (m_checksum_enabled)
+    {
+        packet_flags |= static_cast<uint8_t>(PacketFlag::Checksummed);
+    }
+
+    return ::append_packet(bytes, magic_number, packet_type, body, body_size, packet_flags);
+}
+
+bool FrameCompressor::append_frame_packet(std::vector<std::byte>& bytes, uint32_t magic_number, const Frame& frame) {
+    m_serialized.clear();
+
+    if (!append_serialized_frame(frame, m_serialized))
+    {
+        return false;
+    }
+
+    return append_packet(bytes, magic_number, PacketType::Frame, m_serialized.data(), m_serialized.size());
+}
+
+void FrameCompressor::set_checksum_enabled(bool enabled) {
+    m_checksum_enabled = enabled;
+}
+
+const FrameCompressionStats& FrameCompressor::stats() const {
+    return m_stats;
+}
+
+bool FrameCompressor::compress(PacketType packet_type, const std::byte* body, size_t body_size, uint8_t& packet_flags) {
+    const auto start = CodecClock::now();
+    const auto raw_size = static_cast<uint32_t>(body_size);
+
+    auto source = body;
+    packet_flags = static_cast<uint8_t>(PacketFlag::Compressed);
+
+    // Only full frames have the object array layout the filter relies on
+    if (m_compression == FrameCompression::ShuffledLz && packet_type == PacketType::Frame)
+    {
+        if (auto frame_view_opt = parse_frame_view(body, body_size))
+        {
+            m_shuffled.assign(body, body + body_size);
+
+            for_each_descriptor(FRAME_ARRAYS, [&](const auto& array) {
+                shuffle_array(frame_view_opt.value().*array.view, body, m_shuffled.data());
+            });
+
+            source = m_shuffled.data();
+            packet_flags |= static_cast<uint8_t>(PacketFlag::Shuffled);
+        }
+    }
+
+    m_compressed.resize(RAW_SIZE_PREFIX + lz_compress_bound(body_size));
+    memcpy(m_compressed.data(), &raw_size, RAW_SIZE_PREFIX);
+
+    // Anything that does not end up smaller is sent uncompressed
+    auto compressed_size = lz_compress(source, body_size, m_compressed.data() + RAW_SIZE_PREFIX, body_size - std::min(body_size, RAW_SIZE_PREFIX));
+    auto succeed = compressed_size > 0;
+
+    m_stats.packets++;
+    m_stats.raw_bytes += body_size;
+
+    if (succeed)
+    {
+        m_compressed.resize(RAW_SIZE_PREFIX + compressed_size);
+        m_stats.compressed_bytes += m_compressed.size();
+    }
+    else
+    {
+        m_stats.incompressible_packets++;
+        m_stats.compressed_bytes += body_size;
+        packet_flags = 0;
+    }
+
+    m_stats.elapsed_ns += elapsed_ns_since(start);
+
+    return succeed;
+}
+
+FrameDecompressor::FrameDecompressor(uint32_t max_body_size)
+    : m_max_body_size(max_body_size)
+{}
+
+bool FrameDecompressor::decompress(const std::byte* data, size_t size, uint8_t packet_flags) {
+    const auto start = CodecClock::now();
+    uint32_t raw_size = 0;
+
+    if (size < RAW_SIZE_PREFIX)
+    {
+        return false;
+    }
+
+    memcpy(&raw_size, data, RAW_SIZE_PREFIX);
+
+    if (raw_size == 0 || raw_size > m_max_body_size)
+    {
+        return false;
+    }
+
+    m_body.resize(raw_size);
+
+    auto decompressed_size = lz_decompress(data + RAW_SIZE_PREFIX, size - RAW_SIZE_PREFIX, m_body.data(), m_body.size());
+
+    if (!decompressed_size || decompressed_size.value() != raw_size)
+    {
+        return false;
+    }
+
+    if (has_packet_flag(packet_flags, PacketFlag::Shuffled) && !unshuffle_frame())
+    {
+        return false;
+    }
+
+    m_stats.packets++;
+    m_stats.raw_bytes += raw_size;
+    m_stats.compressed_bytes += size;
+    m_stats.elapsed_ns += elapsed_ns_since(start);
+
+    return true;
+}
+
+const std::vector<std::byte>& FrameDecompressor::body() const {
+    return m_body;
+}
+
+const FrameCompressionStats& FrameDecompressor::stats() const {
+    return m_stats;
+}
+
+bool FrameDecompressor::unshuffle_frame() {
+    // The counts are not shuffled, so the layout of the shuffled frame is already valid
+    auto frame_view_opt = parse_frame_view(m_body.data(), m_body.size());
+
+    if (!frame_view_opt)
+    {
+        return false;
+    }
+
+    for_each_descriptor(FRAME_ARRAYS, [&](const auto& array) {
+        unshuffle_array(frame_view_opt.value().*array.view, m_body.data(), m_scratch);
+    });
+
+    return true;
+}
\ No newline at end of file
@@ -0,0 +1,104 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "frame_template.hpp"
+
+/*
+    Compressed packet body (PacketFlag::Compressed)
+
+    [4bytes]    Size of the uncompressed body
+    [N bytes]   LZ block, see compression.hpp
+
+    With PacketFlag::Shuffled the uncompressed body is a frame whose object
+    arrays were byte-shuffled before compression. The counts in front of
+    the arrays are left as they are, so the layout can be parsed as usual
+    before the arrays are unshuffled
+*/
+
+enum class FrameCompression {
+    None,
+    Lz,
+    ShuffledLz,     // Byte-shuffles the object arrays of full frames before the LZ pass
+};
+
+/*
+    Throughput of either side of the codec, compression_ratio() and
+    compression_throughput() summarize it so a deployment can decide
+    whether CPU or bandwidth is the cheaper resource
+*/
+struct FrameCompressionStats {
+    uint64_t packets                = 0;
+
+    // Packets sent as they are because compression did not make them smaller
+    uint64_t incompressible_packets = 0;
+
+    uint64_t raw_bytes              = 0;
+    uint64_t compressed_bytes       = 0;
+
+    // Time spent in the codec, including the shuffle filter
+    uint64_t elapsed_ns             = 0;
+};
+
+// raw_bytes / compressed_bytes
+double compression_ratio(const FrameCompressionStats& stats);
+
+// Uncompressed megabytes processed per second of codec time
+double compression_throughput(const FrameCompressionStats& stats);
+
+class FrameCompressor {
+public:
+    FrameCompressor(FrameCompression compression);
+
+    /*
+        Appends the body as a complete packet. The body is compressed if
+        that makes it smaller, otherwise it is sent as it is.
+        Fails if the packet is too large, see ::append_packet()
+    */
+    bool append_packet(std::vector<std::byte>& bytes, uint32_t magic_number, PacketType packet_type, const std::byte* body, size_t body_size);
+
+    // Serializes the frame into a reused buffer and appends it as a PacketType::Frame packet
+    bool append_frame_packet(std::vector<std::byte>& bytes, uint32_t magic_number, const Frame& frame);
+
+    // Adds a PacketChecksum to every packet
+    void set_checksum_enabled(bool enabled);
+
+    const FrameCompressionStats& stats() const;
+
+private:
+    bool compress(PacketType packet_type, const std::byte* body, size_t body_size, uint8_t& packet_flags);
+
+    FrameCompression        m_compression;
+    bool                    m_checksum_enabled;
+
+    std::vector<std::byte>  m_serialized;
+    std::vector<std::byte>  m_shuffled;
+    std::vector<std::byte>  m_compressed;
+
+    FrameCompressionStats   m_stats;
+};
+
+class FrameDecompressor {
+public:
+    FrameDecompressor(uint32_t max_body_size);
+
+    /*
+        Restores the body of a packet carrying PacketFlag::Compressed,
+        the result is available through body() until the next call
+    */
+    bool decompress(const std::byte* data, size_t size, uint8_t packet_flags);
+    const std::vector<std::byte>& body() const;
+
+    const FrameCompressionStats& stats() const;
+
+private:
+    bool unshuffle_frame();
+
+    uint32_t                m_max_body_size;
+
+    std::vector<std::byte>  m_body;
+    std::vector<std::byte>  m_scratch;
+
+    FrameCompressionStats   m_stats;
+};
\ No newline at end of file
@@ -0,0 +1,509 @@
+#include <limits>
+#include <cstring>
+#include "frame_delta.hpp"
+#include "frame_serializer.hpp"
+#include "frame_layout.hpp"
+
+namespace {
+    constexpr size_t    WORD_SIZE       = 4;
+    constexpr uint32_t  NOT_IN_BASELINE = std::numeric_limits<uint32_t>::max();
+
+    template <typename T>
+    constexpr size_t word_count() {
+        static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable");
+        static_assert(sizeof(T) % WORD_SIZE == 0, "Objects must be a multiple of 4 bytes");
+        static_assert(sizeof(T) / WORD_SIZE <= 16, "The word mask is 16 bits wide");
+
+        return sizeof(T) / WORD_SIZE;
+    }
+
+    template <typename T>
+    uint32_t object_id(const T& object) {
+        return static_cast<uint32_t>(object.id);
+    }
+
+    template <typename T>
+    void append_t(std::vector<std::byte>& bytes, const T& value) {
+        auto value_bytes = reinterpret_cast<const std::byte*>(&value);
+        bytes.insert(bytes.end(), value_bytes, value_bytes + sizeof(T));
+    }
+
+    template <typename T>
+    bool read_t(T* dest, const std::byte*& offset, const std::byte* end) {
+        if (static_cast<size_t>(end - offset) < sizeof(T))
+        {
+            return false;
+        }
+
+        memcpy(dest, offset, sizeof(T));
+        offset += sizeof(T);
+
+        return true;
+    }
+
+    template <typename T>
+    uint16_t changed_words(const T& baseline, const T& current) {
+        auto baseline_bytes = reinterpret_cast<const std::byte*>(&baseline);
+        auto current_bytes = reinterpret_cast<const std::byte*>(&current);
+        uint16_t word_mask = 0;
+
+        for (size_t word = 0; word < word_count<T>(); word++)
+        {
+            if (memcmp(baseline_bytes + word * WORD_SIZE, current_bytes + word * WORD_SIZE, WORD_SIZE) != 0)
+            {
+                word_mask |= static_cast<uint16_t>(1u << word);
+            }
+        }
+
+        return word_mask;
+    }
+
+    // Returns false if the ids are not unique, in which case no delta can be encoded
+    template <typename T>
+    bool encode_objects(
+        const std::vector<T>& baseline,
+        const std::vector<T>& current,
+        std::vector<std::byte>& body,
+        FrameDeltaScratch& scratch)
+    {
+        auto& index_by_id = scratch.index_by_id;
+        auto& seen = scratch.flags;
+
+        index_by_id.reset(baseline.size() + current.size());
+        seen.assign(baseline.size(), 0);
+        scratch.spawned.clear();
+        scratch.changed.clear();
+
+        for (uint32_t i = 0; i < baseline.size(); i++)
+        {
+            bool inserted = false;
+            index_by_id.insert(object_id(baseline[i]), i, inserted);
+
+            if (!inserted)
+            {
+                return false;
+            }
+        }
+
+        for (uint32_t i = 0; i < current.size(); i++)
+        {
+            bool inserted = false;
+            const auto baseline_index = *index_by_id.insert(object_id(current[i]), NOT_IN_BASELINE, inserted);
+
+            if (inserted)
+            {
+                scratch.spawned.push_back(i);
+
+                continue;
+            }
+
+            // Either spawned twice or matched twice
+            if (baseline_index == NOT_IN_BASELINE || seen[baseline_index] != 0)
+            {
+                return false;
+            }
+
+            seen[baseline_index] = 1;
+
+            if (changed_words(baseline[baseline_index], current[i]) != 0)
+            {
+                // Pairs of (current index, baseline index)
+                scratch.changed.push_back(i);
+                scratch.changed.push_back(baseline_index);
+            }
+        }
+
+        // Despawned objects
+        uint32_t despawned_count = 0;
+
+        for (auto flag : seen)
+        {
+            despawned_count += flag == 0 ? 1 : 0;
+        }
+
+        append_t(body, despawned_count);
+
+        for (uint32_t i = 0; i < baseline.size(); i++)
+        {
+            if (seen[i] == 0)
+            {
+                append_t(body, object_id(baseline[i]));
+            }
+        }
+
+        // Spawned objects
+        append_t(body, static_cast<uint32_t>(scratch.spawned.size()));
+
+        for (auto index : scratch.spawned)
+        {
+            append_t(body, current[index]);
+        }
+
+        // Changed objects
+        append_t(body, static_cast<uint32_t>(scratch.changed.size() / 2));
+
+        for (size_t i = 0; i < scratch.changed.size(); i += 2)
+        {
+            const auto& object = current[scratch.changed[i]];
+            const auto word_mask = changed_words(baseline[scratch.changed[i + 1]], object);
+            auto object_bytes = reinterpret_cast<const std::byte*>(&object);
+
+            append_t(body, object_id(object));
+            append_t(body, word_mask);
+
+            for (size_t word = 0; word < word_count<T>(); word++)
+            {
+                if (word_mask & (1u << word))
+                {
+                    body.insert(body.end(), object_bytes + word * WORD_SIZE, object_bytes + (word + 1) * WORD_SIZE);
+                }
+            }
+        }
+
+        return true;
+    }
+
+    template <typename T>
+    bool apply_objects(
+        const std::vector<T>& baseline,
+        std::vector<T>& objects,
+        const std::byte*& offset,
+        const std::byte* end,
+        FrameDeltaScratch& scratch)
+    {
+        auto& index_by_id = scratch.index_by_id;
+        auto& removed = scratch.flags;
+
+        objects.assign(baseline.begin(), baseline.end());
+        index_by_id.reset(objects.size());
+        removed.assign(objects.size(), 0);
+
+        for (uint32_t i = 0; i < objects.size(); i++)
+        {
+            bool inserted = false;
+            index_by_id.insert(object_id(objects[i]), i, inserted);
+        }
+
+        // Despawned objects
+        uint32_t despawned_count = 0;
+
+        if (!read_t(&despawned_count, offset, end))
+        {
+            return false;
+        }
+
+        for (uint32_t i = 0; i < despawned_count; i++)
+        {
+            uint32_t id = 0;
+
+            if (!read_t(&id, offset, end))
+            {
+                return false;
+            }
+
+            auto index = index_by_id.find(id);
+
+            if (index == nullptr)
+            {
+                return false;
+            }
+
+            removed[*index] = 1;
+        }
+
+        // Spawned objects are appended after the baseline has been compacted
+        uint32_t spawned_count = 0;
+
+        if (!read_t(&spawned_count, offset, end) ||
+            static_cast<size_t>(end - offset) / sizeof(T) < spawned_count)
+        {
+            return false;
+        }
+
+        PackedArrayView<T> spawned(offset, spawned_count);
+        offset += spawned.size_bytes();
+
+        // Changed objects
+        uint32_t changed_count = 0;
+
+        if (!read_t(&changed_count, offset, end))
+        {
+            return false;
+        }
+
+        for (uint32_t i = 0; i < changed_count; i++)
+        {
+            uint32_t id = 0;
+            uint16_t word_mask = 0;
+
+            if (!read_t(&id, offset, end) || !read_t(&word_mask, offset, end))
+            {
+                return false;
+            }
+
+            auto index = index_by_id.find(id);
+
+            if (index == nullptr || (word_mask >> word_count<T>()) != 0)
+            {
+                return false;
+            }
+
+            auto object_bytes = reinterpret_cast<std::byte*>(&objects[*index]);
+
+            for (size_t word = 0; word < word_count<T>(); word++)
+            {
+                if ((word_mask & (1u << word)) == 0)
+                {
+                    continue;
+                }
+
+                if (static_cast<size_t>(end - offset) < WORD_SIZE)
+                {
+                    return false;
+                }
+
+                memcpy(object_bytes + word * WORD_SIZE, offset, WORD_SIZE);
+                offset += WORD_SIZE;
+            }
+        }
+
+        // Remove despawned objects while keeping the order
+        size_t kept = 0;
+
+        for (size_t i = 0; i < objects.size(); i++)
+        {
+            if (removed[i] == 0)
+            {
+                objects[kept++] = objects[i];
+            }
+        }
+
+        objects.resize(kept);
+
+        for (auto object : spawned)
+        {
+            objects.push_back(object);
+        }
+
+        return true;
+    }
+
+    void write_fixed_header(const Frame& frame, std::vector<std::byte>& body) {
+        append_t(body, make_fixed_header(frame));
+        append_t(body, frame.stage);
+    }
+}
+
+void FrameIdIndex::reset(size_t max_entries) {
+    // Keep the load factor at or below one half
+    size_t capacity = 16;
+
+    while (capacity < max_entries * 2)
+    {
+        capacity *= 2;
+    }
+
+    m_ids.resize(capacity);
+    m_indices.resize(capacity);
+    m_used.assign(capacity, 0);
+    m_mask = capacity - 1;
+}
+
+uint32_t* FrameIdIndex::insert(uint32_t id, uint32_t index, bool& inserted) {
+    auto slot = slot_of(id);
+
+    while (m_used[slot] != 0)
+    {
+        if (m_ids[slot] == id)
+        {
+            inserted = false;
+
+            return &m_indices[slot];
+        }
+
+        slot = (slot + 1) & m_mask;
+    }
+
+    m_used[slot] = 1;
+    m_ids[slot] = id;
+    m_indices[slot] = index;
+    inserted = true;
+
+    return &m_indices[slot];
+}
+
+const uint32_t* FrameIdIndex::find(uint32_t id) const {
+    if (m_used.empty())
+    {
+        return nullptr;
+    }
+
+    for (auto slot = slot_of(id); m_used[slot] != 0; slot = (slot + 1) & m_mask)
+    {
+        if (m_ids[slot] == id)
+        {
+            return &m_indices[slot];
+        }
+    }
+
+    return nullptr;
+}
+
+size_t FrameIdIndex::slot_of(uint32_t id) const {
+    return static_cast<size_t>(id * 2654435761u) & m_mask;
+}
+
+FrameDeltaEncoder::FrameDeltaEncoder(uint32_t keyframe_interval, size_t history_size)
+    : m_keyframe_interval(keyframe_interval)
+    , m_history_size(history_size)
+    , m_baseline()
+    , m_has_baseline(false)
+    , m_frames_since_keyframe(0)
+    , m_keyframe_requested(false)
+{}
+
+PacketType FrameDeltaEncoder::encode(const Frame& frame, std::vector<std::byte>& body) {
+    auto packet_type = PacketType::Frame;
+
+    auto keyframe_due = !m_has_baseline || m_keyframe_requested ||
+        m_frames_since_keyframe >= m_keyframe_interval;
+
+    // A delta is only worth sending if it is smaller than the full frame
+    if (!keyframe_due && encode_delta(frame, body) && body.size() < serialized_frame_size(frame))
+    {
+        packet_type = PacketType::FrameDelta;
+        m_frames_since_keyframe++;
+    }
+    else
+    {
+        body = serialize_frame(frame).value_or(std::vector<std::byte>());
+
+        m_frames_since_keyframe = 0;
+        m_keyframe_requested = false;
+    }
+
+    // Remember the frame so it can become the baseline once acknowledged
+    if (m_history.size() >= m_history_size)
+    {
+        auto recycled = std::move(m_history.front());
+        m_history.pop_front();
+
+        recycled = frame;
+        m_history.push_back(std::move(recycled));
+    }
+    else
+    {
+        m_history.push_back(frame);
+    }
+
+    return packet_type;
+}
+
+void FrameDeltaEncoder::acknowledge(const FrameAck& frame_ack) {
+    if (frame_ack.flags & static_cast<uint32_t>(FrameAckFlag::KeyframeRequest))
+    {
+        request_keyframe();
+    }
+
+    for (const auto& frame : m_history)
+    {
+        if (frame.timestamp == frame_ack.timestamp)
+        {
+            m_baseline = frame;
+            m_has_baseline = true;
+
+            return;
+        }
+    }
+}
+
+void FrameDeltaEncoder::request_keyframe() {
+    m_keyframe_requested = true;
+}
+
+bool FrameDeltaEncoder::encode_delta(const Frame& frame, std::vector<std::byte>& body) {
+    body.clear();
+
+    append_t(body, m_baseline.timestamp);
+    write_fixed_header(frame, body);
+
+    return all_descriptors(FRAME_ARRAYS, [&](const auto& array) {
+        return encode_objects(m_baseline.*array.objects, frame.*array.objects, body, m_scratch);
+    });
+}
+
+FrameDeltaDecoder::FrameDeltaDecoder(size_t history_size)
+    : m_history(history_size)
+    , m_valid(history_size, false)
+    , m_next_slot(0)
+{}
+
+void FrameDeltaDecoder::store_baseline(const FrameView& frame_view) {
+    frame_view_to_frame(frame_view, next_slot());
+}
+
+void FrameDeltaDecoder::clear() {
+    m_valid.assign(m_valid.size(), false);
+}
+
+FrameDeltaResult FrameDeltaDecoder::apply(const std::byte* body, size_t size, Frame& frame) {
+    auto bytes_offset = body;
+    const auto bytes_end = body + size;
+
+    uint32_t baseline_timestamp = 0;
+    FrameFixedHeader header;
+
+    auto succeed = read_t(&baseline_timestamp, bytes_offset, bytes_end) &&
+        read_t(&header, bytes_offset, bytes_end) &&
+        read_t(&frame.stage, bytes_offset, bytes_end);
+
+    if (!succeed)
+    {
+        return FrameDeltaResult::Malformed;
+    }
+
+    const auto baseline = find_baseline(baseline_timestamp);
+
+    if (baseline == nullptr)
+    {
+        return FrameDeltaResult::UnknownBaseline;
+    }
+
+    read_fixed_header(header, frame);
+
+    succeed = all_descriptors(FRAME_ARRAYS, [&](const auto& array) {
+        return apply_objects(baseline->*array.objects, frame.*array.objects, bytes_offset, bytes_end, m_scratch);
+    });
+
+    if (!succeed)
+    {
+        return FrameDeltaResult::Malformed;
+    }
+
+    for_each_descriptor(FRAME_ARRAYS, [&](const auto& array) {
+        frame.*array.count = static_cast<uint32_t>((frame.*array.objects).size());
+    });
+
+    return FrameDeltaResult::Ok;
+}
+
+Frame& FrameDeltaDecoder::next_slot() {
+    auto& slot = m_history[m_next_slot];
+
+    m_valid[m_next_slot] = true;
+    m_next_slot = (m_next_slot + 1) % m_history.size();
+
+    return slot;
+}
+
+const Frame* FrameDeltaDecoder::find_baseline(uint32_t timestamp) const {
+    for (size_t i = 0; i < m_history.size(); i++)
+    {
+        if (m_valid[i] && m_history[i].timestamp == timestamp)
+        {
+            return &m_history[i];
+        }
+    }
+
+    return nullptr;
+}
\ No newline at end of file
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "frame_template.hpp"
+#include "frame_view.hpp"
+
+/*
+    Delta frame body (PacketType::FrameDelta)
+
+    [4bytes]    Timestamp of the baseline frame the delta is encoded against
+    [16bytes]   Fixed header of the frame
+    [8bytes]    Stage object
+
+    Then for players, enemies, bosses, bullets and items in this order:
+
+    [4bytes]    Number of despawned objects, followed by their ids (4bytes each)
+    [4bytes]    Number of spawned objects, followed by the full objects
+    [4bytes]    Number of changed objects, each one encoded as
+                id (4bytes), word mask (2bytes) and the changed 4 byte words
+
+    Objects are matched by id. Every object is a multiple of 4 bytes, so a
+    changed object only carries the words whose bit is set in its mask.
+    The reconstructed arrays keep the baseline order, spawned objects are
+    appended at the end
+*/
+
+constexpr uint32_t DEFAULT_KEYFRAME_INTERVAL = 120;
+
+/*
+    Open addressing map from object id to array index. Unlike a node based
+    map it is reset without freeing anything, so matching objects does not
+    allocate once the table has grown to the largest array seen
+*/
+class FrameIdIndex {
+public:
+    // Empties the table and makes room for max_entries ids
+    void reset(size_t max_entries);
+
+    // Returns the index stored for the id, which is only set to index if the id was new
+    uint32_t* insert(uint32_t id, uint32_t index, bool& inserted);
+    const uint32_t* find(uint32_t id) const;
+
+private:
+    size_t slot_of(uint32_t id) const;
+
+    std::vector<uint32_t>   m_ids;
+    std::vector<uint32_t>   m_indices;
+    std::vector<uint8_t>    m_used;
+    size_t                  m_mask = 0;
+};
+
+// Scratch buffers shared by the encoder and the decoder to avoid reallocation
+struct FrameDeltaScratch {
+    FrameIdIndex                            index_by_id;
+    std::vector<uint8_t>                    flags;
+    std::vector<uint32_t>                   spawned;
+    std::vector<uint32_t>                   changed;
+};
+
+/*
+    Server side, decides between keyframes and deltas and keeps the
+    history of sent frames that the client can acknowledge
+*/
+class FrameDeltaEncoder {
+public:
+    FrameDeltaEncoder(uint32_t keyframe_interval = DEFAULT_KEYFRAME_INTERVAL, size_t history_size = 32);
+
+    // Writes the body to send for this frame and returns its packet type
+    PacketType encode(const Frame& frame, std::vector<std::byte>& body);
+
+    void acknowledge(const FrameAck& frame_ack);
+    void request_keyframe();
+
+private:
+    bool encode_delta(const Frame& frame, std::vector<std::byte>& body);
+
+    uint32_t                m_keyframe_interval;
+    size_t                  m_history_size;
+    std::deque<Frame>       m_history;
+
+    Frame                   m_baseline;
+    bool                    m_has_baseline;
+
+    uint32_t                m_frames_since_keyframe;
+    bool                    m_keyframe_requested;
+
+    FrameDeltaScratch       m_scratch;
+};
+
+enum class FrameDeltaResult {
+    Ok,
+    UnknownBaseline,    // The baseline is not (or no longer) stored, a keyframe is needed
+    Malformed,
+};
+
+/*
+    Client side, keeps the most recent frames as potential baselines
+    and reconstructs full frames from delta bodies
+*/
+class FrameDeltaDecoder {
+public:
+    FrameDeltaDecoder(size_t history_size = 8);
+
+    void store_baseline(const FrameView& frame_view);
+    void clear();
+
+    // Reconstructs the full frame into frame, reusing its capacity
+    FrameDeltaResult apply(const std::byte* body, size_t size, Frame& frame);
+
+private:
+    Frame& next_slot();
+    const Frame* find_baseline(uint32_t timestamp) const;
+
+    std::vector<Frame>      m_history;
+    std::vector<bool>       m_valid;
+    size_t                  m_next_slot;
+
+    FrameDeltaScratch       m_scratch;
+};
\ No newline at end of file
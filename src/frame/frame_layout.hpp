@@ -0,0 +1,380 @@
+#pragma once
+
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+#include "frame_view.hpp"
+
+/*
+    Compile-time description of the frame wire layout
+
+    Every object lists its fields once, in declaration order, and the
+    frame lists its fixed header fields and its object arrays. The static
+    checks below prove that the fields tile each object without padding,
+    so the wire image of an object is its memory image and a whole array
+    is copied with a single memcpy. The serializer, the parser, the size
+    calculation, the delta codec, the shuffle filter and the JSON writer
+    walk these tables at compile time, so adding a field touches the
+    struct and its table, and adding an object array touches FRAME_ARRAYS
+*/
+
+/*
+    The member pointer and the offset are template arguments rather than
+    data members, so the generated code never loads them from the table
+*/
+template <typename Object, typename Value, Value Object::* Member, size_t Offset, bool Reserved>
+struct FieldDescriptor {
+    using object_type   = Object;
+    using value_type    = Value;
+
+    static constexpr Value Object::*    member      = Member;
+    static constexpr size_t             offset      = Offset;
+    static constexpr bool               reserved    = Reserved;    // Kept on the wire, left out of the JSON
+
+    const char*         name;
+    const char*         json_key;   // ,"<name>": the comma is skipped for the first field
+};
+
+#define LAYOUT_FIELD_WITH(Object, member, reserved) \
+    FieldDescriptor<Object, decltype(Object::member), &Object::member, offsetof(Object, member), reserved>{#member, ",\"" #member "\":"}
+
+#define LAYOUT_FIELD(Object, member) LAYOUT_FIELD_WITH(Object, member, false)
+#define LAYOUT_RESERVED_FIELD(Object, member) LAYOUT_FIELD_WITH(Object, member, true)
+
+// Specialized with a fields tuple for every object that goes on the wire
+template <typename Object>
+struct ObjectLayout;
+
+template <>
+struct ObjectLayout<Position> {
+    static constexpr auto fields = std::make_tuple(
+        LAYOUT_FIELD(Position, x),
+        LAYOUT_FIELD(Position, y)
+    );
+};
+
+template <>
+struct ObjectLayout<Velocity> {
+    static constexpr auto fields = std::make_tuple(
+        LAYOUT_FIELD(Velocity, x),
+        LAYOUT_FIELD(Velocity, y)
+    );
+};
+
+template <>
+struct ObjectLayout<Stage> {
+    static constexpr auto fields = std::make_tuple(
+        LAYOUT_FIELD(Stage, id),
+        LAYOUT_FIELD(Stage, name),
+        LAYOUT_FIELD(Stage, state),
+        LAYOUT_FIELD(Stage, next_stage),
+        LAYOUT_FIELD(Stage, timestamp)
+    );
+};
+
+template <>
+struct ObjectLayout<Player> {
+    static constexpr auto fields = std::make_tuple(
+        LAYOUT_FIELD(Player, id),
+        LAYOUT_FIELD(Player, name),
+        LAYOUT_FIELD(Player, state),
+        LAYOUT_FIELD(Player, attack_pattern),
+        LAYOUT_FIELD(Player, pos),
+        LAYOUT_FIELD(Player, vel),
+        LAYOUT_FIELD(Player, radius),
+        LAYOUT_FIELD(Player, angle),
+        LAYOUT_FIELD(Player, current_spell),
+        LAYOUT_FIELD(Player, lives),
+        LAYOUT_FIELD(Player, bombs),
+        LAYOUT_FIELD(Player, power)
+    );
+};
+
+template <>
+struct ObjectLayout<Enemy> {
+    static constexpr auto fields = std::make_tuple(
+        LAYOUT_FIELD(Enemy, id),
+        LAYOUT_FIELD(Enemy, name),
+        LAYOUT_FIELD(Enemy, state),
+        LAYOUT_FIELD(Enemy, attack_pattern),
+        LAYOUT_FIELD(Enemy, pos),
+        LAYOUT_FIELD(Enemy, vel),
+        LAYOUT_FIELD(Enemy, radius),
+        LAYOUT_FIELD(Enemy, angle),
+        LAYOUT_FIELD(Enemy, health)
+    );
+};
+
+template <>
+struct ObjectLayout<Boss> {
+    static constexpr auto fields = std::make_tuple(
+        LAYOUT_FIELD(Boss, id),
+        LAYOUT_FIELD(Boss, name),
+        LAYOUT_FIELD(Boss, state),
+        LAYOUT_FIELD(Boss, attack_pattern),
+        LAYOUT_FIELD(Boss, pos),
+        LAYOUT_FIELD(Boss, vel),
+        LAYOUT_FIELD(Boss, radius),
+        LAYOUT_FIELD(Boss, angle),
+        LAYOUT_FIELD(Boss, health),
+        LAYOUT_FIELD(Boss, current_spell),
+        LAYOUT_FIELD(Boss, phase),
+        LAYOUT_RESERVED_FIELD(Boss, reserved_01),
+        LAYOUT_RESERVED_FIELD(Boss, reserved_02)
+    );
+};
+
+template <>
+struct ObjectLayout<Bullet> {
+    static constexpr auto fields = std::make_tuple(
+        LAYOUT_FIELD(Bullet, id),
+        LAYOUT_FIELD(Bullet, pos),
+        LAYOUT_FIELD(Bullet, vel),
+        LAYOUT_FIELD(Bullet, radius),
+        LAYOUT_FIELD(Bullet, angle),
+        LAYOUT_FIELD(Bullet, damage),
+        LAYOUT_FIELD(Bullet, name),
+        LAYOUT_FIELD(Bullet, state),
+        LAYOUT_FIELD(Bullet, flight_pattern),
+        LAYOUT_FIELD(Bullet, owner)
+    );
+};
+
+template <>
+struct ObjectLayout<Item> {
+    static constexpr auto fields = std::make_tuple(
+        LAYOUT_FIELD(Item, id),
+        LAYOUT_FIELD(Item, name),
+        LAYOUT_FIELD(Item, state),
+        LAYOUT_FIELD(Item, flight_pattern),
+        LAYOUT_FIELD(Item, pos),
+        LAYOUT_FIELD(Item, vel),
+        LAYOUT_FIELD(Item, radius),
+        LAYOUT_FIELD(Item, angle),
+        LAYOUT_FIELD(Item, score)
+    );
+};
+
+/*
+    The fields in the order the JSON writer emits them. Defaults to the
+    wire order, objects whose JSON keys were published in another order
+    list the same fields again in that order
+*/
+template <typename Object>
+struct JsonLayout {
+    static constexpr auto fields = ObjectLayout<Object>::fields;
+};
+
+template <>
+struct JsonLayout<Bullet> {
+    static constexpr auto fields = std::make_tuple(
+        LAYOUT_FIELD(Bullet, id),
+        LAYOUT_FIELD(Bullet, name),
+        LAYOUT_FIELD(Bullet, state),
+        LAYOUT_FIELD(Bullet, flight_pattern),
+        LAYOUT_FIELD(Bullet, owner),
+        LAYOUT_FIELD(Bullet, pos),
+        LAYOUT_FIELD(Bullet, vel),
+        LAYOUT_FIELD(Bullet, radius),
+        LAYOUT_FIELD(Bullet, angle),
+        LAYOUT_FIELD(Bullet, damage)
+    );
+};
+
+static_assert(std::tuple_size_v<decltype(JsonLayout<Bullet>::fields)> == std::tuple_size_v<decltype(ObjectLayout<Bullet>::fields)>);
+
+// The first FRAME_OBJECT_FIXED_HEADER_SIZE bytes of Frame, sent as they are (see FrameFixedHeader)
+inline constexpr auto FRAME_HEADER_FIELDS = std::make_tuple(
+    LAYOUT_FIELD(Frame, client_id),
+    LAYOUT_FIELD(Frame, opponent_id),
+    LAYOUT_FIELD(Frame, mode),
+    LAYOUT_FIELD(Frame, state),
+    LAYOUT_FIELD(Frame, timestamp),
+    LAYOUT_FIELD(Frame, score),
+    LAYOUT_FIELD(Frame, difficulty),
+    LAYOUT_RESERVED_FIELD(Frame, reserved_01),
+    LAYOUT_RESERVED_FIELD(Frame, reserved_02),
+    LAYOUT_RESERVED_FIELD(Frame, reserved_03)
+);
+
+// FrameFixedHeader must list the same fields, checked against FRAME_HEADER_FIELDS below
+inline constexpr auto FRAME_FIXED_HEADER_FIELDS = std::make_tuple(
+    LAYOUT_FIELD(FrameFixedHeader, client_id),
+    LAYOUT_FIELD(FrameFixedHeader, opponent_id),
+    LAYOUT_FIELD(FrameFixedHeader, mode),
+    LAYOUT_FIELD(FrameFixedHeader, state),
+    LAYOUT_FIELD(FrameFixedHeader, timestamp),
+    LAYOUT_FIELD(FrameFixedHeader, score),
+    LAYOUT_FIELD(FrameFixedHeader, difficulty),
+    LAYOUT_RESERVED_FIELD(FrameFixedHeader, reserved_01),
+    LAYOUT_RESERVED_FIELD(FrameFixedHeader, reserved_02),
+    LAYOUT_RESERVED_FIELD(FrameFixedHeader, reserved_03)
+);
+
+/*
+    An object array of the frame, sent as its count followed by the
+    objects. The arrays follow the stage in the order of FRAME_ARRAYS
+*/
+template <
+    typename Object,
+    uint32_t Frame::* Count,
+    std::vector<Object> Frame::* Objects,
+    PackedArrayView<Object> FrameView::* View>
+struct ArrayDescriptor {
+    using object_type   = Object;
+
+    static constexpr uint32_t Frame::*                      count   = Count;
+    static constexpr std::vector<Object> Frame::*           objects = Objects;
+    static constexpr PackedArrayView<Object> FrameView::*   view    = View;
+
+    const char*         name;
+    const char*         json_count_key;     // ,"<name>_count":
+    const char*         json_object_key;    // ,"<name>_ followed by the index
+};
+
+// Frame::<name>_count, Frame::<name>_vector and FrameView::<view>
+#define FRAME_ARRAY(Object, name, view) \
+    ArrayDescriptor<Object, &Frame::name##_count, &Frame::name##_vector, &FrameView::view>{#name, ",\"" #name "_count\":", ",\"" #name "_"}
+
+inline constexpr auto FRAME_ARRAYS = std::make_tuple(
+    FRAME_ARRAY(Player, player, players),
+    FRAME_ARRAY(Enemy, enemy, enemies),
+    FRAME_ARRAY(Boss, boss, bosses),
+    FRAME_ARRAY(Bullet, bullet, bullets),
+    FRAME_ARRAY(Item, item, items)
+);
+
+// Calls function with every descriptor of the tuple, unrolled at compile time
+template <typename Descriptors, typename Function>
+constexpr void for_each_descriptor(const Descriptors& descriptors, Function&& function) {
+    std::apply([&](const auto&... descriptor) {
+        (function(descriptor), ...);
+    }, descriptors);
+}
+
+// Like for_each_descriptor, but stops at the first call that returns false
+template <typename Descriptors, typename Function>
+constexpr bool all_descriptors(const Descriptors& descriptors, Function&& function) {
+    return std::apply([&](const auto&... descriptor) {
+        return (function(descriptor) && ...);
+    }, descriptors);
+}
+
+template <typename Object, typename = void>
+struct has_object_layout : std::false_type {};
+
+template <typename Object>
+struct has_object_layout<Object, std::void_t<decltype(ObjectLayout<Object>::fields)>> : std::true_type {};
+
+template <typename Object>
+inline constexpr bool has_object_layout_v = has_object_layout<Object>::value;
+
+// End of the last field if every field starts where the previous one ends, zero otherwise
+template <typename Fields>
+constexpr size_t packed_fields_end(const Fields& fields) {
+    size_t end = 0;
+    bool packed = true;
+
+    for_each_descriptor(fields, [&](const auto& field) {
+        using Value = typename std::decay_t<decltype(field)>::value_type;
+
+        packed = packed && field.offset == end;
+        end += sizeof(Value);
+    });
+
+    return packed ? end : 0;
+}
+
+constexpr bool same_field_name(const char* name, const char* other_name) {
+    while (*name != '\0' && *name == *other_name)
+    {
+        name++;
+        other_name++;
+    }
+
+    return *name == *other_name;
+}
+
+template <typename Fields, typename OtherFields, size_t... Index>
+constexpr bool same_field_layout(const Fields& fields, const OtherFields& other_fields, std::index_sequence<Index...>) {
+    return ((std::get<Index>(fields).offset == std::get<Index>(other_fields).offset &&
+        sizeof(typename std::tuple_element_t<Index, Fields>::value_type) == sizeof(typename std::tuple_element_t<Index, OtherFields>::value_type) &&
+        same_field_name(std::get<Index>(fields).name, std::get<Index>(other_fields).name)) && ...);
+}
+
+// Both tables list the same fields, in the same order, at the same offsets and with the same sizes
+template <typename Fields, typename OtherFields>
+constexpr bool same_field_layout(const Fields& fields, const OtherFields& other_fields) {
+    if constexpr (std::tuple_size_v<Fields> != std::tuple_size_v<OtherFields>)
+    {
+        return false;
+    }
+    else
+    {
+        return same_field_layout(fields, other_fields, std::make_index_sequence<std::tuple_size_v<Fields>>());
+    }
+}
+
+// The fields tile the object, so its memory image is its wire image
+template <typename Object>
+constexpr bool is_packed_object() {
+    return std::is_trivially_copyable_v<Object> &&
+        std::is_standard_layout_v<Object> &&
+        packed_fields_end(ObjectLayout<Object>::fields) == sizeof(Object);
+}
+
+static_assert(is_packed_object<Position>());
+static_assert(is_packed_object<Velocity>());
+static_assert(is_packed_object<Stage>() && sizeof(Stage) == STAGE_OBJECT_SIZE);
+
+static_assert(std::is_standard_layout_v<Frame>);
+static_assert(packed_fields_end(FRAME_HEADER_FIELDS) == FRAME_OBJECT_FIXED_HEADER_SIZE);
+
+// make_fixed_header() copies the Frame fields straight into a FrameFixedHeader
+static_assert(std::is_trivially_copyable_v<FrameFixedHeader> && std::is_standard_layout_v<FrameFixedHeader>);
+static_assert(packed_fields_end(FRAME_FIXED_HEADER_FIELDS) == sizeof(FrameFixedHeader));
+static_assert(same_field_layout(FRAME_HEADER_FIELDS, FRAME_FIXED_HEADER_FIELDS), "FrameFixedHeader must match FRAME_HEADER_FIELDS");
+
+static_assert(all_descriptors(FRAME_ARRAYS, [](const auto& array) {
+    return is_packed_object<typename std::decay_t<decltype(array)>::object_type>();
+}), "Every object array must hold packed objects");
+
+// Size of the serialized frame: the fixed header, the stage, and each count with its objects
+inline size_t frame_wire_size(const Frame& frame) {
+    size_t size = FRAME_OBJECT_FIXED_HEADER_SIZE + STAGE_OBJECT_SIZE;
+
+    for_each_descriptor(FRAME_ARRAYS, [&](const auto& array) {
+        using Object = typename std::decay_t<decltype(array)>::object_type;
+
+        size += sizeof(uint32_t) + sizeof(Object) * frame.*array.count;
+    });
+
+    return size;
+}
+
+// Copies each header field to its wire offset, the copies merge into a few wide stores
+inline void encode_frame_header(const Frame& frame, std::byte* dest) {
+    for_each_descriptor(FRAME_HEADER_FIELDS, [&](const auto& field) {
+        memcpy(dest + field.offset, &(frame.*field.member), sizeof(frame.*field.member));
+    });
+}
+
+inline void decode_frame_header(const std::byte* src, Frame& frame) {
+    for_each_descriptor(FRAME_HEADER_FIELDS, [&](const auto& field) {
+        memcpy(&(frame.*field.member), src + field.offset, sizeof(frame.*field.member));
+    });
+}
+
+inline FrameFixedHeader make_fixed_header(const Frame& frame) {
+    FrameFixedHeader header;
+    encode_frame_header(frame, reinterpret_cast<std::byte*>(&header));
+
+    return header;
+}
+
+inline void read_fixed_header(const FrameFixedHeader& header, Frame& frame) {
+    decode_frame_header(reinterpret_cast<const std::byte*>(&header), frame);
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#include "frame_pool.hpp"
+
+FramePool::FramePool(size_t max_pooled_frames)
+    : m_max_pooled_frames(max_pooled_frames)
+{
+    m_frames.reserve(max_pooled_frames);
+}
+
+Frame FramePool::acquire() {
+    if (m_frames.empty())
+    {
+        return Frame();
+    }
+
+    // Moving a frame moves its vectors, nothing is allocated
+    Frame frame = std::move(m_frames.back());
+    m_frames.pop_back();
+
+    return frame;
+}
+
+void FramePool::release(Frame&& frame) {
+    if (m_frames.size() < m_max_pooled_frames)
+    {
+        m_frames.push_back(std::move(frame));
+    }
+}
+
+void FramePool::release(std::vector<Frame>& frames) {
+    for (auto& frame : frames)
+    {
+        release(std::move(frame));
+    }
+
+    frames.clear();
+}
+
+size_t FramePool::size() const {
+    return m_frames.size();
+}
\ No newline at end of file
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include "frame_template.hpp"
+
+/*
+    Recycler for Frame objects
+
+    A frame owns five vectors, so creating one per received packet costs
+    several heap allocations. Frames returned to the pool keep their vector
+    capacity and are handed out again by acquire(), decoding into them with
+    frame_view_to_frame() or deserialize_frame() then reuses that capacity.
+    Once every frame has grown to the largest frame seen, the decode path
+    does not allocate at all
+*/
+class FramePool {
+public:
+    FramePool(size_t max_pooled_frames = 64);
+
+    // Returns a recycled frame (with stale contents) or a new empty one
+    Frame acquire();
+
+    // Frames beyond max_pooled_frames are freed
+    void release(Frame&& frame);
+
+    // Releases every frame and clears frames, which keeps its own capacity
+    void release(std::vector<Frame>& frames);
+
+    size_t size() const;
+
+private:
+    size_t              m_max_pooled_frames;
+    std::vector<Frame>  m_frames;
+};
\ No newline at end of file
@@ -1,235 +1,134 @@
 #include <iostream>
 #include <cstring>
 #include "frame_serializer.hpp"
+#include "frame_view.hpp"
+#include "frame_layout.hpp"
+#include "../crc32c/crc32c.hpp"
 
-namespace {
-    template <typename T>
-    const std::byte* copy_bytes_to_t(T* dest, const std::byte* src) {
-        static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable");
-        memcpy(dest, src, sizeof(T));
-
-        return src + sizeof(T);
-    }
+size_t serialized_frame_size(const Frame& frame) {
+    return frame_wire_size(frame);
 }
 
-std::optional<std::vector<std::byte>> serialize_frame(const Frame& frame) {
-    auto player_count_validation = frame.player_count != frame.player_vector.size(); 
-    auto enemy_count_validation = frame.enemy_count != frame.enemy_vector.size();
-    auto boss_count_validation = frame.bullet_count != frame.bullet_vector.size();
-    auto bullet_count_validation = frame.bullet_count != frame.bullet_vector.size();
-    auto item_count_validation = frame.item_count != frame.item_vector.size();
+bool append_packet(std::vector<std::byte>& bytes, uint32_t magic_number, PacketType packet_type, const std::byte* body, size_t body_size, uint8_t packet_flags) {
+    const auto checksummed = has_packet_flag(packet_flags, PacketFlag::Checksummed);
+    const auto checksum_size = checksummed ? sizeof(PacketChecksum) : 0;
 
-    // Check if the number of objects and actual size of objects are same
-    if (player_count_validation || enemy_count_validation || boss_count_validation ||
-        bullet_count_validation || item_count_validation)
+    // The size would be cut to its lower 24 bits and the receiver would lose the packet boundary
+    if (body_size + checksum_size > PACKET_BODY_SIZE_MASK)
     {
-        std::cerr << "Failed to serialize frame" << "\n";
-        std::cerr << "The number of objects and the size of objects does not match" << "\n";
-        
-        return std::nullopt;
+        std::cerr << "Failed to append packet" << "\n";
+        std::cerr << "The packet body is too large: " << body_size + checksum_size << " bytes" << "\n";
+
+        return false;
     }
 
-    // Calculate the total size of the packet (frame)
-    auto packet_size = FRAME_OBJECT_FIXED_HEADER_SIZE +
-        STAGE_OBJECT_SIZE +
-        sizeof(frame.player_count) +
-        PLAYER_OBJECT_SIZE * frame.player_count +
-        sizeof(frame.enemy_count) +
-        ENEMY_OBJECT_SIZE * frame.enemy_count +
-        sizeof(frame.boss_count) +
-        BOSS_OBJECT_SIZE * frame.boss_count +
-        sizeof(frame.bullet_count) +
-        BULLET_OBJECT_SIZE * frame.bullet_count +
-        sizeof(frame.item_count) +
-        ITEM_OBJECT_SIZE * frame.item_count;
-
-    std::vector<std::byte> bytes(packet_size);
-    auto bytes_offset = bytes.data();
-
-    // Pack the fixed header of frame object
-    memcpy(
-        bytes_offset,
-        &frame,
-        FRAME_OBJECT_FIXED_HEADER_SIZE
-    );
+    auto packet_header = make_packet_header(magic_number, packet_type, static_cast<uint32_t>(body_size + checksum_size), packet_flags);
+    auto header_bytes = reinterpret_cast<const std::byte*>(&packet_header);
 
-    bytes_offset += FRAME_OBJECT_FIXED_HEADER_SIZE;
+    bytes.insert(bytes.end(), header_bytes, header_bytes + sizeof(PacketHeader));
 
-    // Pack the stage object
-    memcpy(
-        bytes_offset,
-        &frame.stage,
-        STAGE_OBJECT_SIZE
-    );
+    if (checksummed)
+    {
+        PacketChecksum checksum;
+        checksum.header_crc = crc32c(header_bytes, sizeof(PacketHeader));
+        checksum.body_crc = crc32c(body, body_size);
 
-    bytes_offset += STAGE_OBJECT_SIZE;
+        auto checksum_bytes = reinterpret_cast<const std::byte*>(&checksum);
+        bytes.insert(bytes.end(), checksum_bytes, checksum_bytes + sizeof(PacketChecksum));
+    }
 
-    // Pack the player objects
-    memcpy(
-        bytes_offset,
-        &frame.player_count,
-        sizeof(frame.player_count)
-    );
+    bytes.insert(bytes.end(), body, body + body_size);
 
-    bytes_offset += sizeof(frame.player_count);
+    return true;
+}
 
-    memcpy(
-        bytes_offset,
-        frame.player_vector.data(),
-        PLAYER_OBJECT_SIZE * frame.player_count
-    );
+bool serialize_frame_packet(const Frame& frame, uint32_t magic_number, FrameCompressor& compressor, std::vector<std::byte>& bytes) {
+    return compressor.append_frame_packet(bytes, magic_number, frame);
+}
 
-    bytes_offset += PLAYER_OBJECT_SIZE * frame.player_count;
+std::optional<std::vector<std::byte>> serialize_frame(const Frame& frame) {
+    std::vector<std::byte> bytes;
 
-    // Pack the enemy objects
-    memcpy(
-        bytes_offset,
-        &frame.enemy_count,
-        sizeof(frame.enemy_count)
-    );
+    if (!append_serialized_frame(frame, bytes))
+    {
+        return std::nullopt;
+    }
 
-    bytes_offset += sizeof(frame.enemy_count);
+    return bytes;
+}
 
-    memcpy(
-        bytes_offset,
-        frame.enemy_vector.data(),
-        ENEMY_OBJECT_SIZE * frame.enemy_count
-    );
+bool append_serialized_frame(const Frame& frame, std::vector<std::byte>& bytes) {
+    // Check if the number of objects and actual size of objects are same
+    const auto counts_match = all_descriptors(FRAME_ARRAYS, [&](const auto& array) {
+        return frame.*array.count == (frame.*array.objects).size();
+    });
 
-    bytes_offset += ENEMY_OBJECT_SIZE * frame.enemy_count;
+    if (!counts_match)
+    {
+        std::cerr << "Failed to serialize frame" << "\n";
+        std::cerr << "The number of objects and the size of objects does not match" << "\n";
 
-    // Pack the boss objects
-    memcpy(
-        bytes_offset,
-        &frame.boss_count,
-        sizeof(frame.boss_count)
-    );
+        return false;
+    }
 
-    bytes_offset += sizeof(frame.boss_count);
+    // Calculate the total size of the packet (frame)
+    auto packet_size = frame_wire_size(frame);
 
-    memcpy(
-        bytes_offset,
-        frame.boss_vector.data(),
-        BOSS_OBJECT_SIZE * frame.boss_count
-    );
+    const auto initial_size = bytes.size();
+    bytes.resize(initial_size + packet_size);
+    auto bytes_offset = bytes.data() + initial_size;
 
-    bytes_offset += BOSS_OBJECT_SIZE * frame.boss_count;
+    // Pack the fixed header of frame object and the stage object
+    encode_frame_header(frame, bytes_offset);
+    bytes_offset += FRAME_OBJECT_FIXED_HEADER_SIZE;
 
-    // Pack the bullet objects
-    memcpy(
-        bytes_offset,
-        &frame.bullet_count,
-        sizeof(frame.bullet_count)
-    );
+    memcpy(bytes_offset, &frame.stage, STAGE_OBJECT_SIZE);
+    bytes_offset += STAGE_OBJECT_SIZE;
 
-    bytes_offset += sizeof(frame.bullet_count);
+    // Pack each object array as its count followed by the objects
+    for_each_descriptor(FRAME_ARRAYS, [&](const auto& array) {
+        const auto& objects = frame.*array.objects;
+        const auto objects_size = sizeof(objects[0]) * objects.size();
 
-    memcpy(
-        bytes_offset,
-        frame.bullet_vector.data(),
-        BULLET_OBJECT_SIZE * frame.bullet_count
-    );
+        memcpy(bytes_offset, &(frame.*array.count), sizeof(uint32_t));
+        bytes_offset += sizeof(uint32_t);
 
-    bytes_offset += BULLET_OBJECT_SIZE * frame.bullet_count;
+        // An empty vector may have no storage at all
+        if (objects_size > 0)
+        {
+            memcpy(bytes_offset, objects.data(), objects_size);
+        }
 
-    // Pack the item objects
-    memcpy(
-        bytes_offset,
-        &frame.item_count,
-        sizeof(frame.item_count)
-    );
+        bytes_offset += objects_size;
+    });
 
-    bytes_offset += sizeof(frame.item_count);
+    return true;
+}
 
-    memcpy(
-        bytes_offset,
-        frame.item_vector.data(),
-        ITEM_OBJECT_SIZE * frame.item_count
-    );
+std::optional<Frame> deserialize_frame(const std::vector<std::byte>& bytes) {
+    return deserialize_frame(bytes.data(), bytes.size());
+}
 
-    bytes_offset += ITEM_OBJECT_SIZE * frame.item_count;
+std::optional<Frame> deserialize_frame(const std::byte* bytes, size_t size) {
+    auto frame_view_opt = parse_frame_view(bytes, size);
 
-    return bytes;
+    if (!frame_view_opt)
+    {
+        return std::nullopt;
+    }
+
+    return frame_view_to_frame(frame_view_opt.value());
 }
 
-std::optional<Frame> deserialize_frame(const std::vector<std::byte>& bytes) {
-    Frame frame = {};
-    auto bytes_offset = bytes.data();
-
-    // Copy the fixed area of the frame object
-    bytes_offset = copy_bytes_to_t(&frame.client_id,    bytes_offset);
-    bytes_offset = copy_bytes_to_t(&frame.opponent_id,  bytes_offset);
-    bytes_offset = copy_bytes_to_t(&frame.mode,         bytes_offset);
-    bytes_offset = copy_bytes_to_t(&frame.state,        bytes_offset);
-    bytes_offset = copy_bytes_to_t(&frame.timestamp,    bytes_offset);
-    bytes_offset = copy_bytes_to_t(&frame.score,        bytes_offset);
-    bytes_offset = copy_bytes_to_t(&frame.difficulty,   bytes_offset);
-    bytes_offset = copy_bytes_to_t(&frame.reserved_01,  bytes_offset);
-    bytes_offset = copy_bytes_to_t(&frame.reserved_02,  bytes_offset);
-    bytes_offset = copy_bytes_to_t(&frame.reserved_03,  bytes_offset);
-
-    // Copy the stage object
-    bytes_offset = copy_bytes_to_t(&frame.stage, bytes_offset);
-
-    // Acquire the number of players and then copy the player objects
-    bytes_offset = copy_bytes_to_t(&frame.player_count, bytes_offset);
-    frame.player_vector.resize(frame.player_count);
-
-    memcpy(
-        frame.player_vector.data(),
-        bytes_offset,
-        PLAYER_OBJECT_SIZE * frame.player_count
-    );
-
-    bytes_offset += PLAYER_OBJECT_SIZE * frame.player_count;
-
-    // Acquire the number of enemies and then copy the enemy objects
-    bytes_offset = copy_bytes_to_t(&frame.enemy_count, bytes_offset);
-    frame.enemy_vector.resize(frame.enemy_count);
-
-    memcpy(
-        frame.enemy_vector.data(),
-        bytes_offset,
-        ENEMY_OBJECT_SIZE * frame.enemy_count
-    );
-
-    bytes_offset += ENEMY_OBJECT_SIZE * frame.enemy_count;
-
-    // // Acquire the number of bosses and then copy the boss objects
-    bytes_offset = copy_bytes_to_t(&frame.boss_count, bytes_offset);
-    frame.boss_vector.resize(frame.boss_count);
-
-    memcpy(
-        frame.boss_vector.data(),
-        bytes_offset,
-        BOSS_OBJECT_SIZE * frame.boss_count
-    );
-
-    bytes_offset += BOSS_OBJECT_SIZE * frame.boss_count;
-
-    // // Acquire the number of bullets and then copy the bullet objects
-    bytes_offset = copy_bytes_to_t(&frame.bullet_count, bytes_offset);
-    frame.bullet_vector.resize(frame.bullet_count);
-
-    memcpy(
-        frame.bullet_vector.data(),
-        bytes_offset,
-        BULLET_OBJECT_SIZE * frame.bullet_count
-    );
-
-    bytes_offset += BULLET_OBJECT_SIZE * frame.bullet_count;
-
-    // Acquire the number of items and then copy the item objects
-    bytes_offset = copy_bytes_to_t(&frame.item_count, bytes_offset);
-    frame.item_vector.resize(frame.item_count);
-
-    memcpy(
-        frame.item_vector.data(),
-        bytes_offset,
-        ITEM_OBJECT_SIZE * frame.item_count
-    );
-
-    bytes_offset += ITEM_OBJECT_SIZE * frame.item_count;
-
-    return frame;
+bool deserialize_frame(const std::byte* bytes, size_t size, Frame& frame) {
+    auto frame_view_opt = parse_frame_view(bytes, size);
+
+    if (!frame_view_opt)
+    {
+        return false;
+    }
+
+    frame_view_to_frame(frame_view_opt.value(), frame);
+
+    return true;
 }
\ No newline at end of file
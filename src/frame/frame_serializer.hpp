@@ -2,8 +2,48 @@
 
 #include <vector>
 #include <cstddef>
+#include <cstring>
 #include <optional>
+#include <type_traits>
 #include "frame_template.hpp"
+#include "frame_compression.hpp"
 
+size_t serialized_frame_size(const Frame& frame);
 std::optional<std::vector<std::byte>> serialize_frame(const Frame& frame);
-std::optional<Frame> deserialize_frame(const std::vector<std::byte>& bytes);
\ No newline at end of file
+
+// Appends the serialized frame to bytes, reusing their capacity
+bool append_serialized_frame(const Frame& frame, std::vector<std::byte>& bytes);
+std::optional<Frame> deserialize_frame(const std::vector<std::byte>& bytes);
+std::optional<Frame> deserialize_frame(const std::byte* bytes, size_t size);
+
+// Decodes into an existing frame, reusing its capacity (see FramePool)
+bool deserialize_frame(const std::byte* bytes, size_t size, Frame& frame);
+
+/*
+    Appends a packet header followed by the body to bytes. With
+    PacketFlag::Checksummed the PacketChecksum is inserted in front of the body.
+    Fails without touching bytes if the body is too large for a PacketHeader
+*/
+bool append_packet(std::vector<std::byte>& bytes, uint32_t magic_number, PacketType packet_type, const std::byte* body, size_t body_size, uint8_t packet_flags = 0);
+
+// Copies a fixed-size message (e.g., ClockPong) out of a packet body, fails if the size does not match
+template <typename Message>
+bool read_packet_message(const std::byte* body, size_t body_size, Message& message) {
+    static_assert(std::is_trivially_copyable_v<Message>, "Message must be trivially copyable");
+
+    if (body_size != sizeof(Message))
+    {
+        return false;
+    }
+
+    memcpy(&message, body, sizeof(Message));
+
+    return true;
+}
+
+/*
+    Serializes the frame as a complete packet, compressed according to the
+    compressor. The body goes through the compressor's buffers, so a warmed
+    up compressor does not allocate
+*/
+bool serialize_frame_packet(const Frame& frame, uint32_t magic_number, FrameCompressor& compressor, std::vector<std::byte>& bytes);
\ No newline at end of file
@@ -2,190 +2,78 @@
 #include <string>
 #include <sstream>
 #include "frame_template.hpp"
+#include "frame_layout.hpp"
 
-std::string frame_to_json_str(const Frame& frame) {
-    std::ostringstream oss;
-
-    oss << "{";
-
+namespace {
     /*
-        Convert Frame attributes into json string
+        Writes the described fields as a json object, nested objects that
+        have an ObjectLayout (e.g., pos) recursively in JsonLayout order.
+        Every number is written as a float, reserved fields are left out.
+        The keys carry their separator, so each field costs the stream
+        two insertions
     */
-    oss << "\"frame\":{"
-        << "\"client_id\":"     << static_cast<float>(frame.client_id)    << ","
-        << "\"opponent_id\":"   << static_cast<float>(frame.opponent_id)  << ","
-        << "\"mode\":"          << static_cast<float>(frame.mode)         << ","
-        << "\"state\":"         << static_cast<float>(frame.state)        << ","
-        << "\"timestamp\":"     << static_cast<float>(frame.timestamp)    << ","
-        << "\"score\":"         << static_cast<float>(frame.score)        << ","
-        << "\"difficulty\":"    << static_cast<float>(frame.difficulty)
-        << "}"
-        << ",";
+    template <typename Object, typename Fields>
+    void write_json_fields(std::ostream& oss, const Object& object, const Fields& fields) {
+        bool first = true;
+
+        oss << '{';
+
+        for_each_descriptor(fields, [&](const auto& field) {
+            using Value = typename std::decay_t<decltype(field)>::value_type;
+
+            if (field.reserved)
+            {
+                return;
+            }
+
+            oss << (first ? field.json_key + 1 : field.json_key);
+            first = false;
+
+            if constexpr (has_object_layout_v<Value>)
+            {
+                write_json_fields(oss, object.*field.member, JsonLayout<Value>::fields);
+            }
+            else
+            {
+                oss << static_cast<float>(object.*field.member);
+            }
+        });
+
+        oss << '}';
+    }
+}
 
-    /*
-        Convert Stage attributes into json string
-    */
-    oss << "\"stage\":{"
-        << "\"id\":"            << static_cast<float>(frame.stage.id)           << ","
-        << "\"name\":"          << static_cast<float>(frame.stage.name)         << ","
-        << "\"state\":"         << static_cast<float>(frame.stage.state)        << ","
-        << "\"next_stage\":"    << static_cast<float>(frame.stage.next_stage)   << ","
-        << "\"timestamp\":"     << static_cast<float>(frame.stage.timestamp)
-        << "},";
+std::string frame_to_json_str(const Frame& frame) {
+    std::ostringstream oss;
 
     /*
-        Convert Player attributes into json string
+        Convert Frame and Stage attributes into json string
     */
-    oss << "\"player_count\":" << frame.player_count << ",";
-
-    for (uint32_t i = 0; i < frame.player_count; i++)
-    {
-        oss << "\"player_" << i << "\":{"
-        << "\"id\":"                << static_cast<float>(frame.player_vector[i].id)                << ","
-        << "\"name\":"              << static_cast<float>(frame.player_vector[i].name)              << ","
-        << "\"state\":"             << static_cast<float>(frame.player_vector[i].state)             << ","
-        << "\"attack_pattern\":"    << static_cast<float>(frame.player_vector[i].attack_pattern)    << ","
-        << "\"pos\":{"
-        << "\"x\":"                 << static_cast<float>(frame.player_vector[i].pos.x)             << ","
-        << "\"y\":"                 << static_cast<float>(frame.player_vector[i].pos.y)
-        << "},"
-        << "\"vel\":{"
-        << "\"x\":"                 << static_cast<float>(frame.player_vector[i].vel.x)             << ","
-        << "\"y\":"                 << static_cast<float>(frame.player_vector[i].vel.y)
-        << "},"
-        << "\"radius\":"            << static_cast<float>(frame.player_vector[i].radius)            << ","
-        << "\"angle\":"             << static_cast<float>(frame.player_vector[i].angle)             << ","
-        << "\"current_spell\":"     << static_cast<float>(frame.player_vector[i].current_spell)     << ","
-        << "\"lives\":"             << static_cast<float>(frame.player_vector[i].lives)             << ","
-        << "\"bombs\":"             << static_cast<float>(frame.player_vector[i].bombs)             << ","
-        << "\"power\":"             << static_cast<float>(frame.player_vector[i].power)
-        << "},";
-    }
+    oss << "{\"frame\":";
+    write_json_fields(oss, frame, FRAME_HEADER_FIELDS);
 
-    /*
-        Convert Enemy attributes into json string
-    */
-    oss << "\"enemy_count\":" << frame.enemy_count << ",";
-
-    for (uint32_t i = 0; i < frame.enemy_count; i++)
-    {
-        oss << "\"enemy_" << i << "\":{"
-        << "\"id\":"                << static_cast<float>(frame.enemy_vector[i].id)             << ","
-        << "\"name\":"              << static_cast<float>(frame.enemy_vector[i].name)           << ","
-        << "\"state\":"             << static_cast<float>(frame.enemy_vector[i].state)          << ","
-        << "\"attack_pattern\":"    << static_cast<float>(frame.enemy_vector[i].attack_pattern) << ","
-        << "\"pos\":{"
-        << "\"x\":"                 << static_cast<float>(frame.enemy_vector[i].pos.x)          << ","
-        << "\"y\":"                 << static_cast<float>(frame.enemy_vector[i].pos.y)
-        << "},"
-        << "\"vel\":{"
-        << "\"x\":"                 << static_cast<float>(frame.enemy_vector[i].vel.x)          << ","
-        << "\"y\":"                 << static_cast<float>(frame.enemy_vector[i].vel.y)
-        << "},"
-        << "\"radius\":"            << static_cast<float>(frame.enemy_vector[i].radius)         << ","
-        << "\"angle\":"             << static_cast<float>(frame.enemy_vector[i].angle )         << ","
-        << "\"health\":"            << static_cast<float>(frame.enemy_vector[i].health)
-        << "},";
-    }
+    oss << ",\"stage\":";
+    write_json_fields(oss, frame.stage, JsonLayout<Stage>::fields);
 
     /*
-        Convert Boss attributes into json string
+        Convert each object array into its count and one json object per object
     */
-    oss << "\"boss_count\":" << frame.boss_count << ",";
-
-    for (uint32_t i = 0; i < frame.boss_count; i++)
-    {
-        oss << "\"boss_" << i << "\":{"
-        << "\"id\":"                << static_cast<float>(frame.boss_vector[i].id)              << ","
-        << "\"name\":"              << static_cast<float>(frame.boss_vector[i].name)            << ","
-        << "\"state\":"             << static_cast<float>(frame.boss_vector[i].state)           << ","
-        << "\"attack_pattern\":"    << static_cast<float>(frame.boss_vector[i].attack_pattern)  << ","
-        << "\"pos\":{"
-        << "\"x\":"                 << static_cast<float>(frame.boss_vector[i].pos.x)           << ","
-        << "\"y\":"                 << static_cast<float>(frame.boss_vector[i].pos.y)
-        << "},"
-        << "\"vel\":{"
-        << "\"x\":"                 << static_cast<float>(frame.boss_vector[i].vel.x)           << ","
-        << "\"y\":"                 << static_cast<float>(frame.boss_vector[i].vel.y)
-        << "},"
-        << "\"radius\":"            << static_cast<float>(frame.boss_vector[i].radius)          << ","
-        << "\"angle\":"             << static_cast<float>(frame.boss_vector[i].angle)           << ","
-        << "\"health\":"            << static_cast<float>(frame.boss_vector[i].health)          << ","
-        << "\"current_spell\":"     << static_cast<float>(frame.boss_vector[i].current_spell)   << ","
-        << "\"phase\":"             << static_cast<float>(frame.boss_vector[i].phase)
-        << "},";
-    }
+    for_each_descriptor(FRAME_ARRAYS, [&](const auto& array) {
+        using Object = typename std::decay_t<decltype(array)>::object_type;
 
-    /*
-        Convert Bullet attributes into json string
-    */
-    oss << "\"bullet_count\":"<< frame.bullet_count << ",";
-
-    for (uint32_t i = 0; i < frame.bullet_count; i++)
-    {
-        oss << "\"bullet_" << i << "\":{"
-        << "\"id\":"                << static_cast<float>(frame.bullet_vector[i].id)                << ","
-        << "\"name\":"              << static_cast<float>(frame.bullet_vector[i].name)              << ","
-        << "\"state\":"             << static_cast<float>(frame.bullet_vector[i].state)             << ","
-        << "\"flight_pattern\":"    << static_cast<float>(frame.bullet_vector[i].flight_pattern)    << ","
-        << "\"owner\":"             << static_cast<float>(frame.bullet_vector[i].owner)             << ","
-        << "\"pos\":{"
-        << "\"x\":"                 << static_cast<float>(frame.bullet_vector[i].pos.x)             << ","
-        << "\"y\":"                 << static_cast<float>(frame.bullet_vector[i].pos.y)
-        << "},"
-        << "\"vel\":{"
-        << "\"x\":"                 << static_cast<float>(frame.bullet_vector[i].vel.x)             << ","
-        << "\"y\":"                 << static_cast<float>(frame.bullet_vector[i].vel.y)
-        << "},"
-        << "\"radius\":"            << static_cast<float>(frame.bullet_vector[i].radius)            << ","
-        << "\"angle\":"             << static_cast<float>(frame.bullet_vector[i].angle)             << ","
-        << "\"damage\":"            << static_cast<float>(frame.bullet_vector[i].damage)
-        << "},";
-    }
-    
-    /*
-        Convert Item attributes into json string
-    */
-    if (frame.item_count > 0)
-    {
-        oss << "\"item_count\":" << frame.item_count << ",";
-    }
-    else
-    {
-        oss << "\"item_count\":" << frame.item_count;
-    }
+        const auto& objects = frame.*array.objects;
 
-    for (uint32_t i = 0; i < frame.item_count; i++)
-    {
-        oss << "\"item_" << i << "\":{"
-        << "\"id\":"                << static_cast<float>(frame.item_vector[i].id)              << ","
-        << "\"name\":"              << static_cast<float>(frame.item_vector[i].name)            << ","
-        << "\"state\":"             << static_cast<float>(frame.item_vector[i].state)           << ","
-        << "\"flight_pattern\":"    << static_cast<float>(frame.item_vector[i].flight_pattern)  << ","
-        << "\"pos\":{"
-        << "\"x\":"                 << static_cast<float>(frame.item_vector[i].pos.x)           << ","
-        << "\"y\":"                 << static_cast<float>(frame.item_vector[i].pos.y)
-        << "},"
-        << "\"vel\":{"
-        << "\"x\":"                 << static_cast<float>(frame.item_vector[i].vel.x)           << ","
-        << "\"y\":"                 << static_cast<float>(frame.item_vector[i].vel.y)
-        << "},"
-        << "\"radius\":"            << static_cast<float>(frame.item_vector[i].radius)          << ","
-        << "\"angle\":"             << static_cast<float>(frame.item_vector[i].angle)           << ","
-        << "\"score\":"             << static_cast<float>(frame.item_vector[i].score);
-
-        if (i != (frame.item_count - 1))
-        {
-            oss << "},";
-        }
-        else
+        oss << array.json_count_key << frame.*array.count;
+
+        for (size_t i = 0; i < objects.size(); i++)
         {
-            oss << "}";
+            oss << array.json_object_key << i << "\":";
+            write_json_fields(oss, objects[i], JsonLayout<Object>::fields);
         }
-    }
+    });
+
+    oss << '}';
 
-    oss << "}";
-        
     return oss.str();
 }
 
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <vector>
+#include <cstddef>
 #include <cstdint>
 
 /*
@@ -13,6 +14,169 @@ struct PacketHeader {
 
 static_assert(sizeof(PacketHeader) == 8);
 
+/*
+    Packets never exceed SERVER_MAX_PACKET_SIZE (< 16MB), so only the lower
+    24 bits of body_size hold the size. The low nibble of the upper byte
+    is the packet type, the high nibble holds the packet flags.
+    A legacy header therefore always describes a plain Frame packet
+*/
+constexpr uint32_t PACKET_BODY_SIZE_MASK    = 0x00FFFFFF;
+constexpr uint32_t PACKET_TYPE_SHIFT        = 24;
+constexpr uint32_t PACKET_TYPE_MASK         = 0x0F;
+constexpr uint32_t PACKET_FLAGS_SHIFT       = 28;
+constexpr uint32_t PACKET_FLAGS_MASK        = 0x0F;
+constexpr size_t   PACKET_TYPE_COUNT        = PACKET_TYPE_MASK + 1;
+
+enum class PacketType : uint8_t {
+    Frame       = 0,    // Full frame (keyframe), server to client
+    FrameDelta  = 1,    // Frame encoded against an acknowledged baseline, server to client
+    FrameAck    = 2,    // Acknowledges a received frame, client to server
+    Input       = 3,    // Player input commands, client to server, see input.hpp
+    ClockPing   = 4,    // Clock synchronization request, client to server, see clock_sync.hpp
+    ClockPong   = 5,    // Answer to a ClockPing, server to client
+    Resume      = 6,    // First packet of a reconnected client, client to server
+    Hello       = 7,    // Protocol version announcement, first packet in both directions
+    FrameBatch  = 8,    // Several full frames in one packet, server to client, see frame_batch.hpp
+    LodReport   = 9,    // Level of detail budget of the client, client to server, see lod.hpp
+};
+
+inline constexpr size_t packet_type_index(PacketType packet_type) {
+    return static_cast<size_t>(packet_type);
+}
+
+enum class PacketFlag : uint8_t {
+    None        = 0,
+    Compressed  = 1 << 0,   // The body is an LZ block, see frame_compression.hpp
+    Shuffled    = 1 << 1,   // The object arrays of the compressed frame are byte-shuffled
+    Checksummed = 1 << 2,   // The body starts with a PacketChecksum
+};
+
+/*
+    Packet checksum (8bytes), in front of the body of PacketFlag::Checksummed
+    packets and counted in body_size
+
+    Both are CRC-32C. The header checksum can be verified as soon as the
+    first 12 bytes are buffered, so a false magic number match is rejected
+    before the parser waits for its (bogus) body
+*/
+struct PacketChecksum {
+    uint32_t    header_crc;     // Of the 8 header bytes
+    uint32_t    body_crc;       // Of the body bytes behind the checksum
+};
+
+static_assert(sizeof(PacketChecksum) == 8);
+
+inline uint32_t packet_body_size(const PacketHeader& packet_header) {
+    return packet_header.body_size & PACKET_BODY_SIZE_MASK;
+}
+
+inline PacketType packet_type(const PacketHeader& packet_header) {
+    return static_cast<PacketType>((packet_header.body_size >> PACKET_TYPE_SHIFT) & PACKET_TYPE_MASK);
+}
+
+inline uint8_t packet_flags(const PacketHeader& packet_header) {
+    return static_cast<uint8_t>((packet_header.body_size >> PACKET_FLAGS_SHIFT) & PACKET_FLAGS_MASK);
+}
+
+inline bool has_packet_flag(uint8_t packet_flags, PacketFlag packet_flag) {
+    return (packet_flags & static_cast<uint8_t>(packet_flag)) != 0;
+}
+
+// body_size must fit in PACKET_BODY_SIZE_MASK, append_packet() checks this for every packet it writes
+inline PacketHeader make_packet_header(uint32_t magic_number, PacketType packet_type, uint32_t body_size, uint8_t packet_flags = 0) {
+    PacketHeader packet_header;
+    packet_header.magic_number = magic_number;
+    packet_header.body_size = (body_size & PACKET_BODY_SIZE_MASK) |
+        (static_cast<uint32_t>(packet_type) << PACKET_TYPE_SHIFT) |
+        ((static_cast<uint32_t>(packet_flags) & PACKET_FLAGS_MASK) << PACKET_FLAGS_SHIFT);
+
+    return packet_header;
+}
+
+/*
+    Frame acknowledgement (8bytes)
+*/
+enum class FrameAckFlag : uint32_t {
+    None                = 0,
+    KeyframeRequest     = 1 << 0,   // The client cannot decode deltas, send a full frame
+};
+
+struct FrameAck {
+    uint32_t    timestamp;
+    uint32_t    flags;
+};
+
+static_assert(sizeof(FrameAck) == 8);
+
+/*
+    Input command (12bytes)
+
+    The buttons held during one client tick. Sequence numbers increase by
+    one per tick, client_time_ms is the client clock when the tick ended
+*/
+enum class InputButton : uint32_t {
+    None    = 0,
+    Left    = 1 << 0,
+    Right   = 1 << 1,
+    Up      = 1 << 2,
+    Down    = 1 << 3,
+};
+
+struct InputCommand {
+    uint32_t    sequence;
+    uint32_t    client_time_ms;
+    uint32_t    buttons;        // InputButton bits
+};
+
+static_assert(sizeof(InputCommand) == 12);
+
+/*
+    Resume request (8bytes)
+
+    Sent right after a reconnect, so the server can answer with a keyframe
+    at once instead of treating the client as a new one
+*/
+enum class ResumeFlag : uint32_t {
+    None                = 0,
+    HasLastFrame        = 1 << 0,   // last_timestamp is valid, the client received frames before
+};
+
+struct ResumeRequest {
+    uint32_t    last_timestamp; // Frame::timestamp of the last frame the client received
+    uint32_t    flags;
+};
+
+static_assert(sizeof(ResumeRequest) == 8);
+
+/*
+    Clock synchronization request (16bytes)
+
+    client_time_us is opaque to the server and echoed back in the pong
+*/
+struct ClockPing {
+    uint32_t    sequence;
+    uint32_t    reserved;
+    uint64_t    client_time_us;
+};
+
+static_assert(sizeof(ClockPing) == 16);
+
+/*
+    Clock synchronization answer (24bytes)
+
+    The server times use the clock of Frame::timestamp, taken when the
+    ping was received and when the pong was sent
+*/
+struct ClockPong {
+    uint32_t    sequence;
+    uint32_t    server_receive_time;
+    uint32_t    server_send_time;
+    uint32_t    reserved;
+    uint64_t    client_time_us;
+};
+
+static_assert(sizeof(ClockPong) == 24);
+
 /*
     Position (8bytes)
 */
@@ -196,4 +360,68 @@ struct Frame {
     std::vector<Item>       item_vector;
 };
 
-constexpr size_t FRAME_OBJECT_FIXED_HEADER_SIZE = 16;
\ No newline at end of file
+constexpr size_t FRAME_OBJECT_FIXED_HEADER_SIZE = 16;
+
+/*
+    Hello (8bytes)
+
+    The packet header has no room for a version, so the protocol version is
+    agreed on once per connection: both sides announce the range they speak
+    and use the newest version in common. A peer that never sends a Hello
+    speaks version 1
+
+    Version 2 adds PacketType::FrameBatch
+    Version 3 adds the capabilities and PacketType::LodReport
+*/
+constexpr uint16_t PACKET_PROTOCOL_VERSION      = 3;
+constexpr uint16_t PACKET_MIN_PROTOCOL_VERSION  = 1;
+
+enum class PeerCapability : uint32_t {
+    None            = 0,
+    LevelOfDetail   = 1 << 0,   // The client sends LodReports, the server reduces its frames accordingly
+};
+
+inline bool has_peer_capability(uint32_t capabilities, PeerCapability capability) {
+    return (capabilities & static_cast<uint32_t>(capability)) != 0;
+}
+
+struct Hello {
+    uint16_t    protocol_version;       // Newest version the sender speaks
+    uint16_t    min_protocol_version;   // Oldest version the sender still speaks
+    uint32_t    capabilities;           // PeerCapability bits, zero before version 3
+};
+
+static_assert(sizeof(Hello) == 8);
+
+/*
+    Level of detail report (20bytes)
+
+    Sent periodically by a client that announced PeerCapability::LevelOfDetail.
+    The server keeps at most max_bullets bullets in the frames for this
+    client and may also apply the reductions allowed by the flags. The
+    measured times are informational, the client already derived
+    max_bullets from them
+*/
+enum class LodFlag : uint16_t {
+    None                = 0,
+    CullOutsideView     = 1 << 0,   // Bullets outside the view rectangle may be dropped
+    QuantizeBullets     = 1 << 1,   // Bullet positions and velocities may be rounded
+};
+
+inline bool has_lod_flag(uint16_t lod_flags, LodFlag lod_flag) {
+    return (lod_flags & static_cast<uint16_t>(lod_flag)) != 0;
+}
+
+struct LodReport {
+    uint32_t    max_bullets;        // Zero means no limit
+    uint16_t    decode_budget_us;   // Time the client can spend per frame
+    uint16_t    render_budget_us;
+    uint16_t    decode_time_us;     // Measured average per frame since the last report
+    uint16_t    render_time_us;
+    uint16_t    view_width;         // The playfield the client draws, from (0, 0)
+    uint16_t    view_height;
+    uint16_t    flags;              // LodFlag bits
+    uint16_t    reserved;
+};
+
+static_assert(sizeof(LodReport) == 20);
\ No newline at end of file
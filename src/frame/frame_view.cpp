@@ -0,0 +1,113 @@
+#include "frame_view.hpp"
+#include "frame_layout.hpp"
+
+namespace {
+    template <typename T>
+    bool read_t(T* dest, const std::byte*& offset, const std::byte* end) {
+        if (static_cast<size_t>(end - offset) < sizeof(T))
+        {
+            return false;
+        }
+
+        memcpy(dest, offset, sizeof(T));
+        offset += sizeof(T);
+
+        return true;
+    }
+
+    template <typename T>
+    PackedArrayView<T> make_array_view(const std::vector<T>& objects) {
+        return PackedArrayView<T>(reinterpret_cast<const std::byte*>(objects.data()), objects.size());
+    }
+
+    template <typename T>
+    bool read_array_view(PackedArrayView<T>* dest, const std::byte*& offset, const std::byte* end) {
+        uint32_t count = 0;
+
+        if (!read_t(&count, offset, end))
+        {
+            return false;
+        }
+
+        // Division avoids overflow of count * sizeof(T) on 32-bit targets
+        if (static_cast<size_t>(end - offset) / sizeof(T) < count)
+        {
+            return false;
+        }
+
+        *dest = PackedArrayView<T>(offset, count);
+        offset += dest->size_bytes();
+
+        return true;
+    }
+
+    /*
+        Reads the arrays of FRAME_ARRAYS in order. Recursion instead of a
+        capturing lambda, which would keep the view out of registers
+    */
+    template <size_t Index = 0>
+    bool read_array_views(FrameView& frame_view, const std::byte*& offset, const std::byte* end) {
+        if constexpr (Index == std::tuple_size_v<decltype(FRAME_ARRAYS)>)
+        {
+            return true;
+        }
+        else
+        {
+            using Array = std::tuple_element_t<Index, std::decay_t<decltype(FRAME_ARRAYS)>>;
+
+            return read_array_view(&(frame_view.*Array::view), offset, end) &&
+                read_array_views<Index + 1>(frame_view, offset, end);
+        }
+    }
+}
+
+std::optional<FrameView> parse_frame_view(const std::byte* bytes, size_t size) {
+    FrameView frame_view = {};
+    auto bytes_offset = bytes;
+    const auto bytes_end = bytes + size;
+
+    auto succeed = read_t(&frame_view.header, bytes_offset, bytes_end) &&
+        read_t(&frame_view.stage, bytes_offset, bytes_end) &&
+        read_array_views(frame_view, bytes_offset, bytes_end);
+
+    if (!succeed)
+    {
+        return std::nullopt;
+    }
+
+    return frame_view;
+}
+
+FrameView make_frame_view(const Frame& frame) {
+    FrameView frame_view = {};
+
+    frame_view.header = make_fixed_header(frame);
+    frame_view.stage = frame.stage;
+
+    for_each_descriptor(FRAME_ARRAYS, [&](const auto& array) {
+        frame_view.*array.view = make_array_view(frame.*array.objects);
+    });
+
+    return frame_view;
+}
+
+Frame frame_view_to_frame(const FrameView& frame_view) {
+    Frame frame = {};
+    frame_view_to_frame(frame_view, frame);
+
+    return frame;
+}
+
+void frame_view_to_frame(const FrameView& frame_view, Frame& frame) {
+    read_fixed_header(frame_view.header, frame);
+
+    frame.stage = frame_view.stage;
+
+    for_each_descriptor(FRAME_ARRAYS, [&](const auto& array) {
+        frame.*array.count = static_cast<uint32_t>((frame_view.*array.view).size());
+    });
+
+    for_each_descriptor(FRAME_ARRAYS, [&](const auto& array) {
+        (frame_view.*array.view).copy_to(frame.*array.objects);
+    });
+}
\ No newline at end of file
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <vector>
+#include <cstddef>
+#include <cstring>
+#include <iterator>
+#include <optional>
+#include <type_traits>
+#include "frame_template.hpp"
+
+/*
+    Fixed header of the frame object (16bytes)
+
+    The wire image of the header fields at the start of Frame, see
+    make_fixed_header(). frame_layout.hpp checks every member against
+    FRAME_HEADER_FIELDS, so the two cannot drift apart
+*/
+struct FrameFixedHeader {
+    uint8_t     client_id;
+    uint8_t     opponent_id;
+    uint8_t     mode;
+    uint8_t     state;
+
+    uint32_t    timestamp;
+    uint32_t    score;
+
+    uint8_t     difficulty;
+    uint8_t     reserved_01;    // Reserved area
+    uint8_t     reserved_02;    // Reserved area
+    uint8_t     reserved_03;    // Reserved area
+};
+
+static_assert(sizeof(FrameFixedHeader) == FRAME_OBJECT_FIXED_HEADER_SIZE);
+
+/*
+    Read-only view over an array of objects inside a serialized frame.
+
+    The objects sit at arbitrary offsets in the packet buffer, so they are
+    never accessed through a T* (that would be a misaligned access).
+    Elements are returned by value through memcpy instead, which compiles
+    down to plain unaligned loads
+*/
+template <typename T>
+class PackedArrayView {
+    static_assert(std::is_trivially_copyable_v<T>, "T must be trivially copyable");
+
+public:
+    class Iterator {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type        = T;
+        using difference_type   = std::ptrdiff_t;
+        using pointer           = void;
+        using reference         = T;
+
+        Iterator(const std::byte* position) : m_position(position) {}
+
+        T operator*() const {
+            T value;
+            memcpy(&value, m_position, sizeof(T));
+
+            return value;
+        }
+
+        Iterator& operator++() {
+            m_position += sizeof(T);
+
+            return *this;
+        }
+
+        bool operator==(const Iterator& other) const { return m_position == other.m_position; }
+        bool operator!=(const Iterator& other) const { return m_position != other.m_position; }
+
+    private:
+        const std::byte* m_position;
+    };
+
+    PackedArrayView() : m_data(nullptr), m_count(0) {}
+    PackedArrayView(const std::byte* data, size_t count) : m_data(data), m_count(count) {}
+
+    size_t size() const { return m_count; }
+    size_t size_bytes() const { return m_count * sizeof(T); }
+    bool empty() const { return m_count == 0; }
+    const std::byte* data() const { return m_data; }
+
+    T operator[](size_t index) const {
+        T value;
+        memcpy(&value, m_data + index * sizeof(T), sizeof(T));
+
+        return value;
+    }
+
+    Iterator begin() const { return Iterator(m_data); }
+    Iterator end() const { return Iterator(m_data + size_bytes()); }
+
+    // Copy all objects into a vector, reusing its capacity
+    void copy_to(std::vector<T>& dest) const {
+        dest.resize(m_count);
+
+        if (m_count > 0)
+        {
+            memcpy(dest.data(), m_data, size_bytes());
+        }
+    }
+
+private:
+    const std::byte*    m_data;
+    size_t              m_count;
+};
+
+/*
+    Non-owning view of a serialized frame
+
+    The fixed header and the stage are copied (24 bytes), every object
+    array points directly into the source buffer, so the view is only
+    valid as long as that buffer is left untouched
+*/
+struct FrameView {
+    FrameFixedHeader            header;
+    Stage                       stage;
+
+    PackedArrayView<Player>     players;
+    PackedArrayView<Enemy>      enemies;
+    PackedArrayView<Boss>       bosses;
+    PackedArrayView<Bullet>     bullets;
+    PackedArrayView<Item>       items;
+};
+
+// Validates the layout of the serialized frame and builds a view over it
+std::optional<FrameView> parse_frame_view(const std::byte* bytes, size_t size);
+
+// Builds a view over an owning frame, valid as long as the frame is not modified
+FrameView make_frame_view(const Frame& frame);
+
+// Creates an owning copy of the viewed frame
+Frame frame_view_to_frame(const FrameView& frame_view);
+void frame_view_to_frame(const FrameView& frame_view, Frame& frame);
\ No newline at end of file
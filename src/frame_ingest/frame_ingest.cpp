@@ -0,0 +1,229 @@
+#include "frame_ingest.hpp"
+#include "../allocation_counter/allocation_counter.hpp"
+
+namespace {
+    // Upper bound on how long the ingest thread waits before checking m_running again
+    constexpr auto INGEST_WAKEUP_INTERVAL = std::chrono::milliseconds(100);
+
+    // Upper bound on how long submitted input waits for the ingest thread
+    constexpr auto INPUT_WAKEUP_INTERVAL = std::chrono::milliseconds(4);
+
+    // Input ticks the render loop may get ahead of the ingest thread
+    constexpr size_t INPUT_QUEUE_CAPACITY = 64;
+}
+
+FrameIngestThread::FrameIngestThread(
+    std::string_view server_addr,
+    uint16_t server_port,
+    uint32_t magic_number,
+    uint32_t max_packet_size,
+    FrameDeliveryMode delivery_mode,
+    size_t queue_capacity)
+    : m_stream(server_addr, server_port, magic_number, max_packet_size)
+    , m_delivery_mode(delivery_mode)
+    , m_queue(delivery_mode == FrameDeliveryMode::Ordered ? queue_capacity : 1)
+    , m_staging_frame()
+    , m_clock_samples(0)
+    , m_input_queue(INPUT_QUEUE_CAPACITY)
+    , m_input_submitted(false)
+    , m_running(false)
+    , m_frames_published(0)
+    , m_frames_taken(0)
+    , m_frames_superseded(0)
+    , m_frames_dropped(0)
+    , m_inputs_dropped(0)
+    , m_heap_allocations(0)
+{
+    // Superseded frames would only be replaced in the mailbox, so they are not even decoded
+    m_stream.set_catch_up_enabled(delivery_mode == FrameDeliveryMode::Latest);
+}
+
+FrameIngestThread::~FrameIngestThread() {
+    stop();
+}
+
+bool FrameIngestThread::start(std::chrono::milliseconds connect_timeout) {
+    // Already started
+    if (m_running.exchange(true))
+    {
+        return true;
+    }
+
+    if (!m_stream.connect_to_server(connect_timeout))
+    {
+        m_running = false;
+
+        return false;
+    }
+
+    m_thread = std::thread(&FrameIngestThread::ingest_loop, this);
+
+    return true;
+}
+
+void FrameIngestThread::stop() {
+    m_running = false;
+
+    // Wake the ingest thread up if it is blocked in recv
+    m_stream.interrupt();
+
+    if (m_thread.joinable())
+    {
+        m_thread.join();
+    }
+
+    m_stream.disconnect();
+}
+
+bool FrameIngestThread::is_running() const {
+    return m_running;
+}
+
+bool FrameIngestThread::try_take_frame(Frame& frame) {
+    bool taken = m_delivery_mode == FrameDeliveryMode::Latest
+        ? m_mailbox.try_take(frame)
+        : m_queue.try_pop(frame);
+
+    if (taken)
+    {
+        m_frames_taken.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    return taken;
+}
+
+void FrameIngestThread::set_clock_sync_interval(std::chrono::milliseconds interval) {
+    m_stream.set_clock_sync_interval(interval);
+}
+
+void FrameIngestThread::set_reconnect_options(const ReconnectOptions& options) {
+    m_stream.set_reconnect_options(options);
+}
+
+bool FrameIngestThread::try_take_clock_estimate(ClockEstimate& estimate) {
+    return m_clock_mailbox.try_take(estimate);
+}
+
+void FrameIngestThread::set_level_of_detail(const LodOptions& options) {
+    m_stream.set_level_of_detail(options);
+}
+
+void FrameIngestThread::report_render_time(std::chrono::nanoseconds render_time, uint32_t bullet_count) {
+    m_render_totals.time += render_time;
+    m_render_totals.bullets += bullet_count;
+    m_render_totals.frames++;
+
+    m_render_mailbox.back_slot() = m_render_totals;
+    m_render_mailbox.publish();
+}
+
+void FrameIngestThread::submit_input(uint32_t buttons) {
+    if (!m_input_queue.try_push(buttons))
+    {
+        m_inputs_dropped.fetch_add(1, std::memory_order_relaxed);
+
+        return;
+    }
+
+    m_input_submitted.store(true, std::memory_order_relaxed);
+}
+
+FrameIngestStats FrameIngestThread::stats() const {
+    FrameIngestStats stats;
+
+    stats.frames_published  = m_frames_published.load(std::memory_order_relaxed);
+    stats.frames_taken      = m_frames_taken.load(std::memory_order_relaxed);
+    stats.frames_superseded = m_frames_superseded.load(std::memory_order_relaxed);
+    stats.frames_dropped    = m_frames_dropped.load(std::memory_order_relaxed);
+    stats.inputs_dropped    = m_inputs_dropped.load(std::memory_order_relaxed);
+    stats.heap_allocations  = m_heap_allocations.load(std::memory_order_relaxed);
+
+    return stats;
+}
+
+void FrameIngestThread::ingest_loop() {
+    while (m_running)
+    {
+        send_pending_input();
+
+        const auto wakeup_interval = m_input_submitted.load(std::memory_order_relaxed)
+            ? INPUT_WAKEUP_INTERVAL
+            : INGEST_WAKEUP_INTERVAL;
+
+        const auto allocations_before = thread_allocation_count();
+        auto frame_view_opt = m_stream.wait_for_frame_view(SocketClock::now() + wakeup_interval);
+
+        if (frame_view_opt)
+        {
+            publish(frame_view_opt.value());
+        }
+
+        m_heap_allocations.fetch_add(thread_allocation_count() - allocations_before, std::memory_order_relaxed);
+
+        // Published only when a pong came in, the estimate is a plain value
+        if (m_stream.clock_sync().sample_count() != m_clock_samples)
+        {
+            m_clock_samples = m_stream.clock_sync().sample_count();
+            m_clock_mailbox.back_slot() = m_stream.clock_sync().estimate();
+            m_clock_mailbox.publish();
+        }
+
+        RenderTotals render_totals;
+
+        if (m_render_mailbox.try_take(render_totals) && render_totals.frames > m_forwarded_render_totals.frames)
+        {
+            m_stream.record_render_time(
+                render_totals.time - m_forwarded_render_totals.time,
+                render_totals.bullets - m_forwarded_render_totals.bullets,
+                static_cast<uint32_t>(render_totals.frames - m_forwarded_render_totals.frames)
+            );
+
+            m_forwarded_render_totals = render_totals;
+        }
+
+        // The server closed the connection for good or stop() interrupted us
+        if (!frame_view_opt && !m_stream.is_connected() && !m_stream.is_reconnecting())
+        {
+            break;
+        }
+    }
+
+    m_running = false;
+}
+
+void FrameIngestThread::publish(const FrameView& frame_view) {
+    if (m_delivery_mode == FrameDeliveryMode::Latest)
+    {
+        // Decode straight into the mailbox slot, reusing its vectors
+        frame_view_to_frame(frame_view, m_mailbox.back_slot());
+
+        if (m_mailbox.publish())
+        {
+            m_frames_superseded.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+    else
+    {
+        frame_view_to_frame(frame_view, m_staging_frame);
+
+        if (!m_queue.try_push(m_staging_frame))
+        {
+            m_frames_dropped.fetch_add(1, std::memory_order_relaxed);
+
+            return;
+        }
+    }
+
+    m_frames_published.fetch_add(1, std::memory_order_relaxed);
+}
+
+void FrameIngestThread::send_pending_input() {
+    uint32_t buttons = 0;
+
+    // One command per tick, a tick recorded while disconnected is merged into the next one
+    while (m_input_queue.try_pop(buttons))
+    {
+        m_input_channel.record(buttons);
+        m_stream.send_input(m_input_channel);
+    }
+}
\ No newline at end of file
@@ -0,0 +1,140 @@
+#pragma once
+
+#include <atomic>
+#include <thread>
+#include "spsc_queue.hpp"
+#include "latest_mailbox.hpp"
+#include "../packet_stream/packet_stream.hpp"
+
+enum class FrameDeliveryMode {
+    Latest,     // Only the newest frame is kept, older ones are superseded
+    Ordered,    // Every frame is delivered in order until the queue is full
+};
+
+struct FrameIngestStats {
+    uint64_t frames_published   = 0;
+    uint64_t frames_taken       = 0;
+
+    // Frames replaced in the mailbox before the render thread took them
+    uint64_t frames_superseded  = 0;
+
+    // Frames dropped because the ordered queue was full
+    uint64_t frames_dropped     = 0;
+
+    // Input ticks dropped because the ingest thread fell behind, see submit_input()
+    uint64_t inputs_dropped     = 0;
+
+    /*
+        Heap allocations of the ingest thread while receiving and publishing
+        frames, only counted with BULLET_HELL_COUNT_ALLOCATIONS (see allocation_counter.hpp).
+        Stops growing once the recycled frames have reached their final capacity
+    */
+    uint64_t heap_allocations   = 0;
+};
+
+/*
+    Runs a PacketStreamClient on a background thread and publishes decoded
+    frames to a single consumer (the render loop) without any locks.
+    The consumer side never touches the socket and never blocks
+*/
+class FrameIngestThread {
+public:
+    FrameIngestThread(
+        std::string_view server_addr,
+        uint16_t server_port,
+        uint32_t magic_number,
+        uint32_t max_packet_size,
+        FrameDeliveryMode delivery_mode = FrameDeliveryMode::Latest,
+        size_t queue_capacity = 64
+    );
+    ~FrameIngestThread();
+
+    // Disable the copy constructor and copy assignment operator
+    FrameIngestThread(const FrameIngestThread&) = delete;
+    FrameIngestThread& operator=(const FrameIngestThread&) = delete;
+
+    /*
+        Connects to the server and starts the ingest thread. A timeout of
+        zero lets the connect block for as long as the system allows
+    */
+    bool start(std::chrono::milliseconds connect_timeout = std::chrono::milliseconds::zero());
+    void stop();
+    bool is_running() const;
+
+    /*
+        Consumer side, never blocks. On success the previous content of frame
+        is handed back to the ingest thread so its capacity can be reused
+    */
+    bool try_take_frame(Frame& frame);
+
+    // Pings the server for clock synchronization, see PacketStreamClient. Call before start()
+    void set_clock_sync_interval(std::chrono::milliseconds interval);
+
+    // Keeps the ingest thread running across connection losses. Call before start()
+    void set_reconnect_options(const ReconnectOptions& options);
+
+    // Consumer side, never blocks. Returns true if the estimate changed since the last call
+    bool try_take_clock_estimate(ClockEstimate& estimate);
+
+    // Lets the server reduce the frames to what the client can handle, see PacketStreamClient. Call before start()
+    void set_level_of_detail(const LodOptions& options);
+
+    /*
+        Consumer side, never blocks. How long drawing a frame with bullet_count
+        bullets took, the ingest thread passes it on to the level of detail
+    */
+    void report_render_time(std::chrono::nanoseconds render_time, uint32_t bullet_count);
+
+    /*
+        Consumer side, never blocks. The buttons (InputButton bits) held
+        during this tick of the render loop, the ingest thread sends them
+        as one input command. Once input was submitted the ingest thread
+        wakes up at least every INPUT_WAKEUP_INTERVAL to send it
+    */
+    void submit_input(uint32_t buttons);
+
+    FrameIngestStats stats() const;
+
+private:
+    void ingest_loop();
+    void publish(const FrameView& frame_view);
+    void send_pending_input();
+
+    PacketStreamClient      m_stream;
+    FrameDeliveryMode       m_delivery_mode;
+
+    LatestMailbox<Frame>    m_mailbox;
+    SpscQueue<Frame>        m_queue;
+    Frame                   m_staging_frame;    // Only used in ordered mode
+
+    LatestMailbox<ClockEstimate> m_clock_mailbox;
+    uint64_t                m_clock_samples;    // Owned by the ingest thread
+
+    /*
+        Running totals of the render thread, so a report that is replaced
+        in the mailbox is not lost. The ingest thread passes on the difference
+    */
+    struct RenderTotals {
+        std::chrono::nanoseconds    time    = std::chrono::nanoseconds::zero();
+        uint64_t                    bullets = 0;
+        uint64_t                    frames  = 0;
+    };
+
+    LatestMailbox<RenderTotals> m_render_mailbox;
+    RenderTotals            m_render_totals;    // Owned by the render thread
+    RenderTotals            m_forwarded_render_totals;  // Owned by the ingest thread
+
+    SpscQueue<uint32_t>     m_input_queue;
+    InputChannel            m_input_channel;    // Owned by the ingest thread
+    std::atomic<bool>       m_input_submitted;
+
+    std::thread             m_thread;
+    std::atomic<bool>       m_running;
+
+    std::atomic<uint64_t>   m_frames_published;
+    std::atomic<uint64_t>   m_frames_taken;
+    std::atomic<uint64_t>   m_frames_superseded;
+    std::atomic<uint64_t>   m_frames_dropped;
+    std::atomic<uint64_t>   m_inputs_dropped;
+    std::atomic<uint64_t>   m_heap_allocations;
+};
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <utility>
+
+/*
+    Lock-free single-producer/single-consumer "latest wins" mailbox
+
+    This is a triple buffer: the producer fills its back slot and swaps
+    it with the middle slot, the consumer swaps the middle slot with its
+    front slot. Neither side ever waits, and a value that is published
+    twice before the consumer looks at it is simply replaced
+*/
+template <typename T>
+class LatestMailbox {
+public:
+    LatestMailbox()
+        : m_back(0)
+        , m_middle(1)
+        , m_front(2)
+    {}
+
+    // Disable the copy constructor and copy assignment operator
+    LatestMailbox(const LatestMailbox&) = delete;
+    LatestMailbox& operator=(const LatestMailbox&) = delete;
+
+    // Producer side, the slot to fill before calling publish()
+    T& back_slot() {
+        return m_slots[m_back];
+    }
+
+    // Returns true if the previously published value was never taken
+    bool publish() {
+        auto previous = m_middle.exchange(
+            static_cast<uint8_t>(m_back | DIRTY_BIT),
+            std::memory_order_acq_rel
+        );
+
+        m_back = previous & INDEX_MASK;
+
+        return (previous & DIRTY_BIT) != 0;
+    }
+
+    // Consumer side, the previous content of value is recycled into the mailbox
+    bool try_take(T& value) {
+        if ((m_middle.load(std::memory_order_relaxed) & DIRTY_BIT) == 0)
+        {
+            return false;
+        }
+
+        auto previous = m_middle.exchange(m_front, std::memory_order_acq_rel);
+        m_front = previous & INDEX_MASK;
+
+        std::swap(m_slots[m_front], value);
+
+        return true;
+    }
+
+private:
+    static constexpr uint8_t INDEX_MASK = 0x03;
+    static constexpr uint8_t DIRTY_BIT  = 0x04;
+
+    std::array<T, 3>        m_slots;
+
+    uint8_t                 m_back;     // Owned by the producer
+    std::atomic<uint8_t>    m_middle;   // Shared, index and dirty bit
+    uint8_t                 m_front;    // Owned by the consumer
+};
\ No newline at end of file
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <cstddef>
+#include <utility>
+
+/*
+    Bounded lock-free single-producer/single-consumer queue
+
+    All slots are constructed up front and values are exchanged with
+    std::swap instead of being moved out, so objects that own heap memory
+    (e.g., Frame) hand their capacity back to the other side instead of
+    freeing it
+*/
+template <typename T>
+class SpscQueue {
+public:
+    SpscQueue(size_t min_capacity)
+        : m_slots(round_up_to_power_of_two(min_capacity))
+        , m_mask(m_slots.size() - 1)
+        , m_head(0)
+        , m_tail(0)
+    {}
+
+    // Disable the copy constructor and copy assignment operator
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer side, value receives the previous content of the slot
+    bool try_push(T& value) {
+        const auto tail = m_tail.load(std::memory_order_relaxed);
+
+        if (tail - m_head.load(std::memory_order_acquire) == m_slots.size())
+        {
+            return false;
+        }
+
+        std::swap(m_slots[tail & m_mask], value);
+        m_tail.store(tail + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    // Consumer side, the previous content of value is recycled into the slot
+    bool try_pop(T& value) {
+        const auto head = m_head.load(std::memory_order_relaxed);
+
+        if (head == m_tail.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+
+        std::swap(m_slots[head & m_mask], value);
+        m_head.store(head + 1, std::memory_order_release);
+
+        return true;
+    }
+
+    size_t capacity() const {
+        return m_slots.size();
+    }
+
+private:
+    static size_t round_up_to_power_of_two(size_t value) {
+        size_t result = 1;
+
+        while (result < value)
+        {
+            result <<= 1;
+        }
+
+        return result;
+    }
+
+    std::vector<T>  m_slots;
+    size_t          m_mask;
+
+    // Keep the cursors on separate cache lines to avoid false sharing
+    alignas(64) std::atomic<size_t> m_head;
+    alignas(64) std::atomic<size_t> m_tail;
+};
\ No newline at end of file
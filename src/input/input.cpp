@@ -0,0 +1,120 @@
+#include <cstring>
+#include <algorithm>
+#include "input.hpp"
+#include "../frame/frame_serializer.hpp"
+
+namespace {
+    constexpr size_t COMMAND_COUNT_SIZE = sizeof(uint32_t);
+
+    // Serial number arithmetic, survives the wrap around of the sequence number
+    bool is_newer_sequence(uint32_t sequence, uint32_t other) {
+        return static_cast<int32_t>(sequence - other) > 0;
+    }
+}
+
+InputChannel::InputChannel(size_t redundancy)
+    : m_redundancy(std::min(redundancy, INPUT_MAX_COMMANDS - 1))
+    , m_epoch(InputClock::now())
+    , m_recorded(false)
+    , m_buttons(0)
+    , m_next_sequence(0)
+{
+    m_history.reserve(m_redundancy + 1);
+    m_body.reserve(COMMAND_COUNT_SIZE + INPUT_MAX_COMMANDS * sizeof(InputCommand));
+}
+
+void InputChannel::record(uint32_t buttons) {
+    m_buttons |= buttons;
+    m_recorded = true;
+}
+
+bool InputChannel::flush(std::vector<std::byte>& bytes, uint32_t magic_number) {
+    if (!m_recorded)
+    {
+        return false;
+    }
+
+    InputCommand command;
+    command.sequence = m_next_sequence++;
+    command.client_time_ms = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::milliseconds>(InputClock::now() - m_epoch).count());
+    command.buttons = m_buttons;
+
+    if (m_history.size() > m_redundancy)
+    {
+        m_history.erase(m_history.begin());
+    }
+
+    m_history.push_back(command);
+
+    const auto command_count = static_cast<uint32_t>(m_history.size());
+
+    m_body.resize(COMMAND_COUNT_SIZE + m_history.size() * sizeof(InputCommand));
+    memcpy(m_body.data(), &command_count, COMMAND_COUNT_SIZE);
+    memcpy(m_body.data() + COMMAND_COUNT_SIZE, m_history.data(), m_history.size() * sizeof(InputCommand));
+
+    append_packet(bytes, magic_number, PacketType::Input, m_body.data(), m_body.size());
+
+    m_recorded = false;
+    m_buttons = 0;
+
+    return true;
+}
+
+uint32_t InputChannel::next_sequence() const {
+    return m_next_sequence;
+}
+
+InputReceiver::InputReceiver()
+    : m_has_received(false)
+    , m_last_sequence(0)
+{}
+
+bool InputReceiver::receive(const std::byte* body, size_t body_size, std::vector<InputCommand>& commands) {
+    m_stats.packets++;
+
+    uint32_t command_count = 0;
+
+    if (body_size >= COMMAND_COUNT_SIZE)
+    {
+        memcpy(&command_count, body, COMMAND_COUNT_SIZE);
+    }
+
+    if (command_count == 0 ||
+        command_count > INPUT_MAX_COMMANDS ||
+        body_size != COMMAND_COUNT_SIZE + command_count * sizeof(InputCommand))
+    {
+        m_stats.malformed_packets++;
+
+        return false;
+    }
+
+    for (uint32_t i = 0; i < command_count; i++)
+    {
+        InputCommand command;
+        memcpy(&command, body + COMMAND_COUNT_SIZE + i * sizeof(InputCommand), sizeof(InputCommand));
+
+        if (m_has_received && !is_newer_sequence(command.sequence, m_last_sequence))
+        {
+            m_stats.redundant_commands++;
+
+            continue;
+        }
+
+        if (m_has_received)
+        {
+            m_stats.lost_commands += command.sequence - m_last_sequence - 1;
+        }
+
+        commands.push_back(command);
+
+        m_has_received = true;
+        m_last_sequence = command.sequence;
+        m_stats.commands++;
+    }
+
+    return true;
+}
+
+const InputReceiverStats& InputReceiver::stats() const {
+    return m_stats;
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <chrono>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "../frame/frame_template.hpp"
+
+/*
+    Input packet body (PacketType::Input)
+
+    [4bytes]        Number of commands N, 1 to INPUT_MAX_COMMANDS
+    [N * 12bytes]   InputCommand with consecutive sequence numbers, oldest first
+
+    Every packet repeats the commands of the previous ticks, so a packet
+    that is lost or arrives late is covered by the next one
+*/
+constexpr size_t INPUT_MAX_COMMANDS = 16;
+
+inline uint32_t input_buttons(InputButton button) {
+    return static_cast<uint32_t>(button);
+}
+
+/*
+    Client side of the input channel
+
+    record() may be called any number of times during a tick, e.g., for
+    every keyboard event. Everything recorded until flush() is coalesced
+    into the single command of that tick, buttons pressed at any point of
+    the tick are kept so that a short tap is never lost
+*/
+class InputChannel {
+public:
+    // redundancy is the number of previous commands repeated in every packet
+    InputChannel(size_t redundancy = 3);
+
+    void record(uint32_t buttons);
+
+    /*
+        Ends the tick and appends its packet to bytes. Returns false, and
+        appends nothing, if nothing was recorded during the tick
+    */
+    bool flush(std::vector<std::byte>& bytes, uint32_t magic_number);
+
+    // Sequence number of the next command
+    uint32_t next_sequence() const;
+
+private:
+    using InputClock = std::chrono::steady_clock;
+
+    size_t                      m_redundancy;
+    InputClock::time_point      m_epoch;
+
+    bool                        m_recorded;
+    uint32_t                    m_buttons;
+    uint32_t                    m_next_sequence;
+
+    // The last commands sent, oldest first
+    std::vector<InputCommand>   m_history;
+    std::vector<std::byte>      m_body;
+};
+
+struct InputReceiverStats {
+    uint64_t packets            = 0;
+    uint64_t malformed_packets  = 0;
+
+    // New commands handed out, and repeated copies of commands already handed out
+    uint64_t commands           = 0;
+    uint64_t redundant_commands = 0;
+
+    // Sequence numbers that never arrived in any packet
+    uint64_t lost_commands      = 0;
+};
+
+/*
+    Server side of the input channel, hands out every command exactly once
+    and in order no matter how often it was repeated
+*/
+class InputReceiver {
+public:
+    InputReceiver();
+
+    // Appends the commands of the body that were not received before
+    bool receive(const std::byte* body, size_t body_size, std::vector<InputCommand>& commands);
+
+    const InputReceiverStats& stats() const;
+
+private:
+    bool                    m_has_received;
+    uint32_t                m_last_sequence;
+
+    InputReceiverStats      m_stats;
+};
\ No newline at end of file
@@ -0,0 +1,109 @@
+#include <algorithm>
+#include <limits>
+#include "latency_histogram.hpp"
+
+LatencyHistogram::LatencyHistogram()
+    : m_buckets{}
+    , m_count(0)
+    , m_sum(0)
+    , m_min(std::numeric_limits<uint64_t>::max())
+    , m_max(0)
+{}
+
+void LatencyHistogram::record(std::chrono::nanoseconds latency) {
+    // A timestamp taken on another clock can be slightly ahead
+    const auto value = static_cast<uint64_t>(std::max<int64_t>(latency.count(), 0));
+
+    m_buckets[bucket_index(value)]++;
+    m_count++;
+    m_sum += value;
+    m_min = std::min(m_min, value);
+    m_max = std::max(m_max, value);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram& other) {
+    for (size_t i = 0; i < BUCKET_COUNT; i++)
+    {
+        m_buckets[i] += other.m_buckets[i];
+    }
+
+    m_count += other.m_count;
+    m_sum += other.m_sum;
+    m_min = std::min(m_min, other.m_min);
+    m_max = std::max(m_max, other.m_max);
+}
+
+void LatencyHistogram::reset() {
+    *this = LatencyHistogram();
+}
+
+uint64_t LatencyHistogram::count() const {
+    return m_count;
+}
+
+std::chrono::nanoseconds LatencyHistogram::percentile(double fraction) const {
+    if (m_count == 0)
+    {
+        return std::chrono::nanoseconds::zero();
+    }
+
+    // The rank of the sample at the percentile, counted from 1
+    const auto rank = std::max<uint64_t>(static_cast<uint64_t>(std::clamp(fraction, 0.0, 1.0) * static_cast<double>(m_count) + 0.5), 1);
+    uint64_t seen = 0;
+
+    for (size_t i = 0; i < BUCKET_COUNT; i++)
+    {
+        seen += m_buckets[i];
+
+        if (seen >= rank)
+        {
+            // The bucket bound can lie beyond the largest sample, the last bucket has none
+            if (i == BUCKET_COUNT - 1)
+            {
+                return max();
+            }
+
+            return std::chrono::nanoseconds(std::min(bucket_upper_bound(i), m_max));
+        }
+    }
+
+    return max();
+}
+
+std::chrono::nanoseconds LatencyHistogram::min() const {
+    return std::chrono::nanoseconds(m_count > 0 ? m_min : 0);
+}
+
+std::chrono::nanoseconds LatencyHistogram::max() const {
+    return std::chrono::nanoseconds(m_max);
+}
+
+std::chrono::nanoseconds LatencyHistogram::mean() const {
+    return std::chrono::nanoseconds(m_count > 0 ? m_sum / m_count : 0);
+}
+
+size_t LatencyHistogram::bucket_index(uint64_t value) {
+    // The first two groups of sub-buckets are exact
+    if (value < 2 * SUB_BUCKET_COUNT)
+    {
+        return static_cast<size_t>(value);
+    }
+
+    const auto highest_bit = std::min<size_t>(static_cast<size_t>(63 - __builtin_clzll(value)), MAX_VALUE_BITS - 1);
+    const auto shift = highest_bit - SUB_BUCKET_BITS;
+    const auto sub_bucket = value >= (uint64_t(1) << MAX_VALUE_BITS) ? SUB_BUCKET_COUNT - 1 : static_cast<size_t>(value >> shift) & (SUB_BUCKET_COUNT - 1);
+
+    return (highest_bit - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT + sub_bucket;
+}
+
+uint64_t LatencyHistogram::bucket_upper_bound(size_t index) {
+    if (index < 2 * SUB_BUCKET_COUNT)
+    {
+        return index;
+    }
+
+    const auto shift = index / SUB_BUCKET_COUNT - 1;
+    const auto sub_bucket = index % SUB_BUCKET_COUNT;
+
+    return ((SUB_BUCKET_COUNT + sub_bucket + 1) << shift) - 1;
+}
\ No newline at end of file
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+/*
+    Log-linear histogram of latencies with nanosecond resolution
+
+    Latencies below 32ns get a bucket each, above that every power of two
+    is split into 16 buckets, so a reported percentile is at most 1/16th
+    above the true value. Fixed size and allocation-free, a plain value
+    that can be copied along with the stats it is part of. Latencies
+    beyond about 18 minutes are counted in the last bucket
+*/
+class LatencyHistogram {
+public:
+    LatencyHistogram();
+
+    void record(std::chrono::nanoseconds latency);
+    void merge(const LatencyHistogram& other);
+    void reset();
+
+    uint64_t count() const;
+
+    // Upper bound of the bucket holding the percentile, e.g., 0.99 for p99. Zero while empty
+    std::chrono::nanoseconds percentile(double fraction) const;
+
+    std::chrono::nanoseconds min() const;
+    std::chrono::nanoseconds max() const;
+    std::chrono::nanoseconds mean() const;
+
+private:
+    static constexpr size_t SUB_BUCKET_BITS = 4;
+    static constexpr size_t SUB_BUCKET_COUNT = 1 << SUB_BUCKET_BITS;
+    static constexpr size_t MAX_VALUE_BITS = 40;
+    static constexpr size_t BUCKET_COUNT = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) * SUB_BUCKET_COUNT;
+
+    static size_t bucket_index(uint64_t value);
+    static uint64_t bucket_upper_bound(size_t index);
+
+    std::array<uint64_t, BUCKET_COUNT>  m_buckets;
+    uint64_t                            m_count;
+    uint64_t                            m_sum;
+    uint64_t                            m_min;
+    uint64_t                            m_max;
+};
\ No newline at end of file
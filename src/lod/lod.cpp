@@ -0,0 +1,208 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include "lod.hpp"
+
+namespace {
+    // A limit cut because of an overrun aims at this share of the budget
+    constexpr double TARGET_LOAD = 0.85;
+
+    // The limit only grows while the busier stage stays below this share of its budget
+    constexpr double RAISE_LOAD = 0.6;
+
+    // Frames this close to the limit count as limited by it
+    constexpr double BINDING_FRACTION = 0.9;
+
+    // Quantized bullets move in eighths of a pixel
+    constexpr float BULLET_QUANTIZATION = 8.0f;
+
+    uint16_t saturate_us(std::chrono::microseconds time) {
+        return static_cast<uint16_t>(std::clamp<int64_t>(time.count(), 0, std::numeric_limits<uint16_t>::max()));
+    }
+
+    // Spreads consecutive ids evenly over the 32 bits (MurmurHash3 finalizer)
+    uint32_t bullet_id_hash(uint32_t id) {
+        id ^= id >> 16;
+        id *= 0x85EBCA6B;
+        id ^= id >> 13;
+        id *= 0xC2B2AE35;
+        id ^= id >> 16;
+
+        return id;
+    }
+
+    bool is_outside_view(const Bullet& bullet, float view_width, float view_height) {
+        return bullet.pos.x + bullet.radius < 0.0f || bullet.pos.x - bullet.radius > view_width ||
+            bullet.pos.y + bullet.radius < 0.0f || bullet.pos.y - bullet.radius > view_height;
+    }
+
+    float quantize(float value) {
+        return std::round(value * BULLET_QUANTIZATION) / BULLET_QUANTIZATION;
+    }
+}
+
+LodController::LodController(const LodOptions& options)
+    : m_options(options)
+    , m_bullet_limit(options.max_bullets)
+{}
+
+void LodController::record_decode_time(std::chrono::nanoseconds time, uint64_t bullet_count, uint32_t frame_count) {
+    m_decode.time += time;
+    m_decode.bullets += bullet_count;
+    m_decode.frames += frame_count;
+}
+
+void LodController::record_render_time(std::chrono::nanoseconds time, uint64_t bullet_count, uint32_t frame_count) {
+    m_render.time += time;
+    m_render.bullets += bullet_count;
+    m_render.frames += frame_count;
+}
+
+LodReport LodController::make_report() {
+    const double decode_load = stage_load(m_decode, m_options.decode_budget);
+    const double render_load = stage_load(m_render, m_options.render_budget);
+
+    // The stage furthest over its budget decides
+    if (decode_load >= render_load)
+    {
+        adapt_limit(m_decode, decode_load);
+    }
+    else
+    {
+        adapt_limit(m_render, render_load);
+    }
+
+    LodReport report = {};
+    report.max_bullets = m_bullet_limit;
+    report.decode_budget_us = saturate_us(m_options.decode_budget);
+    report.render_budget_us = saturate_us(m_options.render_budget);
+    report.decode_time_us = mean_time_us(m_decode);
+    report.render_time_us = mean_time_us(m_render);
+    report.view_width = m_options.view_width;
+    report.view_height = m_options.view_height;
+
+    if (m_options.view_width > 0 && m_options.view_height > 0)
+    {
+        report.flags |= static_cast<uint16_t>(LodFlag::CullOutsideView);
+    }
+
+    if (m_options.quantize_bullets)
+    {
+        report.flags |= static_cast<uint16_t>(LodFlag::QuantizeBullets);
+    }
+
+    m_decode = StageTimes();
+    m_render = StageTimes();
+
+    return report;
+}
+
+uint32_t LodController::bullet_limit() const {
+    return m_bullet_limit;
+}
+
+const LodOptions& LodController::options() const {
+    return m_options;
+}
+
+double LodController::stage_load(const StageTimes& stage, std::chrono::microseconds budget) {
+    if (stage.frames == 0 || budget <= std::chrono::microseconds::zero())
+    {
+        return 0.0;
+    }
+
+    const auto mean_time = static_cast<double>(stage.time.count()) / static_cast<double>(stage.frames);
+
+    return mean_time / static_cast<double>(std::chrono::nanoseconds(budget).count());
+}
+
+uint16_t LodController::mean_time_us(const StageTimes& stage) {
+    if (stage.frames == 0)
+    {
+        return 0;
+    }
+
+    return saturate_us(std::chrono::duration_cast<std::chrono::microseconds>(stage.time / stage.frames));
+}
+
+void LodController::adapt_limit(const StageTimes& stage, double load) {
+    if (stage.frames > 0)
+    {
+        const auto mean_bullets = static_cast<double>(stage.bullets) / static_cast<double>(stage.frames);
+
+        if (load > 1.0)
+        {
+            /*
+                Assumes the time grows linearly with the bullets. An overrun
+                with few bullets (an intro frame, a render hitch) would round
+                the target to zero, which the protocol reads as no limit
+            */
+            const auto target = std::max(
+                static_cast<uint32_t>(mean_bullets * TARGET_LOAD / load),
+                std::max<uint32_t>(m_options.min_bullets, 1)
+            );
+
+            m_bullet_limit = m_bullet_limit == 0 ? target : std::min(m_bullet_limit, target);
+        }
+        else if (load < RAISE_LOAD && m_bullet_limit != 0 && mean_bullets >= m_bullet_limit * BINDING_FRACTION)
+        {
+            m_bullet_limit += m_bullet_limit / 4;
+        }
+    }
+
+    if (m_bullet_limit != 0)
+    {
+        m_bullet_limit = std::max(m_bullet_limit, m_options.min_bullets);
+    }
+
+    if (m_options.max_bullets != 0 && (m_bullet_limit == 0 || m_bullet_limit > m_options.max_bullets))
+    {
+        m_bullet_limit = m_options.max_bullets;
+    }
+}
+
+size_t reduce_frame_detail(const Frame& frame, const LodReport& report, Frame& reduced) {
+    reduced = frame;
+
+    auto& bullets = reduced.bullet_vector;
+
+    if (has_lod_flag(report.flags, LodFlag::CullOutsideView) && report.view_width > 0 && report.view_height > 0)
+    {
+        const auto view_width = static_cast<float>(report.view_width);
+        const auto view_height = static_cast<float>(report.view_height);
+
+        bullets.erase(std::remove_if(bullets.begin(), bullets.end(), [&](const Bullet& bullet) {
+            return is_outside_view(bullet, view_width, view_height);
+        }), bullets.end());
+    }
+
+    if (report.max_bullets != 0 && bullets.size() > report.max_bullets)
+    {
+        // Keeps the share of the hash range that matches the ratio, the rest is cut off below
+        const auto threshold = (static_cast<uint64_t>(report.max_bullets) << 32) / bullets.size();
+
+        bullets.erase(std::remove_if(bullets.begin(), bullets.end(), [&](const Bullet& bullet) {
+            return bullet_id_hash(bullet.id) >= threshold;
+        }), bullets.end());
+
+        if (bullets.size() > report.max_bullets)
+        {
+            bullets.resize(report.max_bullets);
+        }
+    }
+
+    if (has_lod_flag(report.flags, LodFlag::QuantizeBullets))
+    {
+        for (auto& bullet : bullets)
+        {
+            bullet.pos.x = quantize(bullet.pos.x);
+            bullet.pos.y = quantize(bullet.pos.y);
+            bullet.vel.x = quantize(bullet.vel.x);
+            bullet.vel.y = quantize(bullet.vel.y);
+        }
+    }
+
+    reduced.bullet_count = static_cast<uint32_t>(bullets.size());
+
+    return frame.bullet_vector.size() - bullets.size();
+}
\ No newline at end of file
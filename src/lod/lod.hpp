@@ -0,0 +1,93 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include "../frame/frame_template.hpp"
+
+/*
+    Client-driven level of detail
+
+    A client that cannot decode or draw every bullet in time tells the
+    server how many it can take (see LodReport). LodController derives
+    that limit from the decode and render times the client measures, the
+    server applies it to each frame with reduce_frame_detail(). Only the
+    bullets are reduced, every other object matters for the game state
+*/
+
+// Oldest protocol version that carries capabilities and LodReports, see Hello
+constexpr uint16_t LOD_PROTOCOL_VERSION = 3;
+
+struct LodOptions {
+    // Time per frame the client may spend on each stage, zero leaves the stage unchecked
+    std::chrono::microseconds   decode_budget   = std::chrono::microseconds(2000);
+    std::chrono::microseconds   render_budget   = std::chrono::microseconds(8000);
+
+    // Upper bound independent of the measured times, zero means none
+    uint32_t                    max_bullets     = 0;
+
+    // The measured times never push the limit below this
+    uint32_t                    min_bullets     = 256;
+
+    // Lets the server drop bullets outside the view, see LodFlag::CullOutsideView. Zero disables culling
+    uint16_t                    view_width      = 0;
+    uint16_t                    view_height     = 0;
+
+    // Lets the server round bullet positions and velocities, see LodFlag::QuantizeBullets
+    bool                        quantize_bullets = false;
+
+    std::chrono::milliseconds   report_interval = std::chrono::milliseconds(250);
+};
+
+/*
+    Turns the times measured since the last report into a bullet limit.
+    A stage over its budget scales the limit down in proportion to the
+    overrun, while the limit is binding and both stages have plenty of
+    headroom it grows by a quarter per report. In between the limit is
+    left alone, so it does not oscillate around the budget
+*/
+class LodController {
+public:
+    explicit LodController(const LodOptions& options = LodOptions());
+
+    // The time spent on frame_count frames holding bullet_count bullets in total
+    void record_decode_time(std::chrono::nanoseconds time, uint64_t bullet_count, uint32_t frame_count = 1);
+    void record_render_time(std::chrono::nanoseconds time, uint64_t bullet_count, uint32_t frame_count = 1);
+
+    // Adjusts the limit to the times recorded since the last report and starts over
+    LodReport make_report();
+
+    // The limit sent with the last report, zero while there is none
+    uint32_t bullet_limit() const;
+
+    const LodOptions& options() const;
+
+private:
+    struct StageTimes {
+        std::chrono::nanoseconds    time    = std::chrono::nanoseconds::zero();
+        uint64_t                    bullets = 0;
+        uint64_t                    frames  = 0;
+    };
+
+    // Time of an average frame relative to the budget, zero without samples or budget
+    static double stage_load(const StageTimes& stage, std::chrono::microseconds budget);
+    static uint16_t mean_time_us(const StageTimes& stage);
+
+    void adapt_limit(const StageTimes& stage, double load);
+
+    LodOptions              m_options;
+    uint32_t                m_bullet_limit;
+
+    StageTimes              m_decode;
+    StageTimes              m_render;
+};
+
+/*
+    Server side, copies frame into reduced (reusing its capacity) with the
+    bullets reduced as the report asks: culled to the view if allowed,
+    thinned out to max_bullets and quantized if allowed. Thinning selects
+    bullets by a hash of their id, so a bullet that survives one frame
+    keeps surviving while the ratio holds instead of flickering.
+    Returns the number of bullets dropped
+*/
+size_t reduce_frame_detail(const Frame& frame, const LodReport& report, Frame& reduced);
\ No newline at end of file
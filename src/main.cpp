@@ -1,5 +1,6 @@
 #define SDL_MAIN_HANDLED
 
+#include <chrono>
 #include <iostream>
 #include <fstream>
 
@@ -18,6 +19,8 @@
 #include "mesh/mesh.hpp"
 #include "texture/texture2d.hpp"
 #include "shader/shader.hpp"
+#include "frame_ingest/frame_ingest.hpp"
+#include "config_constants.hpp"
 
 constexpr int SCREEN_WIDTH  = 600;
 constexpr int SCREEN_HEIGHT = 800;
@@ -29,6 +32,9 @@ constexpr std::string_view IMAGE_PATH           = "../images/zmon_2001.png";
 constexpr std::string_view VERTEX_SHADER_PATH   = "../glsl/vertex/vertex.glsl";
 constexpr std::string_view FRAGMENT_SHADER_PATH = "../glsl/fragment/fragment.glsl";
 
+// The game starts offline if the server does not answer in time
+constexpr auto SERVER_CONNECT_TIMEOUT = std::chrono::milliseconds(1000);
+
 // SDL
 bool g_sdl2_initialized = false;
 SDL_Window* g_window = NULL;
@@ -173,6 +179,34 @@ void draw_loop() {
 
     Mesh quad_mesh(quad_vertices, quad_indices, {3, 2});
 
+    /*
+        Frames are received and decoded on the ingest thread, the loop
+        below only takes the newest one and never waits for the socket
+    */
+    FrameIngestThread frame_ingest(
+        socket_constants::SERVER_ADDR,
+        socket_constants::SERVER_PORT,
+        socket_constants::SERVER_MAGIC_NUMBER,
+        socket_constants::SERVER_MAX_PACKET_SIZE
+    );
+
+    ReconnectOptions reconnect_options;
+    reconnect_options.enabled = true;
+    frame_ingest.set_reconnect_options(reconnect_options);
+
+    // The server may drop bullets outside the window when drawing falls behind
+    LodOptions lod_options;
+    lod_options.view_width = static_cast<uint16_t>(SCREEN_WIDTH);
+    lod_options.view_height = static_cast<uint16_t>(SCREEN_HEIGHT);
+    frame_ingest.set_level_of_detail(lod_options);
+
+    if (!frame_ingest.start(SERVER_CONNECT_TIMEOUT))
+    {
+        std::cerr << "Failed to connect to the server, playing offline" << '\n';
+    }
+
+    Frame frame;
+
     shader.use();
     shader.set_int("OurTexture", 0);
     glClearColor(0.0f, 0.0f, 0.0f, 1.f);
@@ -191,6 +225,11 @@ void draw_loop() {
 
     while (!quit)
     {
+        const auto render_start = std::chrono::steady_clock::now();
+
+        // Keeps the previous frame until a newer one has been decoded
+        frame_ingest.try_take_frame(frame);
+
         last = now;
         now = SDL_GetPerformanceCounter();
         float delta_time = (now - last) / (float)SDL_GetPerformanceFrequency();
@@ -213,6 +252,19 @@ void draw_loop() {
         if (keystate[SDL_SCANCODE_UP])      y_offset += speed * delta_time;
         if (keystate[SDL_SCANCODE_DOWN])    y_offset -= speed * delta_time;
 
+        // The same keys go to the server as one input command per tick
+        if (frame_ingest.is_running())
+        {
+            uint32_t buttons = input_buttons(InputButton::None);
+
+            if (keystate[SDL_SCANCODE_RIGHT])   buttons |= input_buttons(InputButton::Right);
+            if (keystate[SDL_SCANCODE_LEFT])    buttons |= input_buttons(InputButton::Left);
+            if (keystate[SDL_SCANCODE_UP])      buttons |= input_buttons(InputButton::Up);
+            if (keystate[SDL_SCANCODE_DOWN])    buttons |= input_buttons(InputButton::Down);
+
+            frame_ingest.submit_input(buttons);
+        }
+
         shader.use();
         shader.set_float("time", totalTime);
         shader.set_vec2("offset", glm::vec2(x_offset, y_offset));
@@ -222,8 +274,16 @@ void draw_loop() {
         quad_mesh.bind();
         quad_mesh.draw();
 
+        // Measured before the swap, waiting for vsync is not drawing time
+        if (frame_ingest.is_running())
+        {
+            frame_ingest.report_render_time(std::chrono::steady_clock::now() - render_start, frame.bullet_count);
+        }
+
         SDL_GL_SwapWindow(g_window);
     }
+
+    frame_ingest.stop();
 }
 
 int main(int argc, char* args[]) {
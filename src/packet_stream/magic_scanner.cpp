@@ -0,0 +1,138 @@
+#include <cstring>
+#include "magic_scanner.hpp"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || (defined(__i386__) && defined(__SSE2__)))
+    #define MAGIC_SCANNER_X86 1
+    #include <immintrin.h>
+#else
+    #define MAGIC_SCANNER_X86 0
+#endif
+
+namespace {
+    using FindFunction = size_t (*)(const std::byte*, size_t, uint32_t);
+
+    bool is_magic_at(const std::byte* data, uint32_t magic_number) {
+        uint32_t candidate;
+        memcpy(&candidate, data, sizeof(candidate));
+
+        return candidate == magic_number;
+    }
+
+    size_t find_magic_number_scalar(const std::byte* data, size_t size, uint32_t magic_number, size_t start) {
+        const auto first_byte = static_cast<std::byte>(magic_number & 0xFF);
+
+        for (size_t i = start; i + sizeof(uint32_t) <= size; i++)
+        {
+            if (data[i] == first_byte && is_magic_at(data + i, magic_number))
+            {
+                return i;
+            }
+        }
+
+        return size;
+    }
+
+#if !MAGIC_SCANNER_X86
+    size_t find_magic_number_generic(const std::byte* data, size_t size, uint32_t magic_number) {
+        return find_magic_number_scalar(data, size, magic_number, 0);
+    }
+#else
+    /*
+        Both vector scanners compare the first two bytes of the magic number
+        against two overlapping loads, so only positions that match 2 bytes
+        are verified with a full 4 byte comparison
+    */
+    size_t find_magic_number_sse2(const std::byte* data, size_t size, uint32_t magic_number) {
+        const auto first_byte = _mm_set1_epi8(static_cast<char>(magic_number & 0xFF));
+        const auto second_byte = _mm_set1_epi8(static_cast<char>((magic_number >> 8) & 0xFF));
+
+        constexpr size_t lanes = 16;
+        size_t i = 0;
+
+        // The second load reads one byte ahead of the first one
+        for (; i + lanes + 1 <= size; i += lanes)
+        {
+            auto block_0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            auto block_1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + 1));
+
+            auto match = _mm_and_si128(
+                _mm_cmpeq_epi8(block_0, first_byte),
+                _mm_cmpeq_epi8(block_1, second_byte)
+            );
+
+            auto mask = static_cast<uint32_t>(_mm_movemask_epi8(match));
+
+            while (mask != 0)
+            {
+                auto candidate = i + static_cast<size_t>(__builtin_ctz(mask));
+
+                if (candidate + sizeof(uint32_t) <= size && is_magic_at(data + candidate, magic_number))
+                {
+                    return candidate;
+                }
+
+                mask &= mask - 1;
+            }
+        }
+
+        return find_magic_number_scalar(data, size, magic_number, i);
+    }
+
+    __attribute__((target("avx2")))
+    size_t find_magic_number_avx2(const std::byte* data, size_t size, uint32_t magic_number) {
+        const auto first_byte = _mm256_set1_epi8(static_cast<char>(magic_number & 0xFF));
+        const auto second_byte = _mm256_set1_epi8(static_cast<char>((magic_number >> 8) & 0xFF));
+
+        constexpr size_t lanes = 32;
+        size_t i = 0;
+
+        for (; i + lanes + 1 <= size; i += lanes)
+        {
+            auto block_0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i));
+            auto block_1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + 1));
+
+            auto match = _mm256_and_si256(
+                _mm256_cmpeq_epi8(block_0, first_byte),
+                _mm256_cmpeq_epi8(block_1, second_byte)
+            );
+
+            auto mask = static_cast<uint32_t>(_mm256_movemask_epi8(match));
+
+            while (mask != 0)
+            {
+                auto candidate = i + static_cast<size_t>(__builtin_ctz(mask));
+
+                if (candidate + sizeof(uint32_t) <= size && is_magic_at(data + candidate, magic_number))
+                {
+                    return candidate;
+                }
+
+                mask &= mask - 1;
+            }
+        }
+
+        return find_magic_number_sse2(data + i, size - i, magic_number) + i;
+    }
+#endif
+
+    FindFunction select_find_function() {
+#if MAGIC_SCANNER_X86
+        __builtin_cpu_init();
+
+        if (__builtin_cpu_supports("avx2"))
+        {
+            return find_magic_number_avx2;
+        }
+
+        return find_magic_number_sse2;
+#else
+        return find_magic_number_generic;
+#endif
+    }
+}
+
+size_t find_magic_number(const std::byte* data, size_t size, uint32_t magic_number) {
+    static const FindFunction find_function = select_find_function();
+
+    return find_function(data, size, magic_number);
+}
\ No newline at end of file
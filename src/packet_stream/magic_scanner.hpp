@@ -0,0 +1,13 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/*
+    Returns the offset of the first occurrence of the 4 byte magic number
+    (in host byte order) inside data, or size if there is no complete match.
+
+    The scan uses AVX2 or SSE2 when the CPU supports them and falls back
+    to a scalar loop otherwise, the implementation is selected once at runtime
+*/
+size_t find_magic_number(const std::byte* data, size_t size, uint32_t magic_number);
\ No newline at end of file
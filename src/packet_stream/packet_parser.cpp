@@ -0,0 +1,374 @@
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+#include "packet_parser.hpp"
+#include "magic_scanner.hpp"
+#include "../crc32c/crc32c.hpp"
+
+namespace {
+    size_t checksum_size(const PacketHeader& packet_header) {
+        return has_packet_flag(packet_flags(packet_header), PacketFlag::Checksummed) ? sizeof(PacketChecksum) : 0;
+    }
+
+    constexpr uint64_t NO_VERIFIED_POSITION = std::numeric_limits<uint64_t>::max();
+}
+
+uint32_t checked_max_packet_size(uint32_t max_packet_size) {
+    if (max_packet_size > PACKET_BODY_SIZE_MASK)
+    {
+        throw std::invalid_argument("The maximum packet size does not fit in a packet header");
+    }
+
+    return max_packet_size;
+}
+
+PacketParser::PacketParser(uint32_t magic_number, uint32_t max_packet_size)
+    : m_magic_number(magic_number)
+    , m_max_packet_size(checked_max_packet_size(max_packet_size))
+    , m_checksum_required(false)
+    , m_state(PacketParserState::AwaitingHeader)
+    , m_header()
+    , m_buffer(m_max_packet_size)
+    , m_verified_position(NO_VERIFIED_POSITION)
+{}
+
+void PacketParser::set_checksum_required(bool required) {
+    m_checksum_required = required;
+}
+
+size_t PacketParser::feed(const std::byte* data, size_t size) {
+    auto written = m_buffer.write(data, size);
+
+    advance();
+
+    return written;
+}
+
+size_t PacketParser::free_space() const {
+    return m_buffer.free_space();
+}
+
+std::array<RingBufferWriteRegion, 2> PacketParser::write_regions(size_t max_size) {
+    return m_buffer.write_regions(max_size);
+}
+
+void PacketParser::commit(size_t size) {
+    m_buffer.commit(size);
+
+    advance();
+}
+
+std::optional<ParsedPacket> PacketParser::next_packet() {
+    if (m_state != PacketParserState::Ready)
+    {
+        return std::nullopt;
+    }
+
+    // Use the body in place unless it straddles the end of the ring buffer
+    const auto body_offset = sizeof(PacketHeader) + checksum_size(m_header);
+    const auto body_size = static_cast<uint32_t>(sizeof(PacketHeader) + packet_body_size(m_header) - body_offset);
+    const std::byte* body = m_buffer.contiguous_data(body_offset, body_size);
+
+    if (body == nullptr)
+    {
+        m_wrapped_body.resize(body_size);
+        m_buffer.peek(m_wrapped_body.data(), body_size, body_offset);
+
+        body = m_wrapped_body.data();
+    }
+
+    return ParsedPacket{ m_header, packet_type(m_header), packet_flags(m_header), body_size, body };
+}
+
+void PacketParser::release_packet() {
+    if (m_state != PacketParserState::Ready)
+    {
+        return;
+    }
+
+    m_buffer.consume(sizeof(PacketHeader) + packet_body_size(m_header));
+    m_state = PacketParserState::AwaitingHeader;
+    m_stats.packets_parsed++;
+
+    // The next packet may already be buffered
+    advance();
+}
+
+std::optional<PacketHeader> PacketParser::ready_header() const {
+    if (m_state != PacketParserState::Ready)
+    {
+        return std::nullopt;
+    }
+
+    return m_header;
+}
+
+bool PacketParser::has_following_packet(std::initializer_list<PacketType> types) {
+    if (m_state != PacketParserState::Ready)
+    {
+        return false;
+    }
+
+    auto offset = sizeof(PacketHeader) + packet_body_size(m_header);
+    PacketHeader following;
+
+    while (m_buffer.peek(reinterpret_cast<std::byte*>(&following), sizeof(PacketHeader), offset))
+    {
+        if (following.magic_number != m_magic_number ||
+            !is_valid_packet_size(following) ||
+            m_buffer.size() < offset + sizeof(PacketHeader) + packet_body_size(following))
+        {
+            return false;
+        }
+
+        if (checksum_size(following) == 0 ? m_checksum_required : !is_header_checksum_valid(following, offset))
+        {
+            return false;
+        }
+
+        if (std::find(types.begin(), types.end(), packet_type(following)) != types.end())
+        {
+            if (checksum_size(following) == 0)
+            {
+                return true;
+            }
+
+            if (!is_body_checksum_valid(following, offset))
+            {
+                return false;
+            }
+
+            m_verified_position = m_buffer.read_position() + offset;
+
+            return true;
+        }
+
+        offset += sizeof(PacketHeader) + packet_body_size(following);
+    }
+
+    return false;
+}
+
+PacketParserState PacketParser::state() const {
+    return m_state;
+}
+
+uint32_t PacketParser::max_packet_size() const {
+    return m_max_packet_size;
+}
+
+size_t PacketParser::body_remaining() const {
+    if (m_state != PacketParserState::AwaitingBody)
+    {
+        return 0;
+    }
+
+    return sizeof(PacketHeader) + packet_body_size(m_header) - m_buffer.size();
+}
+
+void PacketParser::reset() {
+    m_buffer.clear();
+    m_verified_position = NO_VERIFIED_POSITION;
+    m_state = PacketParserState::AwaitingHeader;
+}
+
+void PacketParser::attach_storage(std::byte* storage, size_t capacity, uint64_t position) {
+    m_buffer.attach_storage(storage, capacity, position);
+    m_verified_position = NO_VERIFIED_POSITION;
+    m_state = PacketParserState::AwaitingHeader;
+}
+
+void PacketParser::detach_storage() {
+    m_buffer.detach_storage();
+    m_verified_position = NO_VERIFIED_POSITION;
+    m_state = PacketParserState::AwaitingHeader;
+}
+
+uint64_t PacketParser::read_position() const {
+    return m_buffer.read_position();
+}
+
+uint64_t PacketParser::write_position() const {
+    return m_buffer.write_position();
+}
+
+const PacketParserStats& PacketParser::stats() const {
+    return m_stats;
+}
+
+void PacketParser::advance() {
+    // Only a failed body checksum goes around again
+    for (;;)
+    {
+        while (m_state == PacketParserState::AwaitingHeader && m_buffer.size() >= sizeof(PacketHeader))
+        {
+            // Read the header in place and check if the first 4 bytes are a magic number
+            m_buffer.peek(reinterpret_cast<std::byte*>(&m_header), sizeof(PacketHeader));
+
+            if (m_header.magic_number != m_magic_number)
+            {
+                resync_to_magic_number();
+
+                continue;
+            }
+
+            if (!is_valid_packet_size(m_header))
+            {
+                // The magic number was a false match, look for the next one
+                m_stats.invalid_sizes++;
+
+                resync_to_magic_number();
+
+                continue;
+            }
+
+            if (checksum_size(m_header) == 0 && m_checksum_required)
+            {
+                m_stats.checksum_failures++;
+                resync_to_magic_number();
+
+                continue;
+            }
+
+            if (checksum_size(m_header) != 0)
+            {
+                // The header checksum directly follows the header
+                if (m_buffer.size() < sizeof(PacketHeader) + sizeof(PacketChecksum::header_crc))
+                {
+                    return;
+                }
+
+                if (!is_header_checksum_valid(m_header, 0))
+                {
+                    m_stats.checksum_failures++;
+                    resync_to_magic_number();
+
+                    continue;
+                }
+            }
+
+            m_state = PacketParserState::AwaitingBody;
+        }
+
+        if (m_state != PacketParserState::AwaitingBody ||
+            m_buffer.size() < sizeof(PacketHeader) + packet_body_size(m_header))
+        {
+            return;
+        }
+
+        if (checksum_size(m_header) != 0 &&
+            m_buffer.read_position() != m_verified_position &&
+            !is_body_checksum_valid(m_header, 0))
+        {
+            m_stats.checksum_failures++;
+            m_state = PacketParserState::AwaitingHeader;
+            resync_to_magic_number();
+
+            continue;
+        }
+
+        m_state = PacketParserState::Ready;
+
+        return;
+    }
+}
+
+void PacketParser::resync_to_magic_number() {
+    const auto regions = m_buffer.read_regions();
+    const auto magic_size = sizeof(m_magic_number);
+
+    /*
+        The current read position is known to be misaligned, so the search
+        starts from the next byte. A match can be fully inside either region
+        or straddle the wrap point, in which case it is checked through peek
+    */
+    auto skip = m_buffer.size();
+    auto offset = find_magic_number(regions[0].data + 1, regions[0].size - 1, m_magic_number) + 1;
+
+    if (offset < regions[0].size)
+    {
+        skip = offset;
+    }
+    else
+    {
+        const auto straddle_begin = regions[0].size >= magic_size ? regions[0].size - magic_size + 1 : 1;
+
+        for (auto i = straddle_begin; i < regions[0].size; i++)
+        {
+            uint32_t candidate;
+
+            if (m_buffer.peek(reinterpret_cast<std::byte*>(&candidate), magic_size, i) && candidate == m_magic_number)
+            {
+                skip = i;
+                break;
+            }
+        }
+
+        if (skip == m_buffer.size())
+        {
+            offset = find_magic_number(regions[1].data, regions[1].size, m_magic_number);
+
+            if (offset < regions[1].size)
+            {
+                skip = regions[0].size + offset;
+            }
+            else
+            {
+                // Keep the tail because it may be the beginning of a magic number
+                skip = m_buffer.size() >= magic_size ? m_buffer.size() - (magic_size - 1) : 1;
+            }
+        }
+    }
+
+    m_buffer.consume(skip);
+
+    m_stats.resync_count++;
+    m_stats.skipped_bytes += skip;
+}
+
+bool PacketParser::is_valid_packet_size(const PacketHeader& packet_header) const {
+    // Validation for packet size
+    auto expr_1 = packet_body_size(packet_header) > checksum_size(packet_header);
+    auto expr_2 = packet_body_size(packet_header) + sizeof(PacketHeader) <= m_max_packet_size;
+
+    return expr_1 && expr_2;
+}
+
+bool PacketParser::is_header_checksum_valid(const PacketHeader& packet_header, size_t offset) const {
+    uint32_t header_crc;
+
+    if (!m_buffer.peek(reinterpret_cast<std::byte*>(&header_crc), sizeof(header_crc), offset + sizeof(PacketHeader)))
+    {
+        return false;
+    }
+
+    return header_crc == crc32c(reinterpret_cast<const std::byte*>(&packet_header), sizeof(PacketHeader));
+}
+
+bool PacketParser::is_body_checksum_valid(const PacketHeader& packet_header, size_t offset) const {
+    PacketChecksum checksum;
+    m_buffer.peek(reinterpret_cast<std::byte*>(&checksum), sizeof(PacketChecksum), offset + sizeof(PacketHeader));
+
+    // The body may straddle the wrap point, the CRC is continued across both regions
+    offset += sizeof(PacketHeader) + sizeof(PacketChecksum);
+    auto remaining = packet_body_size(packet_header) - sizeof(PacketChecksum);
+    uint32_t crc = 0;
+
+    for (const auto& region : m_buffer.read_regions())
+    {
+        if (offset >= region.size)
+        {
+            offset -= region.size;
+
+            continue;
+        }
+
+        const auto size = std::min(remaining, region.size - offset);
+        crc = crc32c(region.data + offset, size, crc);
+
+        remaining -= size;
+        offset = 0;
+    }
+
+    return crc == checksum.body_crc;
+}
\ No newline at end of file
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <vector>
+#include <initializer_list>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include "../ring_buffer/ring_buffer.hpp"
+#include "../frame/frame_template.hpp"
+
+enum class PacketParserState {
+    AwaitingHeader,     // Fewer than sizeof(PacketHeader) bytes of the next packet are buffered
+    AwaitingBody,       // The header is parsed, body_remaining() bytes are still missing
+    Ready,              // A complete packet can be taken with next_packet()
+};
+
+struct PacketParserStats {
+    // Number of times the stream lost the packet boundary and had to search for a magic number
+    uint64_t resync_count       = 0;
+    uint64_t skipped_bytes      = 0;
+
+    // Magic number matches whose header had an impossible body size, each one also counts as a resync
+    uint64_t invalid_sizes      = 0;
+
+    uint64_t packets_parsed     = 0;
+
+    /*
+        Packets whose PacketChecksum did not match, or that had none while
+        checksums are required. Each one also counts as a resync
+    */
+    uint64_t checksum_failures  = 0;
+};
+
+/*
+    Returns max_packet_size, or throws std::invalid_argument if a
+    PacketHeader cannot describe packets that large
+*/
+uint32_t checked_max_packet_size(uint32_t max_packet_size);
+
+/*
+    A complete packet, the body stays valid until release_packet() is called.
+    The PacketChecksum of a checksummed packet is verified and not part of the body
+*/
+struct ParsedPacket {
+    PacketHeader        header;
+    PacketType          type;
+    uint8_t             flags;      // PacketFlag bits
+    uint32_t            body_size;
+    const std::byte*    body;
+};
+
+/*
+    Resumable packet parser
+
+    The parser is fed with whatever bytes happen to be available and never
+    waits for more, so it works the same for blocking reads, deadlines or
+    an event loop driving many connections. The parsed header is kept in
+    the state, so an incomplete packet is not re-parsed on every feed
+*/
+class PacketParser {
+public:
+    // Throws std::invalid_argument if max_packet_size is above PACKET_BODY_SIZE_MASK
+    PacketParser(uint32_t magic_number, uint32_t max_packet_size);
+
+    // Disable the copy constructor and copy assignment operator
+    PacketParser(const PacketParser&) = delete;
+    PacketParser& operator=(const PacketParser&) = delete;
+
+    /*
+        Rejects packets without PacketFlag::Checksummed, so that a false
+        magic number match can only get through with a matching CRC.
+        Checksummed packets are verified either way
+    */
+    void set_checksum_required(bool required);
+
+    // Buffers received bytes, returns how many of them fit
+    size_t feed(const std::byte* data, size_t size);
+    size_t free_space() const;
+
+    // Lets a transport receive straight into the buffer, see RingBuffer::write_regions
+    std::array<RingBufferWriteRegion, 2> write_regions(size_t max_size);
+    void commit(size_t size);
+
+    /*
+        Returns the next complete packet, or std::nullopt if more bytes are
+        needed. The same packet is returned until release_packet() is called
+    */
+    std::optional<ParsedPacket> next_packet();
+    void release_packet();
+
+    // Header of the complete packet, without touching (or copying) its body
+    std::optional<PacketHeader> ready_header() const;
+
+    /*
+        Whether a complete packet of one of the types is buffered anywhere
+        behind the ready one. Packets in between are stepped over by their
+        headers (and header checksums), the body checksum of the match is
+        verified as well and not checked a second time once it is ready.
+        Bytes that would need a resync end the search
+    */
+    bool has_following_packet(std::initializer_list<PacketType> types);
+
+    PacketParserState state() const;
+    uint32_t max_packet_size() const;
+    size_t body_remaining() const;
+
+    // Drops all buffered bytes, e.g., after a reconnect
+    void reset();
+
+    /*
+        Parses straight out of a shared memory ring, see RingBuffer::attach_storage.
+        The writer's progress is handed over with commit()
+    */
+    void attach_storage(std::byte* storage, size_t capacity, uint64_t position);
+    void detach_storage();
+
+    // Bytes consumed and buffered since the start of the stream
+    uint64_t read_position() const;
+    uint64_t write_position() const;
+
+    const PacketParserStats& stats() const;
+
+private:
+    void advance();
+    void resync_to_magic_number();
+    bool is_valid_packet_size(const PacketHeader& packet_header) const;
+    bool is_header_checksum_valid(const PacketHeader& packet_header, size_t offset) const;
+    bool is_body_checksum_valid(const PacketHeader& packet_header, size_t offset) const;
+
+    /*
+        This is used to detect the start of a packet
+        and is fixed at 4 bytes so should not be changed
+    */
+    uint32_t                m_magic_number;
+    uint32_t                m_max_packet_size;
+    bool                    m_checksum_required;
+
+    PacketParserState       m_state;
+    PacketHeader            m_header;
+
+    /*
+        Received bytes are kept in a fixed-capacity ring buffer large enough
+        for the biggest packet, so consuming a packet never shifts memory.
+        A body that straddles the end of the ring is copied to m_wrapped_body
+    */
+    RingBuffer              m_buffer;
+    std::vector<std::byte>  m_wrapped_body;
+
+    // Stream position of a packet whose body checksum has_following_packet() already verified
+    uint64_t                m_verified_position;
+
+    PacketParserStats       m_stats;
+};
\ No newline at end of file
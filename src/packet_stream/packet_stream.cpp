@@ -1,223 +1,1188 @@
+#include <cstring>
 #include <iostream>
-#include <array>
+#include <algorithm>
+#include <limits>
+#include <thread>
 #include "packet_stream.hpp"
 
 namespace {
-    constexpr size_t TEMP_BUFFER_SIZE = 4096;
+    constexpr size_t MIN_READ_SIZE      = 4 * 1024;
+    constexpr size_t INITIAL_READ_SIZE  = 64 * 1024;
+    constexpr size_t MAX_READ_SIZE      = 4 * 1024 * 1024;
+
+    // Pings sent at a faster pace until the clock estimate has this many samples
+    constexpr uint64_t CLOCK_SYNC_WARMUP_SAMPLES = 4;
+    constexpr auto CLOCK_SYNC_WARMUP_INTERVAL = std::chrono::milliseconds(50);
+
+    // Spoken by servers that never send a Hello
+    constexpr uint16_t LEGACY_PROTOCOL_VERSION = 1;
 }
 
-PacketStreamClient::PacketStreamClient(std::string_view server_addr, uint16_t server_port, uint32_t magic_number, uint32_t max_packet_size)
+PacketStreamClient::PacketStreamClient(
+    std::string_view server_addr,
+    uint16_t server_port,
+    uint32_t magic_number,
+    uint32_t max_packet_size,
+    PacketTransport transport)
     : m_client_socket(server_addr, server_port)
     , m_server_connected(false)
+    , m_transport(transport)
+    , m_datagram_receiver(server_addr, server_port, magic_number, checked_max_packet_size(max_packet_size))
     , m_magic_number(magic_number)
-    , m_max_packet_size(max_packet_size)
-{}
+    , m_parser(magic_number, max_packet_size)
+    , m_packet_pending(false)
+    , m_packet_read_timeout(std::chrono::milliseconds::zero())
+    , m_read_size(INITIAL_READ_SIZE)
+    , m_read_filled(false)
+    , m_catch_up_enabled(false)
+    , m_decompressor(max_packet_size)
+    , m_delta_frames_enabled(false)
+    , m_frame_batch_index(0)
+    , m_clock_sync_interval(std::chrono::milliseconds::zero())
+    , m_received_reads{}
+    , m_received_read_first(0)
+    , m_received_read_count(0)
+    , m_interrupted(false)
+    , m_reconnecting(false)
+    , m_reconnect_backoff(std::chrono::milliseconds::zero())
+    , m_awaiting_first_frame(false)
+    , m_protocol_version(LEGACY_PROTOCOL_VERSION)
+    , m_server_capabilities(0)
+    , m_lod_enabled(false)
+    , m_has_last_frame(false)
+    , m_last_frame_timestamp(0)
+{
+    // Every read goes through a deadline, so the socket itself never has to block
+    m_client_socket.set_non_blocking(true);
+}
 
 PacketStreamClient::~PacketStreamClient() {
     disconnect();
 }
 
 bool PacketStreamClient::connect_to_server() {
-    m_server_connected = m_client_socket.connect_to_server();
+    return connect_to_server(std::chrono::milliseconds::zero());
+}
+
+bool PacketStreamClient::connect_to_server(std::chrono::milliseconds timeout) {
+    m_interrupted = false;
+    m_reconnecting = false;
+    m_server_connected = m_client_socket.connect_to_server(timeout);
+
+    // The frame channel is opened once the control channel is up
+    if (m_server_connected && !open_frame_channel())
+    {
+        disconnect();
+    }
+
+    if (m_server_connected)
+    {
+        send_hello();
+    }
 
     return m_server_connected;
 }
 
 void PacketStreamClient::disconnect() {
-    if (m_server_connected)
+    m_reconnecting = false;
+
+    // A reconnect may have left a connect in progress
+    if (m_server_connected || m_client_socket.is_connect_pending())
     {
         m_client_socket.disconnect();
+        close_frame_channel();
         m_server_connected = false;
     }
 }
 
+bool PacketStreamClient::is_connected() const {
+    return m_server_connected;
+}
+
+void PacketStreamClient::interrupt() {
+    m_interrupted = true;
+    m_client_socket.shutdown_connection();
+    m_datagram_receiver.interrupt();
+    m_shm_reader.interrupt();
+}
+
+void PacketStreamClient::set_reconnect_options(const ReconnectOptions& options) {
+    m_reconnect_options = options;
+}
+
+bool PacketStreamClient::is_reconnecting() const {
+    return m_reconnecting;
+}
+
 std::optional<Frame> PacketStreamClient::retrieve_frame(size_t max_attempts) {
-    for (size_t attempt = 0; attempt < max_attempts; attempt++)
+    auto frame_view_opt = retrieve_frame_view(max_attempts);
+
+    if (!frame_view_opt)
+    {
+        return std::nullopt;
+    }
+
+    return frame_view_to_frame(frame_view_opt.value());
+}
+
+std::optional<FrameView> PacketStreamClient::retrieve_frame_view(size_t max_attempts) {
+    return extract_frame_view(packet_deadline(), max_attempts);
+}
+
+std::optional<Frame> PacketStreamClient::wait_for_frame(SocketDeadline deadline) {
+    auto frame_view_opt = wait_for_frame_view(deadline);
+
+    if (!frame_view_opt)
+    {
+        return std::nullopt;
+    }
+
+    return frame_view_to_frame(frame_view_opt.value());
+}
+
+std::optional<FrameView> PacketStreamClient::wait_for_frame_view(SocketDeadline deadline) {
+    return extract_frame_view(deadline, std::numeric_limits<size_t>::max());
+}
+
+std::optional<FrameView> PacketStreamClient::poll_frame_view() {
+    return extract_frame_view(SocketDeadline::min(), 1);
+}
+
+bool PacketStreamClient::retrieve_frame(Frame& frame, size_t max_attempts) {
+    auto frame_view_opt = retrieve_frame_view(max_attempts);
+
+    if (!frame_view_opt)
     {
-        // Insert packet into buffer
-        if (!refill_buffer())
+        return false;
+    }
+
+    frame_view_to_frame(frame_view_opt.value(), frame);
+
+    return true;
+}
+
+std::vector<Frame> PacketStreamClient::retrieve_all_frames(size_t max_attempts) {
+    std::vector<Frame> frames;
+    FramePool frame_pool(0);
+
+    retrieve_all_frames(frames, frame_pool, max_attempts);
+
+    return frames;
+}
+
+size_t PacketStreamClient::retrieve_all_frames(std::vector<Frame>& frames, FramePool& frame_pool, size_t max_attempts) {
+    const auto initial_size = frames.size();
+
+    consume_pending_packet();
+    send_clock_ping_if_due();
+    send_lod_report_if_due();
+
+    for (size_t attempt = 0; attempt < max_attempts; attempt++) {
+        if (!refill_buffer(packet_deadline()))
         {
-            continue;
+            break;
         }
 
-        while (true)
+        if (m_catch_up_enabled)
         {
-            if(m_buffer.size() < sizeof(PacketHeader))
-            {
-                break;
-            }
+            catch_up();
+        }
+
+        while (auto frame_view_opt = next_buffered_frame_view())
+        {
+            frames.push_back(frame_pool.acquire());
+            frame_view_to_frame(frame_view_opt.value(), frames.back());
+            consume_pending_packet();
+        }
+    }
+
+    return frames.size() - initial_size;
+}
+
+bool PacketStreamClient::set_socket_options(const SocketOptions& options) {
+    return m_client_socket.set_options(options);
+}
+
+SocketReceiveBackend PacketStreamClient::receive_backend() const {
+    return m_client_socket.receive_backend();
+}
+
+SOCKET PacketStreamClient::native_handle() const {
+    return m_client_socket.native_handle();
+}
+
+void PacketStreamClient::set_packet_read_timeout(std::chrono::milliseconds timeout) {
+    m_packet_read_timeout = timeout;
+}
+
+void PacketStreamClient::set_delta_frames_enabled(bool enabled) {
+    m_delta_frames_enabled = enabled;
+}
+
+void PacketStreamClient::set_checksum_required(bool required) {
+    m_parser.set_checksum_required(required);
+}
+
+void PacketStreamClient::set_shared_memory_name(std::string name) {
+    m_shared_memory_name = std::move(name);
+}
+
+void PacketStreamClient::set_datagram_loss_emulation(const DatagramLossOptions& options) {
+    m_datagram_receiver.set_loss_emulation(options);
+}
+
+void PacketStreamClient::set_catch_up_enabled(bool enabled) {
+    m_catch_up_enabled = enabled;
+}
+
+void PacketStreamClient::set_skipped_packet_consumer(SkippedPacketConsumer consumer) {
+    m_skipped_packet_consumer = std::move(consumer);
+}
+
+bool PacketStreamClient::send_input(InputChannel& input_channel) {
+    m_input_buffer.clear();
+
+    if (!m_server_connected || !input_channel.flush(m_input_buffer, m_magic_number))
+    {
+        return false;
+    }
+
+    // Input always goes over the TCP connection, which runs with TCP_NODELAY
+    if (m_client_socket.send_data(m_input_buffer) != static_cast<ssize_t>(m_input_buffer.size()))
+    {
+        m_stats.input_send_failures++;
+
+        return false;
+    }
+
+    m_stats.input_packets++;
+
+    return true;
+}
+
+void PacketStreamClient::set_clock_sync_interval(std::chrono::milliseconds interval) {
+    m_clock_sync_interval = interval;
+    m_next_clock_ping = SocketClock::now();
+}
+
+const ClockSync& PacketStreamClient::clock_sync() const {
+    return m_clock_sync;
+}
+
+std::optional<LocalClock::time_point> PacketStreamClient::server_to_local(uint32_t timestamp) const {
+    return m_clock_sync.server_to_local(timestamp);
+}
+
+void PacketStreamClient::set_level_of_detail(const LodOptions& options) {
+    m_lod_enabled = true;
+    m_lod = LodController(options);
+    m_next_lod_report = SocketClock::now();
+}
+
+void PacketStreamClient::record_render_time(std::chrono::nanoseconds render_time, uint64_t bullet_count, uint32_t frame_count) {
+    m_lod.record_render_time(render_time, bullet_count, frame_count);
+}
+
+const LodController& PacketStreamClient::level_of_detail() const {
+    return m_lod;
+}
+
+SocketClock::time_point PacketStreamClient::frame_receive_time() const {
+    return m_frame_receive_time;
+}
+
+uint16_t PacketStreamClient::protocol_version() const {
+    return m_protocol_version;
+}
 
-            auto packet_header_opt = try_extract_packet_header();
+PacketStreamStats PacketStreamClient::stats() const {
+    auto stats = m_stats;
 
-            if (!packet_header_opt)
+    stats.resync_count = m_parser.stats().resync_count;
+    stats.skipped_bytes = m_parser.stats().skipped_bytes;
+    stats.invalid_sizes = m_parser.stats().invalid_sizes;
+    stats.checksum_failures = m_parser.stats().checksum_failures;
+    stats.recv_calls = m_client_socket.stats().recv_calls + m_datagram_receiver.socket_stats().recv_calls;
+    stats.wait_calls = m_client_socket.stats().wait_calls + m_datagram_receiver.socket_stats().wait_calls + m_shm_reader.stats().wait_calls;
+    stats.ring_enter_calls = m_client_socket.stats().ring_enter_calls;
+    stats.setsockopt_calls = m_client_socket.stats().setsockopt_calls;
+    stats.timestamped_reads = m_client_socket.stats().timestamped_reads;
+    stats.spin_hits = m_client_socket.stats().spin_hits;
+    stats.spin_misses = m_client_socket.stats().spin_misses;
+    stats.datagrams = m_datagram_receiver.stats();
+    stats.decompression = m_decompressor.stats();
+
+    return stats;
+}
+
+std::optional<FrameView> PacketStreamClient::extract_frame_view(SocketDeadline deadline, size_t max_refills) {
+    // The view returned by the previous call is invalidated from here on
+    consume_pending_packet();
+    send_clock_ping_if_due();
+    send_lod_report_if_due();
+
+    for (size_t refills = 0; ; refills++)
+    {
+        if (m_catch_up_enabled)
+        {
+            catch_up();
+        }
+
+        // Packets that are already buffered never wait for the socket
+        if (auto frame_view_opt = next_buffered_frame_view())
+        {
+            return frame_view_opt;
+        }
+
+        if (refills >= max_refills || !refill_buffer(deadline))
+        {
+            return std::nullopt;
+        }
+    }
+}
+
+std::optional<FrameView> PacketStreamClient::next_buffered_frame_view() {
+    // The rest of a batch comes before the packets behind it, its receive time is already known
+    if (m_frame_batch)
+    {
+        // Only taken for the level of detail, the clock is not free
+        const auto decode_start = m_lod_enabled ? SocketClock::now() : SocketClock::time_point();
+
+        if (auto frame_view_opt = next_batch_frame_view())
+        {
+            finish_frame(frame_view_opt.value());
+
+            m_packet_pending = true;
+            m_stats.frames_received++;
+
+            const auto decode_end = SocketClock::now();
+            m_stats.receive_to_decode.record(decode_end - m_frame_receive_time);
+
+            if (m_lod_enabled)
             {
-                continue;
+                m_lod.record_decode_time(decode_end - decode_start, frame_view_opt->bullets.size());
             }
 
-            auto packet_header = packet_header_opt.value();
+            return frame_view_opt;
+        }
+
+        m_parser.release_packet();
+    }
+
+    while (auto packet_opt = m_parser.next_packet())
+    {
+        const auto packet_end = m_parser.read_position() + sizeof(PacketHeader) + packet_body_size(packet_opt->header);
+        const auto decode_start = m_lod_enabled ? SocketClock::now() : SocketClock::time_point();
+
+        if (auto frame_view_opt = decode_packet(packet_opt.value()))
+        {
+            // The packet stays in the buffer while the view is alive
+            m_packet_pending = true;
+            m_stats.frames_received++;
+
+            const auto decode_end = SocketClock::now();
+            m_frame_receive_time = receive_time_of(packet_end);
+            m_stats.receive_to_decode.record(decode_end - m_frame_receive_time);
 
-            if (!is_valid_packet_size(packet_header))
+            if (m_lod_enabled)
             {
-                std::cerr << "Invalid packet size: " << packet_header.body_size << " bytes" << "\n";
-            
-                return std::nullopt;
+                m_lod.record_decode_time(decode_end - decode_start, frame_view_opt->bullets.size());
             }
 
-            auto frame_opt = try_extract_frame(packet_header);
-            
-            return frame_opt;
+            return frame_view_opt;
         }
     }
 
     return std::nullopt;
 }
 
-std::vector<Frame> PacketStreamClient::retrieve_all_frames(size_t max_attempts) {
-    std::vector<Frame> frames;
+constexpr std::array<PacketStreamClient::PacketHandler, PACKET_TYPE_COUNT> PacketStreamClient::make_packet_handlers() {
+    std::array<PacketHandler, PACKET_TYPE_COUNT> handlers = {};
 
-    for (size_t attempt = 0; attempt < max_attempts; attempt++) {
-        if (!refill_buffer())
+    // Client to server packets and types this client does not know
+    for (auto& handler : handlers)
+    {
+        handler = &PacketStreamClient::handle_unknown_packet;
+    }
+
+    handlers[packet_type_index(PacketType::Frame)] = &PacketStreamClient::handle_frame;
+    handlers[packet_type_index(PacketType::FrameDelta)] = &PacketStreamClient::handle_frame_delta;
+    handlers[packet_type_index(PacketType::FrameBatch)] = &PacketStreamClient::handle_frame_batch;
+    handlers[packet_type_index(PacketType::ClockPong)] = &PacketStreamClient::handle_message<ClockPong, &PacketStreamClient::handle_clock_pong>;
+    handlers[packet_type_index(PacketType::Hello)] = &PacketStreamClient::handle_message<Hello, &PacketStreamClient::handle_hello>;
+
+    return handlers;
+}
+
+template <typename Message, PacketStreamClient::PacketHandling (PacketStreamClient::*Handler)(const Message&)>
+PacketStreamClient::PacketHandling PacketStreamClient::handle_message(const std::byte* body, uint32_t body_size, FrameView&) {
+    Message message;
+
+    if (!read_packet_message(body, body_size, message))
+    {
+        return PacketHandling::Malformed;
+    }
+
+    return (this->*Handler)(message);
+}
+
+PacketStreamClient::PacketHandling PacketStreamClient::handle_frame(const std::byte* body, uint32_t body_size, FrameView& frame_view) {
+    auto frame_view_opt = parse_frame_view(body, body_size);
+
+    if (!frame_view_opt)
+    {
+        return PacketHandling::Malformed;
+    }
+
+    frame_view = frame_view_opt.value();
+    m_stats.keyframes++;
+
+    return PacketHandling::Frame;
+}
+
+PacketStreamClient::PacketHandling PacketStreamClient::handle_frame_delta(const std::byte* body, uint32_t body_size, FrameView& frame_view) {
+    auto result = m_delta_decoder.apply(body, body_size, m_delta_frame);
+
+    if (result == FrameDeltaResult::UnknownBaseline)
+    {
+        // Not malformed, the frame simply cannot be rebuilt without a keyframe
+        send_frame_ack(0, FrameAckFlag::KeyframeRequest);
+        m_stats.keyframe_requests++;
+
+        return PacketHandling::Consumed;
+    }
+
+    if (result != FrameDeltaResult::Ok)
+    {
+        return PacketHandling::Malformed;
+    }
+
+    frame_view = make_frame_view(m_delta_frame);
+    m_stats.delta_frames++;
+
+    return PacketHandling::Frame;
+}
+
+PacketStreamClient::PacketHandling PacketStreamClient::handle_frame_batch(const std::byte* body, uint32_t body_size, FrameView& frame_view) {
+    m_frame_batch = parse_frame_batch(body, body_size);
+    m_frame_batch_index = 0;
+
+    if (!m_frame_batch)
+    {
+        return PacketHandling::Malformed;
+    }
+
+    // Only the newest frame of the batch is of interest in catch-up mode
+    if (m_catch_up_enabled)
+    {
+        m_frame_batch_index = m_frame_batch->size() - 1;
+        m_stats.skipped_frames += m_frame_batch_index;
+    }
+
+    auto frame_view_opt = next_batch_frame_view();
+
+    if (!frame_view_opt)
+    {
+        return PacketHandling::Consumed;
+    }
+
+    frame_view = frame_view_opt.value();
+
+    return PacketHandling::Frame;
+}
+
+PacketStreamClient::PacketHandling PacketStreamClient::handle_unknown_packet(const std::byte*, uint32_t, FrameView&) {
+    m_stats.unknown_packets++;
+
+    return PacketHandling::Consumed;
+}
+
+PacketStreamClient::PacketHandling PacketStreamClient::handle_clock_pong(const ClockPong& pong) {
+    // The pong is the ready packet, it may have been buffered behind others since an earlier read
+    const auto packet_end = m_parser.read_position() + sizeof(PacketHeader) + packet_body_size(m_parser.ready_header().value());
+
+    if (!m_clock_sync.add_pong(pong, receive_time_of(packet_end)))
+    {
+        return PacketHandling::Malformed;
+    }
+
+    m_stats.clock_pongs++;
+
+    return PacketHandling::Consumed;
+}
+
+PacketStreamClient::PacketHandling PacketStreamClient::handle_hello(const Hello& hello) {
+    if (hello.min_protocol_version > PACKET_PROTOCOL_VERSION || hello.protocol_version < PACKET_MIN_PROTOCOL_VERSION)
+    {
+        std::cerr << "The server speaks protocol versions " << hello.min_protocol_version << " to " << hello.protocol_version
+            << ", this client " << PACKET_MIN_PROTOCOL_VERSION << " to " << PACKET_PROTOCOL_VERSION << "\n";
+
+        // Reconnecting would not help, and nothing behind the Hello can be decoded
+        interrupt();
+        m_parser.reset();
+
+        return PacketHandling::Consumed;
+    }
+
+    m_protocol_version = std::min(hello.protocol_version, PACKET_PROTOCOL_VERSION);
+
+    // Older versions left the field reserved
+    m_server_capabilities = m_protocol_version >= LOD_PROTOCOL_VERSION ? hello.capabilities : 0;
+
+    return PacketHandling::Consumed;
+}
+
+std::optional<FrameView> PacketStreamClient::next_batch_frame_view() {
+    while (m_frame_batch_index < m_frame_batch->size())
+    {
+        if (auto frame_view_opt = m_frame_batch->frame(m_frame_batch_index++))
+        {
+            m_stats.keyframes++;
+
+            return frame_view_opt;
+        }
+
+        // Only this frame is lost, the offset table still points at the next one
+        m_stats.malformed_packets++;
+    }
+
+    m_frame_batch.reset();
+
+    return std::nullopt;
+}
+
+std::optional<FrameView> PacketStreamClient::decode_packet(const ParsedPacket& packet) {
+    auto body = packet.body;
+    auto body_size = packet.body_size;
+
+    if (has_packet_flag(packet.flags, PacketFlag::Compressed))
+    {
+        if (!m_decompressor.decompress(body, body_size, packet.flags))
         {
+            m_parser.release_packet();
+            m_stats.malformed_packets++;
+
+            return std::nullopt;
+        }
+
+        body = m_decompressor.body().data();
+        body_size = static_cast<uint32_t>(m_decompressor.body().size());
+    }
+
+    static constexpr auto PACKET_HANDLERS = make_packet_handlers();
+
+    FrameView frame_view;
+
+    switch ((this->*PACKET_HANDLERS[packet_type_index(packet.type)])(body, body_size, frame_view))
+    {
+        case PacketHandling::Frame:
             break;
+
+        case PacketHandling::Consumed:
+            // Not a frame
+            m_parser.release_packet();
+
+            return std::nullopt;
+
+        case PacketHandling::Malformed:
+            // The packet is complete but its body is malformed, drop it
+            m_parser.release_packet();
+            m_stats.malformed_packets++;
+
+            return std::nullopt;
+    }
+
+    finish_frame(frame_view);
+
+    return frame_view;
+}
+
+void PacketStreamClient::finish_frame(const FrameView& frame_view) {
+    if (m_delta_frames_enabled)
+    {
+        m_delta_decoder.store_baseline(frame_view);
+        send_frame_ack(frame_view.header.timestamp, FrameAckFlag::None);
+    }
+
+    m_has_last_frame = true;
+    m_last_frame_timestamp = frame_view.header.timestamp;
+
+    if (m_awaiting_first_frame)
+    {
+        const auto time_to_first_frame = std::chrono::duration_cast<std::chrono::microseconds>(SocketClock::now() - m_connection_lost_at);
+
+        m_stats.last_time_to_first_frame_us = static_cast<uint64_t>(time_to_first_frame.count());
+        m_stats.total_time_to_first_frame_us += m_stats.last_time_to_first_frame_us;
+        m_awaiting_first_frame = false;
+    }
+}
+
+void PacketStreamClient::catch_up() {
+    if (m_frame_batch)
+    {
+        // A batch that is being handed out is cut short to its newest frame, the packets behind it wait for the next call
+        if (m_frame_batch_index < m_frame_batch->size())
+        {
+            m_stats.skipped_frames += m_frame_batch->size() - 1 - m_frame_batch_index;
+            m_frame_batch_index = m_frame_batch->size() - 1;
+
+            return;
         }
 
-        while (true)
+        m_frame_batch.reset();
+        m_parser.release_packet();
+    }
+
+    skip_superseded_frames();
+
+    // A read that came back short has emptied the socket, only a full one may have left data behind
+    while (m_read_filled && m_parser.free_space() > 0 && refill_buffer(SocketDeadline::min()))
+    {
+        skip_superseded_frames();
+    }
+}
+
+void PacketStreamClient::skip_superseded_frames() {
+    while (auto header_opt = m_parser.ready_header())
+    {
+        const auto type = packet_type(header_opt.value());
+
+        // Control packets carry no frame, they are handled right away
+        if (type != PacketType::Frame && type != PacketType::FrameDelta && type != PacketType::FrameBatch)
         {
-            if (m_buffer.size() < sizeof(PacketHeader))
-            {
-                break;
-            }
+            decode_packet(m_parser.next_packet().value());
 
-            auto packet_header_opt = try_extract_packet_header();
+            continue;
+        }
+
+        // Only a newer frame supersedes this one, it is kept for the caller otherwise
+        if (!m_parser.has_following_packet({ PacketType::Frame, PacketType::FrameDelta, PacketType::FrameBatch }))
+        {
+            return;
+        }
 
-            if (!packet_header_opt)
+        if (type == PacketType::Frame)
+        {
+            if (m_skipped_packet_consumer)
             {
-                continue;
+                m_skipped_packet_consumer(m_parser.next_packet().value());
             }
 
-            auto packet_header = packet_header_opt.value();
+            // Neither decompressed nor parsed
+            m_parser.release_packet();
+            m_stats.skipped_frames++;
 
-            if (!is_valid_packet_size(packet_header))
-            {
-                std::cerr << "Invalid packet size\n";
+            continue;
+        }
 
-                return frames;
-            }
+        const auto packet = m_parser.next_packet().value();
 
-            auto frame_opt = try_extract_frame(packet_header);
+        if (m_skipped_packet_consumer)
+        {
+            m_skipped_packet_consumer(packet);
+        }
 
-            if (frame_opt)
-            {
-                frames.push_back(frame_opt.value());
-            }
-            else
-            {
-                break;
-            }
+        if (type == PacketType::FrameBatch)
+        {
+            // Not decompressed either, so only an uncompressed batch tells its frame count
+            const auto frame_batch_opt = has_packet_flag(packet.flags, PacketFlag::Compressed) ?
+                std::nullopt : parse_frame_batch(packet.body, packet.body_size);
+
+            m_parser.release_packet();
+            m_stats.skipped_frames += frame_batch_opt ? frame_batch_opt->size() : 1;
+
+            continue;
+        }
+
+        // Deltas are applied to keep the baseline chain intact
+        if (decode_packet(packet))
+        {
+            m_parser.release_packet();
+            m_stats.skipped_frames++;
         }
     }
+}
 
-    return frames;
+SocketDeadline PacketStreamClient::packet_deadline() const {
+    if (m_packet_read_timeout <= std::chrono::milliseconds::zero())
+    {
+        return SocketDeadline::max();
+    }
+
+    return SocketClock::now() + m_packet_read_timeout;
 }
 
-bool PacketStreamClient::refill_buffer() {
-    if (!m_server_connected)
+bool PacketStreamClient::refill_buffer(SocketDeadline deadline) {
+    if (!m_server_connected && (!m_reconnecting || !advance_reconnect(deadline)))
     {
         return false;
     }
 
-    std::array<std::byte, TEMP_BUFFER_SIZE> temp;
+    if (m_transport == PacketTransport::Udp)
+    {
+        return refill_buffer_from_datagrams(deadline);
+    }
 
-    auto bytes_received = m_client_socket.recv_data(temp.data(), temp.size());
+    if (m_transport == PacketTransport::SharedMemory)
+    {
+        return refill_buffer_from_shared_memory(deadline);
+    }
+
+    // The buffer is already full of unconsumed packets
+    if (m_parser.free_space() == 0)
+    {
+        return true;
+    }
+
+    // Receive straight into the free space of the parser, across the wrap point if needed
+    auto regions = m_parser.write_regions(m_read_size);
+
+    auto bytes_received = m_client_socket.recv_data(
+        regions[0].data, regions[0].size,
+        regions[1].data, regions[1].size,
+        deadline
+    );
+
+    if (bytes_received == SOCKET_TIMEOUT)
+    {
+        m_read_filled = false;
+
+        // Running out of data while polling is not a timeout
+        if (deadline != SocketDeadline::min())
+        {
+            m_stats.read_timeouts++;
+        }
+
+        return false;
+    }
 
     if (bytes_received <= 0)
     {
-        disconnect();
+        handle_connection_loss();
 
         return false;
     }
     
-    m_buffer.insert(m_buffer.end(), temp.data(), temp.data() + bytes_received);
+    m_parser.commit(static_cast<size_t>(bytes_received));
+    record_receive_time(m_client_socket.last_receive_timestamp().value_or(SocketClock::now()));
+    adapt_read_size(static_cast<size_t>(bytes_received), regions[0].size + regions[1].size);
+
+    m_read_filled = static_cast<size_t>(bytes_received) == regions[0].size + regions[1].size;
 
     return true;
 }
 
-void PacketStreamClient::consume_buffer(size_t size) {
-    if (size >= m_buffer.size())
+bool PacketStreamClient::refill_buffer_from_datagrams(SocketDeadline deadline) {
+    auto packet_size = m_datagram_receiver.receive_packet(deadline);
+
+    if (packet_size == SOCKET_TIMEOUT)
     {
-        m_buffer.clear();
+        m_read_filled = false;
+
+        // Running out of data while polling is not a timeout
+        if (deadline != SocketDeadline::min())
+        {
+            m_stats.read_timeouts++;
+        }
+
+        return false;
     }
-    else
+
+    if (packet_size <= 0)
     {
-        m_buffer.erase(
-            m_buffer.begin(),
-            m_buffer.begin() + static_cast<ssize_t>(size)
-        );
+        handle_connection_loss();
+
+        return false;
+    }
+
+    const auto& packet = m_datagram_receiver.packet();
+
+    // Feeding only part of a packet would break the stream, so a packet that does not fit is dropped
+    if (m_parser.free_space() < packet.size())
+    {
+        m_stats.dropped_packets++;
+
+        return true;
     }
+
+    m_parser.feed(packet.data(), packet.size());
+    record_receive_time(SocketClock::now());
+
+    // There is no telling how many datagrams are still queued
+    m_read_filled = true;
+
+    return true;
 }
 
-std::optional<PacketHeader> PacketStreamClient::try_extract_packet_header() {
-    if(m_buffer.size() < sizeof(PacketHeader))
+bool PacketStreamClient::refill_buffer_from_shared_memory(SocketDeadline deadline) {
+    // Everything the parser is done with goes back to the writer before waiting for more
+    m_shm_reader.release(m_parser.read_position());
+
+    auto bytes_available = m_shm_reader.wait_for_data(m_parser.write_position(), deadline);
+
+    if (bytes_available == SOCKET_TIMEOUT)
     {
-        return std::nullopt;
+        m_read_filled = false;
+
+        // Running out of data while polling is not a timeout
+        if (deadline != SocketDeadline::min())
+        {
+            m_stats.read_timeouts++;
+        }
+
+        return false;
+    }
+
+    if (bytes_available <= 0)
+    {
+        handle_connection_loss();
+
+        return false;
     }
 
-    // Read the first 4 bytes of the buffer and check if its a magic number
-    PacketHeader packet_header;
-    memcpy(&packet_header, m_buffer.data(), sizeof(PacketHeader));
+    // The bytes are already in place, they only have to be handed to the parser
+    m_parser.commit(static_cast<size_t>(bytes_available));
+    record_receive_time(SocketClock::now());
+
+    // Everything the writer had published was taken
+    m_read_filled = false;
+
+    return true;
+}
 
-    if (packet_header.magic_number != m_magic_number)
+bool PacketStreamClient::open_frame_channel() {
+    // The stream positions of the reads before are meaningless for the new channel
+    m_received_read_count = 0;
+
+    switch (m_transport)
     {
-        m_buffer.erase(m_buffer.begin());
+        case PacketTransport::Udp:
+            // The datagrams are subscribed to over the control channel
+            if (!m_datagram_receiver.open())
+            {
+                std::cerr << "Failed to open the datagram socket" << "\n";
 
-        return std::nullopt;
+                return false;
+            }
+            break;
+
+        case PacketTransport::SharedMemory:
+            if (!m_shm_reader.open(m_shared_memory_name))
+            {
+                return false;
+            }
+
+            if (m_shm_reader.capacity() < m_parser.max_packet_size())
+            {
+                std::cerr << "Shared memory ring is smaller than the maximum packet size" << "\n";
+                m_shm_reader.close();
+
+                return false;
+            }
+
+            m_parser.attach_storage(m_shm_reader.data(), m_shm_reader.capacity(), m_shm_reader.read_position());
+            break;
+
+        default:
+            break;
     }
 
-    return packet_header;
+    return true;
 }
 
-std::optional<Frame> PacketStreamClient::try_extract_frame(const PacketHeader& packet_header) {
-    const auto total_packet_size = sizeof(PacketHeader) + packet_header.body_size;
+void PacketStreamClient::close_frame_channel() {
+    m_datagram_receiver.close();
+    m_frame_batch.reset();
 
-    if (m_buffer.size() < total_packet_size)
+    // The parser must let go of the ring before it is unmapped
+    if (m_shm_reader.is_open())
     {
-        const auto bytes_needed = sizeof(PacketHeader) + packet_header.body_size - m_buffer.size();
+        m_parser.detach_storage();
+        m_shm_reader.close();
+    }
+}
+
+void PacketStreamClient::adapt_read_size(size_t bytes_received, size_t bytes_requested) {
+    /*
+        A read that filled the whole request means more data is likely
+        waiting in the kernel, so the next read asks for more. Reads that
+        come back mostly empty shrink the request again, which keeps a
+        single read from copying a huge backlog before anything is parsed
+    */
+    if (bytes_received == bytes_requested)
+    {
+        m_read_size = std::min(m_read_size * 2, MAX_READ_SIZE);
+    }
+    else if (bytes_received < bytes_requested / 4)
+    {
+        m_read_size = std::max(m_read_size / 2, MIN_READ_SIZE);
+    }
+}
 
-        // Receive extra bytes
-        auto extra_packet_opt = m_client_socket.recv_exact(bytes_needed);
-        
-        if (!extra_packet_opt)
+void PacketStreamClient::consume_pending_packet() {
+    if (m_packet_pending)
+    {
+        m_packet_pending = false;
+
+        // The batch packet is released with its last frame, see next_buffered_frame_view()
+        if (m_frame_batch)
         {
-            return std::nullopt;
+            return;
         }
-        
-        // Join the rest of buffer and extra bytes
-        m_buffer.insert(
-            m_buffer.end(),
-            extra_packet_opt->begin(),
-            extra_packet_opt->end()
-        );
+
+        m_parser.release_packet();
+
+        // Frees the space of the handed out frame for the server right away
+        m_shm_reader.release(m_parser.read_position());
     }
+}
 
-    std::vector<std::byte> frame_data(
-        m_buffer.begin() + sizeof(PacketHeader),
-        m_buffer.begin() + sizeof(PacketHeader) + packet_header.body_size
-    );
+void PacketStreamClient::record_receive_time(SocketClock::time_point receive_time) {
+    m_last_receive_time = receive_time;
+
+    // The oldest read is forgotten when the history is full, packets that old are long decoded
+    if (m_received_read_count == RECEIVED_READ_HISTORY)
+    {
+        m_received_read_first = (m_received_read_first + 1) % RECEIVED_READ_HISTORY;
+        m_received_read_count--;
+    }
+
+    auto& read = m_received_reads[(m_received_read_first + m_received_read_count) % RECEIVED_READ_HISTORY];
+    read.end_position = m_parser.write_position();
+    read.receive_time = receive_time;
+
+    m_received_read_count++;
+}
+
+SocketClock::time_point PacketStreamClient::receive_time_of(uint64_t stream_position) {
+    /*
+        The first read that reached the position completed the packet. Reads
+        before it are dropped, later packets can only be completed by it or
+        by reads after it
+    */
+    while (m_received_read_count > 0)
+    {
+        const auto& read = m_received_reads[m_received_read_first];
+
+        if (read.end_position >= stream_position)
+        {
+            return read.receive_time;
+        }
+
+        m_received_read_first = (m_received_read_first + 1) % RECEIVED_READ_HISTORY;
+        m_received_read_count--;
+    }
+
+    return m_last_receive_time;
+}
+
+void PacketStreamClient::send_frame_ack(uint32_t timestamp, FrameAckFlag flag) {
+    FrameAck frame_ack;
+    frame_ack.timestamp = timestamp;
+    frame_ack.flags = static_cast<uint32_t>(flag);
+
+    m_send_buffer.clear();
+    append_packet(m_send_buffer, m_magic_number, PacketType::FrameAck, reinterpret_cast<const std::byte*>(&frame_ack), sizeof(FrameAck));
+
+    // A lost ack only delays the next baseline, so the result is not checked
+    m_client_socket.send_data(m_send_buffer);
+}
+
+void PacketStreamClient::send_clock_ping_if_due() {
+    if (m_clock_sync_interval <= std::chrono::milliseconds::zero() || !m_server_connected)
+    {
+        return;
+    }
+
+    const auto now = SocketClock::now();
+
+    if (now < m_next_clock_ping)
+    {
+        return;
+    }
+
+    const auto interval = m_clock_sync.sample_count() < CLOCK_SYNC_WARMUP_SAMPLES
+        ? std::min<std::chrono::milliseconds>(m_clock_sync_interval, CLOCK_SYNC_WARMUP_INTERVAL)
+        : m_clock_sync_interval;
+
+    m_next_clock_ping = now + interval;
+
+    auto ping = m_clock_sync.make_ping();
+
+    m_send_buffer.clear();
+    append_packet(m_send_buffer, m_magic_number, PacketType::ClockPing, reinterpret_cast<const std::byte*>(&ping), sizeof(ClockPing));
+
+    // A lost ping only delays the next sample
+    m_client_socket.send_data(m_send_buffer);
+    m_stats.clock_pings++;
+}
+
+void PacketStreamClient::send_lod_report_if_due() {
+    if (!m_lod_enabled || !m_server_connected || !has_peer_capability(m_server_capabilities, PeerCapability::LevelOfDetail))
+    {
+        return;
+    }
+
+    const auto now = SocketClock::now();
+
+    if (now < m_next_lod_report)
+    {
+        return;
+    }
+
+    m_next_lod_report = now + m_lod.options().report_interval;
+
+    auto report = m_lod.make_report();
+
+    m_send_buffer.clear();
+    append_packet(m_send_buffer, m_magic_number, PacketType::LodReport, reinterpret_cast<const std::byte*>(&report), sizeof(LodReport));
+
+    // A lost report only keeps the previous limit a little longer
+    m_client_socket.send_data(m_send_buffer);
+    m_stats.lod_reports++;
+}
+
+void PacketStreamClient::send_hello() {
+    Hello hello = {};
+    hello.protocol_version = PACKET_PROTOCOL_VERSION;
+    hello.min_protocol_version = PACKET_MIN_PROTOCOL_VERSION;
+    hello.capabilities = m_lod_enabled ? static_cast<uint32_t>(PeerCapability::LevelOfDetail) : 0;
+
+    m_protocol_version = LEGACY_PROTOCOL_VERSION;
+    m_server_capabilities = 0;
 
-    auto frame_opt = deserialize_frame(frame_data);
+    m_send_buffer.clear();
+    append_packet(m_send_buffer, m_magic_number, PacketType::Hello, reinterpret_cast<const std::byte*>(&hello), sizeof(Hello));
 
-    if (frame_opt)
+    // A server that misses it simply keeps speaking version 1
+    m_client_socket.send_data(m_send_buffer);
+}
+
+void PacketStreamClient::handle_connection_loss() {
+    disconnect();
+
+    m_read_filled = false;
+    m_stats.connection_losses++;
+
+    // interrupt() shuts the connection down on purpose
+    if (!m_reconnect_options.enabled || m_interrupted)
     {
-        consume_buffer(total_packet_size);
+        return;
     }
 
-    return frame_opt;
+    std::cerr << "Lost the connection to the server, reconnecting" << "\n";
+
+    m_reconnecting = true;
+    m_connection_lost_at = SocketClock::now();
+    m_next_reconnect_attempt = m_connection_lost_at;
+    m_reconnect_backoff = m_reconnect_options.initial_backoff;
 }
 
-bool PacketStreamClient::is_valid_packet_size(const PacketHeader& packet_header) {
-    // Validation for packet size
-    auto expr_1 = packet_header.body_size > 0;
-    auto expr_2 = packet_header.body_size + sizeof(PacketHeader) <= m_max_packet_size;
+bool PacketStreamClient::advance_reconnect(SocketDeadline deadline) {
+    while (m_reconnecting && !m_interrupted)
+    {
+        if (m_client_socket.is_connect_pending())
+        {
+            auto result = m_client_socket.finish_connect(std::min(deadline, m_connect_deadline));
+
+            if (result == SocketConnectResult::Connected)
+            {
+                return resume_session();
+            }
+
+            // The caller's deadline expired first, the attempt goes on with the next call
+            if (result == SocketConnectResult::InProgress && SocketClock::now() < m_connect_deadline)
+            {
+                return false;
+            }
+
+            m_client_socket.disconnect();
+            schedule_reconnect_attempt();
+
+            continue;
+        }
+
+        // Wait out the backoff, but never past the caller's deadline
+        if (SocketClock::now() < m_next_reconnect_attempt)
+        {
+            if (deadline < m_next_reconnect_attempt)
+            {
+                std::this_thread::sleep_until(deadline);
+
+                return false;
+            }
 
-    return expr_1 && expr_2;
+            std::this_thread::sleep_until(m_next_reconnect_attempt);
+        }
+
+        m_stats.reconnect_attempts++;
+        m_connect_deadline = SocketClock::now() + m_reconnect_options.connect_timeout;
+
+        auto result = m_client_socket.begin_connect();
+
+        if (result == SocketConnectResult::Connected)
+        {
+            return resume_session();
+        }
+
+        if (result == SocketConnectResult::Failed)
+        {
+            schedule_reconnect_attempt();
+        }
+    }
+
+    return false;
 }
+
+void PacketStreamClient::schedule_reconnect_attempt() {
+    m_next_reconnect_attempt = SocketClock::now() + m_reconnect_backoff;
+    m_reconnect_backoff = std::min(m_reconnect_backoff * 2, m_reconnect_options.max_backoff);
+}
+
+bool PacketStreamClient::resume_session() {
+    if (!open_frame_channel())
+    {
+        m_client_socket.disconnect();
+        schedule_reconnect_attempt();
+
+        return false;
+    }
+
+    m_server_connected = true;
+    m_reconnecting = false;
+
+    // A packet cut off by the old connection can never be completed
+    m_parser.reset();
+    m_packet_pending = false;
+    m_frame_batch.reset();
+    m_read_size = INITIAL_READ_SIZE;
+
+    /*
+        Baselines are only keyed by frame timestamp, and a restarted server
+        may hand out the same timestamps for other frames. Deltas wait for
+        the keyframe the server sends in reply to the ResumeRequest
+    */
+    m_delta_decoder.clear();
+
+    m_awaiting_first_frame = true;
+    m_stats.reconnects++;
+
+    // A restarted server has another clock, its samples start over with the fast warm-up pings
+    m_clock_sync.reset();
+    m_next_clock_ping = SocketClock::now();
+
+    // The new server may speak another version than the old one
+    send_hello();
+
+    ResumeRequest resume_request;
+    resume_request.last_timestamp = m_last_frame_timestamp;
+    resume_request.flags = static_cast<uint32_t>(m_has_last_frame ? ResumeFlag::HasLastFrame : ResumeFlag::None);
+
+    m_send_buffer.clear();
+    append_packet(m_send_buffer, m_magic_number, PacketType::Resume, reinterpret_cast<const std::byte*>(&resume_request), sizeof(ResumeRequest));
+
+    // Without the request the server still streams, only the first keyframe may take longer
+    m_client_socket.send_data(m_send_buffer);
+
+    return true;
+}
\ No newline at end of file
@@ -1,41 +1,455 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <functional>
 #include "../socket/socket.hpp"
+#include "../datagram/datagram.hpp"
+#include "packet_parser.hpp"
 #include "../frame/frame_template.hpp"
 #include "../frame/frame_serializer.hpp"
+#include "../frame/frame_view.hpp"
+#include "../frame/frame_pool.hpp"
+#include "../frame/frame_delta.hpp"
+#include "../frame/frame_batch.hpp"
+#include "../frame/frame_compression.hpp"
+#include "../input/input.hpp"
+#include "../clock_sync/clock_sync.hpp"
+#include "../shm_ring/shm_ring.hpp"
+#include "../latency_histogram/latency_histogram.hpp"
+#include "../lod/lod.hpp"
+
+struct PacketStreamStats {
+    // Number of times the stream lost the packet boundary and had to search for a magic number
+    uint64_t resync_count   = 0;
+    uint64_t skipped_bytes  = 0;
+
+    // Magic number matches dropped because of an impossible body size
+    uint64_t invalid_sizes  = 0;
+
+    // Packets dropped because of their PacketChecksum, see PacketParser::set_checksum_required()
+    uint64_t checksum_failures = 0;
+
+    // Complete packets whose body did not match the frame layout
+    uint64_t malformed_packets = 0;
+
+    // Reads that gave up because a deadline expired
+    uint64_t read_timeouts  = 0;
+
+    /*
+        System calls spent on receiving, divide their sum by
+        frames_received to get the syscall count per frame
+    */
+    uint64_t recv_calls     = 0;
+    uint64_t wait_calls     = 0;
+    uint64_t ring_enter_calls = 0;
+    uint64_t setsockopt_calls = 0;
+    uint64_t frames_received = 0;
+
+    // Frames reconstructed from deltas, and full frames (keyframes) among frames_received
+    uint64_t delta_frames   = 0;
+    uint64_t keyframes      = 0;
+
+    // Deltas whose baseline was unknown, each one asked the server for a keyframe
+    uint64_t keyframe_requests = 0;
+
+    // Packets of a type the client does not handle
+    uint64_t unknown_packets = 0;
+
+    // Bodies that arrived with PacketFlag::Compressed
+    FrameCompressionStats decompression;
+
+    // Loss statistics of the UDP transport
+    DatagramStats datagrams;
+
+    // Complete packets received over UDP while the buffer was full of unconsumed frames
+    uint64_t dropped_packets = 0;
+
+    /*
+        Frames superseded by a newer packet in catch-up mode and never handed
+        out. Full frames among them were skipped without parsing the body
+    */
+    uint64_t skipped_frames = 0;
+
+    // Input packets sent, and those the socket did not take
+    uint64_t input_packets  = 0;
+    uint64_t input_send_failures = 0;
+
+    // Clock pings sent, and pongs that answered one of them
+    uint64_t clock_pings    = 0;
+    uint64_t clock_pongs    = 0;
+
+    // Level of detail reports sent, see PacketStreamClient::set_level_of_detail()
+    uint64_t lod_reports    = 0;
+
+    // Connections closed by the server or the network, and how they were recovered
+    uint64_t connection_losses  = 0;
+    uint64_t reconnect_attempts = 0;
+    uint64_t reconnects         = 0;
+
+    /*
+        Time from noticing a connection loss to the first frame received
+        over the new connection, for the last reconnect and summed over all
+    */
+    uint64_t last_time_to_first_frame_us  = 0;
+    uint64_t total_time_to_first_frame_us = 0;
+
+    /*
+        Time from receiving the bytes that completed a frame to handing the
+        decoded frame out, see PacketStreamClient::frame_receive_time()
+    */
+    LatencyHistogram receive_to_decode;
+
+    // Reads that came with a kernel receive timestamp, see SocketOptions::receive_timestamps
+    uint64_t timestamped_reads = 0;
+
+    // Reads that found data while spinning, and spins that ran out of budget
+    uint64_t spin_hits      = 0;
+    uint64_t spin_misses    = 0;
+};
 
 /*
-    To-Do: Optimize the part of finding a magic number
+    Automatic reconnect after the connection was lost. The first attempt
+    is made at once, the delay before every further one doubles up to
+    max_backoff. The connect itself never blocks a retrieve call beyond
+    its deadline. Not meant for streams driven by an external event loop
+    (StreamHub), whose socket would change underneath it
 */
+struct ReconnectOptions {
+    bool                        enabled         = false;
+    std::chrono::milliseconds   initial_backoff = std::chrono::milliseconds(50);
+    std::chrono::milliseconds   max_backoff     = std::chrono::milliseconds(2000);
+
+    // An attempt that has not connected by then counts as failed
+    std::chrono::milliseconds   connect_timeout = std::chrono::milliseconds(1000);
+};
+
+/*
+    Sees the raw packets of frames skipped in catch-up mode, e.g., to record
+    them. The body may still be compressed and is only valid during the call
+*/
+using SkippedPacketConsumer = std::function<void(const ParsedPacket& packet)>;
+
+enum class PacketTransport {
+    Tcp,
+
+    /*
+        Frames are received as datagrams so that a lost segment never delays
+        later frames, stale and incomplete frames are dropped. The TCP
+        connection stays open as the control channel (e.g. frame acks)
+    */
+    Udp,
+
+    /*
+        For a server on the same host. Packets are parsed in place out of a
+        shared memory ring (see shm_ring.hpp) created by the server, so
+        frames are handed out without a single copy or system call while
+        data keeps coming. The TCP connection stays open as the control channel
+    */
+    SharedMemory,
+};
 
 class PacketStreamClient {
 public:
-    PacketStreamClient(std::string_view server_addr, uint16_t server_port, uint32_t magic_number, uint32_t max_packet_size);
+    // Throws std::invalid_argument if max_packet_size is above PACKET_BODY_SIZE_MASK
+    PacketStreamClient(
+        std::string_view server_addr,
+        uint16_t server_port,
+        uint32_t magic_number,
+        uint32_t max_packet_size,
+        PacketTransport transport = PacketTransport::Tcp
+    );
     ~PacketStreamClient();
 
     bool connect_to_server();
+    bool connect_to_server(std::chrono::milliseconds timeout);
     void disconnect();
+    bool is_connected() const;
+
+    // Unblocks a pending retrieve call and suppresses the reconnect, safe to call from another thread
+    void interrupt();
+
+    /*
+        With reconnects enabled, a lost connection is re-established by the
+        retrieve functions, which return nothing in the meantime. A Resume
+        packet carrying the timestamp of the last received frame is sent
+        first on the new connection
+    */
+    void set_reconnect_options(const ReconnectOptions& options);
+
+    // Whether the connection was lost and is being re-established
+    bool is_reconnecting() const;
 
     std::optional<Frame> retrieve_frame(size_t max_attempts = 10);
     std::vector<Frame> retrieve_all_frames(size_t max_attempts = 10);
 
+    /*
+        Allocation-free variants once warmed up. The frame is decoded into
+        the given one, and retrieve_all_frames appends frames acquired from
+        the pool, which the caller gives back with FramePool::release()
+    */
+    bool retrieve_frame(Frame& frame, size_t max_attempts = 10);
+    size_t retrieve_all_frames(std::vector<Frame>& frames, FramePool& frame_pool, size_t max_attempts = 10);
+
+    /*
+        Zero-copy variant of retrieve_frame. The view points into the
+        receive buffer and stays valid until the next call to any of
+        the retrieve functions
+    */
+    std::optional<FrameView> retrieve_frame_view(size_t max_attempts = 10);
+
+    /*
+        Returns the next frame, or std::nullopt once the deadline has passed.
+        Partially received packets are kept and completed by the next call
+    */
+    std::optional<Frame> wait_for_frame(SocketDeadline deadline);
+    std::optional<FrameView> wait_for_frame_view(SocketDeadline deadline);
+
+    /*
+        Never waits: returns a buffered frame, or reads what the socket
+        already holds (at most once) and returns a frame if that completed
+        one. Meant for an external event loop (see StreamHub), which calls
+        it until it returns std::nullopt whenever the socket is readable
+    */
+    std::optional<FrameView> poll_frame_view();
+
+    /*
+        Upper bound on the wall-clock time each read of the retrieve functions
+        may block for, zero (the default) means no bound
+    */
+    void set_packet_read_timeout(std::chrono::milliseconds timeout);
+
+    /*
+        SO_RCVBUF, TCP_NODELAY, TCP_QUICKACK, the receive backend, busy
+        polling and receive timestamps of the underlying socket
+    */
+    bool set_socket_options(const SocketOptions& options);
+
+    // The receive backend actually in use, io_uring falls back to recv where it is unavailable
+    SocketReceiveBackend receive_backend() const;
+
+    // The TCP connection, for registering with an external event loop
+    SOCKET native_handle() const;
+
+    /*
+        Acknowledges every received frame so the server can send deltas
+        against it. Deltas are always decoded, this only controls the acks
+    */
+    void set_delta_frames_enabled(bool enabled);
+
+    // Only accepts packets carrying a PacketChecksum, checksummed packets are verified either way
+    void set_checksum_required(bool required);
+
+    // Name of the ring the server writes to, used by the SharedMemory transport
+    void set_shared_memory_name(std::string name);
+
+    // Emulates loss, duplication and reordering of received datagrams, for testing over loopback
+    void set_datagram_loss_emulation(const DatagramLossOptions& options);
+
+    /*
+        Catch-up mode for clients that only show the newest frame. Every
+        retrieve call first takes in what the socket already holds and skips
+        each frame that a newer complete frame, delta or batch supersedes,
+        walking the packet headers only. Control packets are handled as
+        usual and never supersede a frame. Deltas are still applied, later
+        deltas may use them as baseline, but they are not handed out either
+    */
+    void set_catch_up_enabled(bool enabled);
+    void set_skipped_packet_consumer(SkippedPacketConsumer consumer);
+
+    /*
+        Sends the input recorded during the tick that just ended, call it
+        once per tick. Returns false if nothing was recorded or sending
+        failed, the commands are repeated by the next packets anyway
+    */
+    bool send_input(InputChannel& input_channel);
+
+    /*
+        Sends a ClockPing over the TCP connection at every interval, checked
+        by the retrieve functions, zero (the default) disables the pings.
+        The first few are sent faster so that the estimate settles quickly.
+        The server answers with a ClockPong on the channel its frames use
+    */
+    void set_clock_sync_interval(std::chrono::milliseconds interval);
+
+    // The relation between the server clock and the local clock, see ClockSync
+    const ClockSync& clock_sync() const;
+    std::optional<LocalClock::time_point> server_to_local(uint32_t timestamp) const;
+
+    /*
+        Lets the server reduce the bullets of its frames to what this client
+        can decode and draw in time, see lod.hpp. Call before connecting,
+        the capability is announced in the Hello. Reports are only sent to
+        a server that announced it too, at LodOptions::report_interval,
+        checked by the retrieve functions. Decode times are measured by the
+        retrieve functions, render times are reported by the caller
+    */
+    void set_level_of_detail(const LodOptions& options);
+
+    // The time spent drawing frame_count frames holding bullet_count bullets in total
+    void record_render_time(std::chrono::nanoseconds render_time, uint64_t bullet_count, uint32_t frame_count = 1);
+
+    // The bullet limit derived from the measured times, see LodController
+    const LodController& level_of_detail() const;
+
+    /*
+        When the bytes that completed the frame last handed out were
+        received. That is the kernel receive timestamp over TCP with
+        SocketOptions::receive_timestamps, otherwise the time the read
+        returned to user space
+    */
+    SocketClock::time_point frame_receive_time() const;
+
+    /*
+        The protocol version agreed on with the server, see Hello. Each
+        connection starts at version 1 until the server's Hello arrives
+    */
+    uint16_t protocol_version() const;
+
+    PacketStreamStats stats() const;
+
 private:
-    bool refill_buffer();
-    void consume_buffer(size_t size);
-    std::optional<PacketHeader> try_extract_packet_header();
-    std::optional<Frame> try_extract_frame(const PacketHeader& packet_header);
-    bool is_valid_packet_size(const PacketHeader& packet_header);
+    enum class PacketHandling {
+        Frame,      // The handler filled in the frame view
+        Consumed,   // A control packet, or one that is not handed out
+        Malformed,
+    };
+
+    /*
+        Handlers are registered per PacketType in make_packet_handlers(),
+        so dispatching a packet is a single indexed call. Fixed-size
+        messages go through handle_message, which decodes the body first
+    */
+    using PacketHandler = PacketHandling (PacketStreamClient::*)(const std::byte* body, uint32_t body_size, FrameView& frame_view);
+
+    static constexpr std::array<PacketHandler, PACKET_TYPE_COUNT> make_packet_handlers();
+
+    template <typename Message, PacketHandling (PacketStreamClient::*Handler)(const Message&)>
+    PacketHandling handle_message(const std::byte* body, uint32_t body_size, FrameView& frame_view);
+
+    PacketHandling handle_frame(const std::byte* body, uint32_t body_size, FrameView& frame_view);
+    PacketHandling handle_frame_delta(const std::byte* body, uint32_t body_size, FrameView& frame_view);
+    PacketHandling handle_frame_batch(const std::byte* body, uint32_t body_size, FrameView& frame_view);
+    PacketHandling handle_unknown_packet(const std::byte* body, uint32_t body_size, FrameView& frame_view);
+    PacketHandling handle_clock_pong(const ClockPong& pong);
+    PacketHandling handle_hello(const Hello& hello);
+
+    std::optional<FrameView> extract_frame_view(SocketDeadline deadline, size_t max_refills);
+    std::optional<FrameView> next_buffered_frame_view();
+    std::optional<FrameView> next_batch_frame_view();
+    std::optional<FrameView> decode_packet(const ParsedPacket& packet);
+    void finish_frame(const FrameView& frame_view);
+    void catch_up();
+    void skip_superseded_frames();
+    SocketDeadline packet_deadline() const;
+    bool refill_buffer(SocketDeadline deadline);
+    bool refill_buffer_from_datagrams(SocketDeadline deadline);
+    bool refill_buffer_from_shared_memory(SocketDeadline deadline);
+    bool open_frame_channel();
+    void close_frame_channel();
+    void adapt_read_size(size_t bytes_received, size_t bytes_requested);
+    void consume_pending_packet();
+    void record_receive_time(SocketClock::time_point receive_time);
+    SocketClock::time_point receive_time_of(uint64_t stream_position);
+    void send_frame_ack(uint32_t timestamp, FrameAckFlag flag);
+    void send_clock_ping_if_due();
+    void send_lod_report_if_due();
+    void send_hello();
+    void handle_connection_loss();
+    bool advance_reconnect(SocketDeadline deadline);
+    void schedule_reconnect_attempt();
+    bool resume_session();
 
     ClientSocket            m_client_socket;
     bool                    m_server_connected;
 
+    PacketTransport         m_transport;
+    DatagramReceiver        m_datagram_receiver;
+
+    std::string             m_shared_memory_name;
+    ShmRingReader           m_shm_reader;
+
+    uint32_t                m_magic_number;
+    PacketParser            m_parser;
+
+    // Whether the last returned FrameView still references a packet in the parser
+    bool                    m_packet_pending;
+
+    std::chrono::milliseconds m_packet_read_timeout;
+
+    // Adaptive upper bound on the bytes requested by a single read
+    size_t                  m_read_size;
+
+    // Whether the last read filled its request, so that more data is likely waiting
+    bool                    m_read_filled;
+
+    bool                    m_catch_up_enabled;
+    SkippedPacketConsumer   m_skipped_packet_consumer;
+
+    // Owns the body of the last compressed packet, which the returned view points into
+    FrameDecompressor       m_decompressor;
+
+    bool                    m_delta_frames_enabled;
+    FrameDeltaDecoder       m_delta_decoder;
+
+    // Owns the frame reconstructed from the last delta, which the returned view points into
+    Frame                   m_delta_frame;
+
     /*
-        This is used to detect the start of a packet
-        and is fixed at 4 bytes so should not be changed
+        The batch whose frames are being handed out. Its packet stays in the
+        parser (or its body in the decompressor) until the last frame is consumed
     */
-    uint32_t                m_magic_number;
-    uint32_t                m_max_packet_size;
-    std::vector<std::byte>  m_buffer;
+    std::optional<FrameBatchView> m_frame_batch;
+    uint32_t                m_frame_batch_index;
+    std::vector<std::byte>  m_send_buffer;
+    std::vector<std::byte>  m_input_buffer;
+
+    ClockSync               m_clock_sync;
+    std::chrono::milliseconds m_clock_sync_interval;
+    SocketClock::time_point m_next_clock_ping;
+
+    // When the last read returned, for packets older than the read history
+    SocketClock::time_point m_last_receive_time;
+
+    /*
+        Receive time of each recent read, with the stream position it
+        filled the parser up to. Finds the read that completed a packet
+    */
+    struct ReceivedRead {
+        uint64_t                end_position;
+        SocketClock::time_point receive_time;
+    };
+
+    static constexpr size_t RECEIVED_READ_HISTORY = 64;
+
+    std::array<ReceivedRead, RECEIVED_READ_HISTORY> m_received_reads;
+    size_t                  m_received_read_first;
+    size_t                  m_received_read_count;
+    SocketClock::time_point m_frame_receive_time;
+
+    ReconnectOptions        m_reconnect_options;
+    std::atomic<bool>       m_interrupted;
+    bool                    m_reconnecting;
+    std::chrono::milliseconds m_reconnect_backoff;
+    SocketClock::time_point m_next_reconnect_attempt;
+    SocketClock::time_point m_connect_deadline;
+    SocketClock::time_point m_connection_lost_at;
+    bool                    m_awaiting_first_frame;
+
+    uint16_t                m_protocol_version;
+
+    // PeerCapability bits of the server's Hello
+    uint32_t                m_server_capabilities;
+
+    bool                    m_lod_enabled;
+    LodController           m_lod;
+    SocketClock::time_point m_next_lod_report;
+
+    // The last decoded frame, reported to the server when resuming
+    bool                    m_has_last_frame;
+    uint32_t                m_last_frame_timestamp;
+
+    PacketStreamStats       m_stats;
 };
 
 // class PacketStreamServer {
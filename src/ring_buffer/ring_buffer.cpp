@@ -0,0 +1,155 @@
+#include <cstring>
+#include <algorithm>
+#include "ring_buffer.hpp"
+
+namespace {
+    size_t round_up_to_power_of_two(size_t value) {
+        size_t result = 1;
+
+        while (result < value)
+        {
+            result <<= 1;
+        }
+
+        return result;
+    }
+}
+
+RingBuffer::RingBuffer(size_t min_capacity)
+    : m_storage(round_up_to_power_of_two(min_capacity))
+    , m_owned_capacity(m_storage.size())
+    , m_data(m_storage.data())
+    , m_capacity(m_storage.size())
+    , m_mask(m_capacity - 1)
+    , m_read_pos(0)
+    , m_write_pos(0)
+{}
+
+size_t RingBuffer::capacity() const {
+    return m_capacity;
+}
+
+size_t RingBuffer::size() const {
+    return static_cast<size_t>(m_write_pos - m_read_pos);
+}
+
+size_t RingBuffer::free_space() const {
+    return capacity() - size();
+}
+
+bool RingBuffer::empty() const {
+    return m_write_pos == m_read_pos;
+}
+
+size_t RingBuffer::write(const std::byte* data, size_t size) {
+    size = std::min(size, free_space());
+
+    const auto start = static_cast<size_t>(m_write_pos & m_mask);
+    const auto first_part = std::min(size, capacity() - start);
+
+    memcpy(m_data + start, data, first_part);
+
+    // The rest wraps around to the beginning of the storage
+    memcpy(m_data, data + first_part, size - first_part);
+
+    m_write_pos += size;
+
+    return size;
+}
+
+bool RingBuffer::peek(std::byte* dest, size_t size, size_t offset) const {
+    if (offset + size > this->size())
+    {
+        return false;
+    }
+
+    const auto start = static_cast<size_t>((m_read_pos + offset) & m_mask);
+    const auto first_part = std::min(size, capacity() - start);
+
+    memcpy(dest, m_data + start, first_part);
+    memcpy(dest + first_part, m_data, size - first_part);
+
+    return true;
+}
+
+const std::byte* RingBuffer::contiguous_data(size_t offset, size_t size) const {
+    if (offset + size > this->size())
+    {
+        return nullptr;
+    }
+
+    const auto start = static_cast<size_t>((m_read_pos + offset) & m_mask);
+
+    if (start + size > capacity())
+    {
+        return nullptr;
+    }
+
+    return m_data + start;
+}
+
+std::array<RingBufferRegion, 2> RingBuffer::read_regions() const {
+    const auto start = static_cast<size_t>(m_read_pos & m_mask);
+    const auto first_part = std::min(size(), capacity() - start);
+
+    return {
+        RingBufferRegion{ m_data + start, first_part },
+        RingBufferRegion{ m_data, size() - first_part }
+    };
+}
+
+std::array<RingBufferWriteRegion, 2> RingBuffer::write_regions(size_t max_size) {
+    const auto size = std::min(max_size, free_space());
+    const auto start = static_cast<size_t>(m_write_pos & m_mask);
+    const auto first_part = std::min(size, capacity() - start);
+
+    return {
+        RingBufferWriteRegion{ m_data + start, first_part },
+        RingBufferWriteRegion{ m_data, size - first_part }
+    };
+}
+
+void RingBuffer::commit(size_t size) {
+    m_write_pos += std::min(size, free_space());
+}
+
+void RingBuffer::consume(size_t size) {
+    m_read_pos += std::min(size, this->size());
+}
+
+void RingBuffer::clear() {
+    m_read_pos = m_write_pos;
+}
+
+void RingBuffer::attach_storage(std::byte* storage, size_t capacity, uint64_t position) {
+    std::vector<std::byte>().swap(m_storage);
+
+    m_data = storage;
+    m_capacity = capacity;
+    m_mask = capacity - 1;
+    m_read_pos = position;
+    m_write_pos = position;
+}
+
+void RingBuffer::detach_storage() {
+    if (m_data == m_storage.data() && !m_storage.empty())
+    {
+        return;
+    }
+
+    m_storage.resize(m_owned_capacity);
+
+    m_data = m_storage.data();
+    m_capacity = m_storage.size();
+    m_mask = m_capacity - 1;
+    m_read_pos = 0;
+    m_write_pos = 0;
+}
+
+uint64_t RingBuffer::read_position() const {
+    return m_read_pos;
+}
+
+uint64_t RingBuffer::write_position() const {
+    return m_write_pos;
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+
+// A contiguous part of the readable data
+struct RingBufferRegion {
+    const std::byte*    data;
+    size_t              size;
+};
+
+// A contiguous part of the free space
+struct RingBufferWriteRegion {
+    std::byte*          data;
+    size_t              size;
+};
+
+/*
+    Fixed-capacity byte ring buffer
+
+    The capacity is always rounded up to a power of two so that the
+    cursors can be wrapped with a mask. The read and write cursors grow
+    monotonically and are only masked when indexing into the storage,
+    which keeps size() == write - read even when the buffer is full.
+*/
+class RingBuffer {
+public:
+    RingBuffer(size_t min_capacity);
+
+    // Disable the copy constructor and copy assignment operator
+    RingBuffer(const RingBuffer&) = delete;
+    RingBuffer& operator=(const RingBuffer&) = delete;
+
+    size_t capacity() const;
+    size_t size() const;
+    size_t free_space() const;
+    bool empty() const;
+
+    // Append bytes to the write cursor, returns the number of bytes written
+    size_t write(const std::byte* data, size_t size);
+
+    // Copy bytes starting at read cursor + offset without consuming them
+    bool peek(std::byte* dest, size_t size, size_t offset = 0) const;
+
+    /*
+        Returns a pointer into the storage if the requested region does not
+        straddle the end of the buffer, otherwise nullptr
+    */
+    const std::byte* contiguous_data(size_t offset, size_t size) const;
+
+    /*
+        Returns the readable data as at most two contiguous regions,
+        the second one is empty unless the data wraps around
+    */
+    std::array<RingBufferRegion, 2> read_regions() const;
+
+    /*
+        Returns up to max_size bytes of free space as at most two contiguous
+        regions so that data can be received in place, commit() publishes them
+    */
+    std::array<RingBufferWriteRegion, 2> write_regions(size_t max_size);
+    void commit(size_t size);
+
+    // Advance the read cursor, O(1)
+    void consume(size_t size);
+    void clear();
+
+    /*
+        Works on storage owned by someone else, e.g., a shared memory ring
+        whose writer lives in another process. The capacity must be a power
+        of two, both cursors restart at position. The own storage is freed
+        until detach_storage() reallocates it
+    */
+    void attach_storage(std::byte* storage, size_t capacity, uint64_t position);
+    void detach_storage();
+
+    // The cursors, counting every byte ever written or consumed
+    uint64_t read_position() const;
+    uint64_t write_position() const;
+
+private:
+    std::vector<std::byte>  m_storage;
+    size_t                  m_owned_capacity;
+
+    // Either m_storage or the attached storage
+    std::byte*              m_data;
+    size_t                  m_capacity;
+    size_t                  m_mask;
+    uint64_t                m_read_pos;
+    uint64_t                m_write_pos;
+};
\ No newline at end of file
@@ -0,0 +1,486 @@
+#include <cstring>
+#include <climits>
+#include <iostream>
+#include <algorithm>
+#include "shm_ring.hpp"
+
+#ifdef __linux__
+    #include <cerrno>
+    #include <fcntl.h>
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <sys/syscall.h>
+    #include <linux/futex.h>
+#endif
+
+namespace {
+    constexpr uint32_t SHM_RING_MAGIC   = 0x52534842;   // "BHSR"
+    constexpr uint32_t SHM_RING_VERSION = 1;
+
+    /*
+        Start of the shared segment. The cursors of either side live on
+        their own cache line, so the writer advancing write_pos does not
+        invalidate the line the reader publishes read_pos on
+    */
+    struct ShmRingHeader {
+        std::atomic<uint32_t>   magic;              // Set last by the writer, the segment is ready
+        uint32_t                version;
+        uint64_t                capacity;
+
+        alignas(64) std::atomic<uint64_t> write_pos;
+        std::atomic<uint32_t>   data_futex;         // Bumped when data arrives while the reader sleeps
+        std::atomic<uint32_t>   reader_waiting;
+        std::atomic<uint32_t>   writer_closed;
+
+        alignas(64) std::atomic<uint64_t> read_pos;
+        std::atomic<uint32_t>   space_futex;        // Bumped when space is freed while the writer sleeps
+        std::atomic<uint32_t>   writer_waiting;
+        std::atomic<uint32_t>   reader_attached;    // ReaderState
+    };
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free && std::atomic<uint32_t>::is_always_lock_free,
+        "The cursors are shared between processes and must not hide a lock");
+
+    // Values of ShmRingHeader::reader_attached, a fresh segment starts without a reader
+    enum ReaderState : uint32_t {
+        READER_NONE     = 0,
+        READER_ATTACHED = 1,
+        READER_DETACHED = 2,    // Was attached and closed the ring, until it opens it again
+    };
+
+    // The data area starts on its own page
+    constexpr size_t SHM_RING_DATA_OFFSET = 4096;
+
+    static_assert(sizeof(ShmRingHeader) <= SHM_RING_DATA_OFFSET);
+
+    size_t round_up_to_power_of_two(size_t value) {
+        size_t result = 1;
+
+        while (result < value)
+        {
+            result <<= 1;
+        }
+
+        return result;
+    }
+
+    ShmRingHeader* ring_header(void* mapping) {
+        return static_cast<ShmRingHeader*>(mapping);
+    }
+
+    std::byte* ring_data(void* mapping) {
+        return static_cast<std::byte*>(mapping) + SHM_RING_DATA_OFFSET;
+    }
+
+#ifdef __linux__
+    // Not FUTEX_PRIVATE_FLAG, the word is shared with the other process
+    void futex_wait(std::atomic<uint32_t>& word, uint32_t expected, SocketDeadline deadline) {
+        timespec timeout = {};
+        timespec* timeout_ptr = nullptr;
+
+        if (deadline != SocketDeadline::max())
+        {
+            auto remaining = std::max(deadline - SocketClock::now(), SocketClock::duration::zero());
+            auto seconds = std::chrono::duration_cast<std::chrono::seconds>(remaining);
+
+            timeout.tv_sec = static_cast<time_t>(seconds.count());
+            timeout.tv_nsec = static_cast<long>(std::chrono::duration_cast<std::chrono::nanoseconds>(remaining - seconds).count());
+            timeout_ptr = &timeout;
+        }
+
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, expected, timeout_ptr, nullptr, 0);
+    }
+
+    void futex_wake(std::atomic<uint32_t>& word) {
+        syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+    }
+#endif
+}
+
+ShmRingWriter::ShmRingWriter()
+    : m_mapping(nullptr)
+    , m_mapping_size(0)
+{}
+
+ShmRingWriter::~ShmRingWriter() {
+    close();
+}
+
+bool ShmRingWriter::create(std::string_view name, size_t min_capacity) {
+#ifdef __linux__
+    close();
+
+    m_name = std::string(name);
+
+    const auto capacity = round_up_to_power_of_two(min_capacity);
+    const auto mapping_size = SHM_RING_DATA_OFFSET + capacity;
+
+    // A segment left behind by a crashed server is replaced, its reader is gone anyway
+    shm_unlink(m_name.c_str());
+
+    auto fd = shm_open(m_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+
+    if (fd == -1)
+    {
+        std::cerr << "Failed to create shared memory " << m_name << "\n";
+
+        return false;
+    }
+
+    // A fresh segment is zero-filled, all cursors and flags start at 0
+    auto mapping = ftruncate(fd, static_cast<off_t>(mapping_size)) == 0
+        ? mmap(nullptr, mapping_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+        : MAP_FAILED;
+
+    ::close(fd);
+
+    if (mapping == MAP_FAILED)
+    {
+        std::cerr << "Failed to map shared memory " << m_name << "\n";
+        shm_unlink(m_name.c_str());
+
+        return false;
+    }
+
+    m_mapping = mapping;
+    m_mapping_size = mapping_size;
+
+    auto header = ring_header(m_mapping);
+    header->version = SHM_RING_VERSION;
+    header->capacity = capacity;
+    header->magic.store(SHM_RING_MAGIC, std::memory_order_release);
+
+    return true;
+#else
+    (void)name;
+    (void)min_capacity;
+
+    std::cerr << "The shared memory transport requires Linux" << "\n";
+
+    return false;
+#endif
+}
+
+void ShmRingWriter::close() {
+#ifdef __linux__
+    if (m_mapping == nullptr)
+    {
+        return;
+    }
+
+    auto header = ring_header(m_mapping);
+    header->writer_closed.store(1, std::memory_order_release);
+    header->data_futex.fetch_add(1, std::memory_order_seq_cst);
+    futex_wake(header->data_futex);
+
+    // A reader that is attached keeps its mapping, only new readers are turned away
+    munmap(m_mapping, m_mapping_size);
+    shm_unlink(m_name.c_str());
+
+    m_mapping = nullptr;
+    m_mapping_size = 0;
+#endif
+}
+
+bool ShmRingWriter::write(const std::byte* data, size_t size, SocketDeadline deadline) {
+#ifdef __linux__
+    if (m_mapping == nullptr || size > capacity())
+    {
+        return false;
+    }
+
+    auto header = ring_header(m_mapping);
+    const auto write_pos = header->write_pos.load(std::memory_order_relaxed);
+
+    while (capacity() - (write_pos - header->read_pos.load(std::memory_order_acquire)) < size)
+    {
+        if (SocketClock::now() >= deadline)
+        {
+            return false;
+        }
+
+        /*
+            A reader that went away would never make room, see
+            ShmRingReader::close(). Before the first reader attaches the
+            writer may still wait for it
+        */
+        if (header->reader_attached.load(std::memory_order_seq_cst) == READER_DETACHED)
+        {
+            return false;
+        }
+
+        // Announce the sleep before checking again, see wait_for_data()
+        const auto sequence = header->space_futex.load(std::memory_order_seq_cst);
+        header->writer_waiting.store(1, std::memory_order_seq_cst);
+
+        if (capacity() - (write_pos - header->read_pos.load(std::memory_order_seq_cst)) < size &&
+            header->reader_attached.load(std::memory_order_seq_cst) != READER_DETACHED)
+        {
+            futex_wait(header->space_futex, sequence, deadline);
+            m_stats.wait_calls++;
+        }
+
+        header->writer_waiting.store(0, std::memory_order_relaxed);
+    }
+
+    const auto start = static_cast<size_t>(write_pos & (capacity() - 1));
+    const auto first_part = std::min(size, capacity() - start);
+
+    memcpy(ring_data(m_mapping) + start, data, first_part);
+    memcpy(ring_data(m_mapping), data + first_part, size - first_part);
+
+    // Publishes the bytes, then looks whether the reader went to sleep before they arrived
+    header->write_pos.store(write_pos + size, std::memory_order_seq_cst);
+
+    if (header->reader_waiting.load(std::memory_order_seq_cst) != 0)
+    {
+        header->data_futex.fetch_add(1, std::memory_order_seq_cst);
+        futex_wake(header->data_futex);
+        m_stats.wake_calls++;
+    }
+
+    return true;
+#else
+    (void)data;
+    (void)size;
+    (void)deadline;
+
+    return false;
+#endif
+}
+
+bool ShmRingWriter::write(const std::vector<std::byte>& data, SocketDeadline deadline) {
+    return write(data.data(), data.size(), deadline);
+}
+
+bool ShmRingWriter::is_reader_attached() const {
+    return m_mapping != nullptr && ring_header(m_mapping)->reader_attached.load(std::memory_order_acquire) == READER_ATTACHED;
+}
+
+size_t ShmRingWriter::capacity() const {
+    return m_mapping != nullptr ? static_cast<size_t>(ring_header(m_mapping)->capacity) : 0;
+}
+
+const ShmRingStats& ShmRingWriter::stats() const {
+    return m_stats;
+}
+
+ShmRingReader::ShmRingReader()
+    : m_mapping(nullptr)
+    , m_mapping_size(0)
+    , m_released(0)
+    , m_interrupted(false)
+{}
+
+ShmRingReader::~ShmRingReader() {
+    close();
+}
+
+bool ShmRingReader::open(std::string_view name) {
+#ifdef __linux__
+    close();
+
+    const std::string segment_name(name);
+    auto fd = shm_open(segment_name.c_str(), O_RDWR, 0);
+
+    if (fd == -1)
+    {
+        std::cerr << "Failed to open shared memory " << segment_name << "\n";
+
+        return false;
+    }
+
+    struct stat segment_stat = {};
+    void* mapping = MAP_FAILED;
+
+    if (fstat(fd, &segment_stat) == 0 && static_cast<size_t>(segment_stat.st_size) > SHM_RING_DATA_OFFSET)
+    {
+        mapping = mmap(nullptr, static_cast<size_t>(segment_stat.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+
+    ::close(fd);
+
+    if (mapping == MAP_FAILED)
+    {
+        std::cerr << "Failed to map shared memory " << segment_name << "\n";
+
+        return false;
+    }
+
+    auto header = ring_header(mapping);
+    const auto mapping_size = static_cast<size_t>(segment_stat.st_size);
+
+    if (header->magic.load(std::memory_order_acquire) != SHM_RING_MAGIC ||
+        header->version != SHM_RING_VERSION ||
+        header->capacity == 0 ||
+        (header->capacity & (header->capacity - 1)) != 0 ||
+        SHM_RING_DATA_OFFSET + header->capacity != mapping_size)
+    {
+        std::cerr << "Shared memory " << segment_name << " is not a packet ring" << "\n";
+        munmap(mapping, mapping_size);
+
+        return false;
+    }
+
+    header->reader_attached.store(READER_ATTACHED, std::memory_order_release);
+
+    // Published under the lock, interrupt() may look at it from another thread
+    {
+        std::lock_guard<std::mutex> lock(m_close_mutex);
+
+        m_mapping = mapping;
+        m_mapping_size = mapping_size;
+        m_released = header->read_pos.load(std::memory_order_acquire);
+        m_interrupted = false;
+    }
+
+    return true;
+#else
+    (void)name;
+
+    std::cerr << "The shared memory transport requires Linux" << "\n";
+
+    return false;
+#endif
+}
+
+void ShmRingReader::close() {
+#ifdef __linux__
+    std::lock_guard<std::mutex> lock(m_close_mutex);
+
+    if (m_mapping == nullptr)
+    {
+        return;
+    }
+
+    auto header = ring_header(m_mapping);
+    header->reader_attached.store(READER_DETACHED, std::memory_order_release);
+
+    // Nobody frees space anymore, a waiting writer should find out at once
+    header->space_futex.fetch_add(1, std::memory_order_seq_cst);
+    futex_wake(header->space_futex);
+
+    munmap(m_mapping, m_mapping_size);
+
+    m_mapping = nullptr;
+    m_mapping_size = 0;
+#endif
+}
+
+bool ShmRingReader::is_open() const {
+    return m_mapping != nullptr;
+}
+
+std::byte* ShmRingReader::data() const {
+    return m_mapping != nullptr ? ring_data(m_mapping) : nullptr;
+}
+
+size_t ShmRingReader::capacity() const {
+    return m_mapping != nullptr ? static_cast<size_t>(ring_header(m_mapping)->capacity) : 0;
+}
+
+uint64_t ShmRingReader::read_position() const {
+    return m_released;
+}
+
+ssize_t ShmRingReader::wait_for_data(uint64_t position, SocketDeadline deadline) {
+#ifdef __linux__
+    if (m_mapping == nullptr)
+    {
+        return SOCKET_ERROR;
+    }
+
+    auto header = ring_header(m_mapping);
+
+    while (true)
+    {
+        const auto write_pos = header->write_pos.load(std::memory_order_acquire);
+
+        if (write_pos != position)
+        {
+            return static_cast<ssize_t>(write_pos - position);
+        }
+
+        if (header->writer_closed.load(std::memory_order_acquire) != 0)
+        {
+            return 0;
+        }
+
+        if (SocketClock::now() >= deadline)
+        {
+            return SOCKET_TIMEOUT;
+        }
+
+        /*
+            The futex word is read before the last checks. If the writer
+            publishes in between, it sees reader_waiting and bumps the
+            word, so the wait returns at once instead of missing the data
+        */
+        const auto sequence = header->data_futex.load(std::memory_order_seq_cst);
+        header->reader_waiting.store(1, std::memory_order_seq_cst);
+
+        if (header->write_pos.load(std::memory_order_seq_cst) == position &&
+            header->writer_closed.load(std::memory_order_seq_cst) == 0 &&
+            !m_interrupted)
+        {
+            futex_wait(header->data_futex, sequence, deadline);
+            m_stats.wait_calls++;
+        }
+
+        header->reader_waiting.store(0, std::memory_order_relaxed);
+
+        if (m_interrupted)
+        {
+            return 0;
+        }
+    }
+#else
+    (void)position;
+    (void)deadline;
+
+    return SOCKET_ERROR;
+#endif
+}
+
+void ShmRingReader::release(uint64_t position) {
+#ifdef __linux__
+    if (m_mapping == nullptr || position == m_released)
+    {
+        return;
+    }
+
+    m_released = position;
+
+    auto header = ring_header(m_mapping);
+    header->read_pos.store(position, std::memory_order_seq_cst);
+
+    if (header->writer_waiting.load(std::memory_order_seq_cst) != 0)
+    {
+        header->space_futex.fetch_add(1, std::memory_order_seq_cst);
+        futex_wake(header->space_futex);
+        m_stats.wake_calls++;
+    }
+#else
+    (void)position;
+#endif
+}
+
+void ShmRingReader::interrupt() {
+    std::lock_guard<std::mutex> lock(m_close_mutex);
+
+    m_interrupted = true;
+
+#ifdef __linux__
+    if (m_mapping != nullptr)
+    {
+        auto header = ring_header(m_mapping);
+        header->data_futex.fetch_add(1, std::memory_order_seq_cst);
+        futex_wake(header->data_futex);
+    }
+#endif
+}
+
+const ShmRingStats& ShmRingReader::stats() const {
+    return m_stats;
+}
\ No newline at end of file
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "../socket/socket.hpp"
+
+/*
+    Single-producer/single-consumer byte ring in POSIX shared memory
+
+    The server creates the segment with ShmRingWriter and appends complete
+    packets to it, the client maps it with ShmRingReader and parses the
+    packets in place (see PacketTransport::SharedMemory). Both sides
+    publish their progress through cursors in the segment and only enter
+    the kernel to sleep on a futex when the ring is empty (reader) or full
+    (writer), so a busy stream costs no system calls at all. Linux only,
+    create() and open() fail elsewhere
+*/
+
+struct ShmRingStats {
+    uint64_t wait_calls     = 0;    // futex waits, the side had nothing to do
+    uint64_t wake_calls     = 0;    // futex wakes, only issued when the other side is asleep
+};
+
+class ShmRingWriter {
+public:
+    ShmRingWriter();
+    ~ShmRingWriter();
+
+    // Disable the copy constructor and copy assignment operator
+    ShmRingWriter(const ShmRingWriter&) = delete;
+    ShmRingWriter& operator=(const ShmRingWriter&) = delete;
+
+    /*
+        Creates the segment, replacing a stale one of the same name. The name
+        starts with a slash, the capacity is rounded up to a power of two and
+        must hold the largest packet
+    */
+    bool create(std::string_view name, size_t min_capacity);
+
+    // Marks the stream as ended for the reader and removes the name
+    void close();
+
+    /*
+        Appends all bytes or none, waiting for the reader to make room until
+        the deadline. A deadline that has already passed never waits, and
+        a full ring fails at once after the reader has closed it
+    */
+    bool write(const std::byte* data, size_t size, SocketDeadline deadline);
+    bool write(const std::vector<std::byte>& data, SocketDeadline deadline);
+
+    bool is_reader_attached() const;
+    size_t capacity() const;
+    const ShmRingStats& stats() const;
+
+private:
+    std::string             m_name;
+    void*                   m_mapping;
+    size_t                  m_mapping_size;
+
+    ShmRingStats            m_stats;
+};
+
+class ShmRingReader {
+public:
+    ShmRingReader();
+    ~ShmRingReader();
+
+    // Disable the copy constructor and copy assignment operator
+    ShmRingReader(const ShmRingReader&) = delete;
+    ShmRingReader& operator=(const ShmRingReader&) = delete;
+
+    bool open(std::string_view name);
+    void close();
+    bool is_open() const;
+
+    // The data area, wrapping at capacity()
+    std::byte* data() const;
+    size_t capacity() const;
+
+    // Position of the oldest byte the writer has not been allowed to overwrite yet
+    uint64_t read_position() const;
+
+    /*
+        Returns the number of bytes written beyond position, waiting for
+        them until the deadline (SOCKET_TIMEOUT). Returns 0 once the writer
+        closed the ring and everything was read, or after interrupt()
+    */
+    ssize_t wait_for_data(uint64_t position, SocketDeadline deadline);
+
+    // Lets the writer reuse everything before position
+    void release(uint64_t position);
+
+    // Wakes up a wait_for_data() on another thread, which returns 0
+    void interrupt();
+
+    const ShmRingStats& stats() const;
+
+private:
+    void*                   m_mapping;
+    size_t                  m_mapping_size;
+    uint64_t                m_released;
+    std::atomic<bool>       m_interrupted;
+
+    ShmRingStats            m_stats;
+
+    // Serializes interrupt() against open() and close(), which may run during a reconnect
+    std::mutex              m_close_mutex;
+};
\ No newline at end of file
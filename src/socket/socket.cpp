@@ -1,10 +1,109 @@
 #include <array>
 #include <limits>
+#include <iostream>
+#include <algorithm>
 #include "socket.hpp"
+#include "uring_receiver.hpp"
+
+#ifndef _WIN32
+    #include <cerrno>
+    #include <fcntl.h>
+    #include <poll.h>
+    #include <sys/uio.h>
+    #include <sys/un.h>
+    #include <sys/stat.h>
+    #include <netinet/in.h>
+    #include <netinet/tcp.h>
+#endif
+
+#ifdef __linux__
+    #include <ctime>
+    #include <cstring>
+    #include <sys/epoll.h>
+    #include <linux/errqueue.h>
+    #include <linux/net_tstamp.h>
+#endif
 
 namespace {
     constexpr size_t TEMP_BUFFER_SIZE = 4096;
 
+#ifndef _WIN32
+    std::string unix_socket_path(std::string_view address) {
+        return std::string(address.substr(UNIX_SOCKET_SCHEME.size()));
+    }
+
+    bool is_abstract_unix_socket(std::string_view address) {
+        return is_unix_socket_address(address) && address.substr(UNIX_SOCKET_SCHEME.size(), 1) == "@";
+    }
+#endif
+
+    // Either an IPv4 or a Unix domain socket address
+    struct SocketAddress {
+        sockaddr_storage    storage     = {};
+        socklen_t           size        = 0;
+        int                 family      = AF_INET;
+    };
+
+    /*
+        An empty IPv4 address means any interface, for binding.
+        Unix domain paths that do not fit into sun_path are rejected
+    */
+    bool make_socket_address(std::string_view address, uint16_t port, SocketAddress& socket_address) {
+        if (is_unix_socket_address(address))
+        {
+#ifdef _WIN32
+            (void)port;
+
+            std::cerr << "Unix domain sockets are not supported on Windows" << "\n";
+
+            return false;
+#else
+            const auto path = unix_socket_path(address);
+            auto& unix_address = reinterpret_cast<sockaddr_un&>(socket_address.storage);
+
+            if (path.empty() || path.size() >= sizeof(unix_address.sun_path))
+            {
+                return false;
+            }
+
+            unix_address.sun_family = AF_UNIX;
+            path.copy(unix_address.sun_path, path.size());
+
+            socket_address.family = AF_UNIX;
+            socket_address.size = static_cast<socklen_t>(offsetof(sockaddr_un, sun_path) + path.size() + 1);
+
+    #ifdef __linux__
+            // Abstract namespace, the name is not null-terminated
+            if (path[0] == '@')
+            {
+                unix_address.sun_path[0] = '\0';
+                socket_address.size--;
+            }
+    #endif
+
+            return true;
+#endif
+        }
+
+        auto& inet_address = reinterpret_cast<sockaddr_in&>(socket_address.storage);
+        inet_address.sin_family = AF_INET;
+        inet_address.sin_port = htons(port);
+
+        socket_address.family = AF_INET;
+        socket_address.size = sizeof(sockaddr_in);
+
+        if (address.empty())
+        {
+            inet_address.sin_addr.s_addr = INADDR_ANY;
+
+            return true;
+        }
+
+        const std::string address_string(address);
+
+        return inet_pton(AF_INET, address_string.c_str(), &inet_address.sin_addr) > 0;
+    }
+
     ssize_t socket_send(SOCKET sock, const std::vector<std::byte>& bytes) {
         // Check for overflow
 #ifdef _WIN32
@@ -24,7 +123,12 @@ namespace {
             */
             reinterpret_cast<const char*>(bytes.data()),
             safe_size,
+#ifdef __linux__
+            // A peer that went away must surface as an error, not SIGPIPE
+            MSG_NOSIGNAL
+#else
             0
+#endif
         );
     }
 
@@ -51,6 +155,41 @@ namespace {
         );
     }
 
+    ssize_t socket_recv_scatter(SOCKET sock, std::byte* first, size_t first_size, std::byte* second, size_t second_size) {
+#ifdef _WIN32
+        // Check for overflow
+        if (first_size > static_cast<size_t>(std::numeric_limits<ULONG>::max()) ||
+            second_size > static_cast<size_t>(std::numeric_limits<ULONG>::max()))
+        {
+            return SOCKET_ERROR;
+        }
+
+        WSABUF buffers[2];
+        buffers[0].buf = reinterpret_cast<char*>(first);
+        buffers[0].len = static_cast<ULONG>(first_size);
+        buffers[1].buf = reinterpret_cast<char*>(second);
+        buffers[1].len = static_cast<ULONG>(second_size);
+
+        DWORD received = 0;
+        DWORD flags = 0;
+
+        if (WSARecv(sock, buffers, second_size > 0 ? 2 : 1, &received, &flags, NULL, NULL) == SOCKET_ERROR)
+        {
+            return SOCKET_ERROR;
+        }
+
+        return static_cast<ssize_t>(received);
+#else
+        iovec buffers[2];
+        buffers[0].iov_base = first;
+        buffers[0].iov_len = first_size;
+        buffers[1].iov_base = second;
+        buffers[1].iov_len = second_size;
+
+        return readv(sock, buffers, second_size > 0 ? 2 : 1);
+#endif
+    }
+
     std::optional<std::vector<std::byte>> socket_recv_exact(SOCKET sock, size_t size) {
         auto buffer = std::vector<std::byte>();
         buffer.reserve(size);
@@ -82,135 +221,785 @@ namespace {
         return buffer;
     }
 
-    void close_socket(SOCKET sock) {
-        if (sock == INVALID_SOCKET)
+#ifdef __linux__
+    // Kernel timestamps are taken on CLOCK_REALTIME
+    SocketClock::time_point realtime_to_socket_clock(const timespec& timestamp) {
+        timespec realtime_now;
+        clock_gettime(CLOCK_REALTIME, &realtime_now);
+
+        const auto age = std::chrono::seconds(realtime_now.tv_sec - timestamp.tv_sec) +
+            std::chrono::nanoseconds(realtime_now.tv_nsec - timestamp.tv_nsec);
+
+        return SocketClock::now() - std::chrono::duration_cast<SocketClock::duration>(age);
+    }
+#endif
+
+    bool socket_would_block() {
+#ifdef _WIN32
+        return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+        return errno == EAGAIN || errno == EWOULDBLOCK;
+#endif
+    }
+
+    // ICMP errors (e.g. port unreachable) reported on a connected datagram socket
+    bool socket_datagram_error_is_transient() {
+#ifdef _WIN32
+        auto error = WSAGetLastError();
+
+        return error == WSAECONNRESET || error == WSAEMSGSIZE;
+#else
+        return errno == ECONNREFUSED || errno == EINTR;
+#endif
+    }
+
+    bool socket_connect_in_progress() {
+#ifdef _WIN32
+        return WSAGetLastError() == WSAEWOULDBLOCK;
+#else
+        return errno == EINPROGRESS;
+#endif
+    }
+
+    bool socket_connect_succeeded(SOCKET sock) {
+        int error = 0;
+
+#ifdef _WIN32
+        int error_size = sizeof(error);
+#else
+        socklen_t error_size = sizeof(error);
+#endif
+
+        auto result = getsockopt(
+            sock,
+            SOL_SOCKET,
+            SO_ERROR,
+            reinterpret_cast<char*>(&error),
+            &error_size
+        );
+
+        return result == 0 && error == 0;
+    }
+
+    bool set_socket_non_blocking(SOCKET sock, bool enabled) {
+#ifdef _WIN32
+        u_long mode = enabled ? 1 : 0;
+
+        return ioctlsocket(sock, FIONBIO, &mode) == 0;
+#else
+        int flags = fcntl(sock, F_GETFL, 0);
+
+        if (flags == -1)
+        {
+            return false;
+        }
+
+        flags = enabled ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+
+        return fcntl(sock, F_SETFL, flags) == 0;
+#endif
+    }
+
+    // Milliseconds left until the deadline, -1 means wait forever
+    int timeout_ms_until(SocketDeadline deadline) {
+        if (deadline == SocketDeadline::max())
+        {
+            return -1;
+        }
+
+        auto now = SocketClock::now();
+
+        if (deadline <= now)
+        {
+            return 0;
+        }
+
+        // Round up so that the wait never ends before the deadline
+        auto remaining = std::chrono::ceil<std::chrono::milliseconds>(deadline - now).count();
+
+        return static_cast<int>(std::min<decltype(remaining)>(remaining, std::numeric_limits<int>::max()));
+    }
+
+    SocketWaitResult wait_socket(SOCKET sock, short events, SocketDeadline deadline) {
+        pollfd poll_fd = {};
+        poll_fd.fd = sock;
+        poll_fd.events = events;
+
+        while (true)
+        {
+#ifdef _WIN32
+            auto result = WSAPoll(&poll_fd, 1, timeout_ms_until(deadline));
+#else
+            auto result = poll(&poll_fd, 1, timeout_ms_until(deadline));
+#endif
+
+            if (result > 0)
+            {
+                return SocketWaitResult::Ready;
+            }
+            else if (result == 0)
+            {
+                return SocketWaitResult::Timeout;
+            }
+#ifndef _WIN32
+            else if (errno == EINTR)
+            {
+                continue;
+            }
+#endif
+
+            return SocketWaitResult::Error;
+        }
+    }
+
+    void close_socket(SOCKET sock) {
+        if (sock == INVALID_SOCKET)
+        {
+            return;
+        }
+
+#ifdef _WIN32
+        closesocket(sock);
+#else
+        close(sock);
+#endif
+    }
+}
+
+#ifdef _WIN32
+void WinsockManager::initialize() {
+    static WinsockManager instance; // Initialized once (Singleton pattern)
+    (void)instance; // Supress warnings
+}
+
+WinsockManager::WinsockManager() {
+    WSADATA wsa_data;
+
+    if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0)
+    {
+        throw std::runtime_error("WSAStartup failed");
+    }
+}
+
+WinsockManager::~WinsockManager() {
+    WSACleanup();
+}
+#endif
+
+ClientSocket::ClientSocket(std::string_view server_addr, uint16_t server_port)
+    : m_server_addr(server_addr)
+    , m_server_port(server_port)
+    , m_server_sock(INVALID_SOCKET)
+    , m_server_connected(false)
+    , m_connect_pending(false)
+    , m_non_blocking(false)
+    , m_options()
+    , m_stats()
+    , m_last_receive_timestamp()
+#ifdef __linux__
+    , m_epoll_fd(-1)
+#endif
+{}
+
+ClientSocket::~ClientSocket() {
+    disconnect();
+}
+
+bool ClientSocket::connect_to_server() {
+    return connect_to_server(std::chrono::milliseconds::zero());
+}
+
+bool ClientSocket::connect_to_server(std::chrono::milliseconds timeout) {
+    // Without a timeout the connect blocks
+    if (timeout <= std::chrono::milliseconds::zero())
+    {
+        return open_connection(false) == SocketConnectResult::Connected;
+    }
+
+    auto result = open_connection(true);
+
+    if (result == SocketConnectResult::InProgress)
+    {
+        result = finish_connect(SocketClock::now() + timeout);
+    }
+
+    // Timed out
+    if (result == SocketConnectResult::InProgress)
+    {
+        disconnect();
+    }
+
+    return result == SocketConnectResult::Connected;
+}
+
+SocketConnectResult ClientSocket::begin_connect() {
+    return open_connection(true);
+}
+
+SocketConnectResult ClientSocket::finish_connect(SocketDeadline deadline) {
+    if (!m_connect_pending)
+    {
+        return m_server_connected ? SocketConnectResult::Connected : SocketConnectResult::Failed;
+    }
+
+    auto wait_result = wait_socket(m_server_sock, POLLOUT, deadline);
+
+    if (wait_result == SocketWaitResult::Timeout)
+    {
+        return SocketConnectResult::InProgress;
+    }
+
+    m_connect_pending = false;
+
+    if (wait_result != SocketWaitResult::Ready || !socket_connect_succeeded(m_server_sock) || !complete_connection())
+    {
+        disconnect();
+
+        return SocketConnectResult::Failed;
+    }
+
+    return SocketConnectResult::Connected;
+}
+
+bool ClientSocket::is_connect_pending() const {
+    return m_connect_pending;
+}
+
+SocketConnectResult ClientSocket::open_connection(bool non_blocking) {
+#ifdef _WIN32
+    WinsockManager::initialize();
+#endif
+
+    SocketAddress server_addr;
+
+    if (!make_socket_address(m_server_addr, m_server_port, server_addr))
+    {
+        return SocketConnectResult::Failed;
+    }
+
+    // Create socket
+    auto sock = socket(server_addr.family, SOCK_STREAM, server_addr.family == AF_INET ? IPPROTO_TCP : 0);
+
+    if (sock == INVALID_SOCKET)
+    {
+        return SocketConnectResult::Failed;
+    }
+
+    // Published under the lock, shutdown_connection() may look at it from another thread
+    {
+        std::lock_guard<std::mutex> lock(m_close_mutex);
+        m_server_sock = sock;
+    }
+
+    /*
+        A non-blocking connect is started here and completed by
+        finish_connect(), the socket is switched to the requested mode afterwards
+    */
+    if (non_blocking && !set_socket_non_blocking(m_server_sock, true))
+    {
+        disconnect();
+
+        return SocketConnectResult::Failed;
+    }
+
+    // Try to connect to server
+    auto conn_result = connect(
+        m_server_sock,
+        reinterpret_cast<sockaddr*>(&server_addr.storage),
+        server_addr.size
+    );
+
+    if (conn_result == SOCKET_ERROR)
+    {
+        if (!non_blocking || !socket_connect_in_progress())
+        {
+            disconnect();
+
+            return SocketConnectResult::Failed;
+        }
+
+        m_connect_pending = true;
+
+        return SocketConnectResult::InProgress;
+    }
+
+    if (!complete_connection())
+    {
+        disconnect();
+
+        return SocketConnectResult::Failed;
+    }
+
+    return SocketConnectResult::Connected;
+}
+
+bool ClientSocket::complete_connection() {
+    if (!set_socket_non_blocking(m_server_sock, m_non_blocking) || !create_poller() || !apply_options())
+    {
+        return false;
+    }
+
+    m_server_connected = true;
+
+    start_receive_backend();
+
+    return true;
+}
+
+void ClientSocket::disconnect() {
+    std::lock_guard<std::mutex> lock(m_close_mutex);
+
+    // The ring has to be gone before the socket number can be reused
+    m_uring_receiver.reset();
+
+#ifdef __linux__
+    if (m_epoll_fd != -1)
+    {
+        close(m_epoll_fd);
+        m_epoll_fd = -1;
+    }
+#endif
+
+    if (m_server_sock != INVALID_SOCKET)
+    {
+        close_socket(m_server_sock);
+        m_server_sock = INVALID_SOCKET;
+        m_server_connected = false;
+    }
+
+    m_connect_pending = false;
+}
+
+bool ClientSocket::set_non_blocking(bool enabled) {
+    m_non_blocking = enabled;
+
+    if (m_server_sock == INVALID_SOCKET)
+    {
+        // Applied when the connection is established
+        return true;
+    }
+
+    return set_socket_non_blocking(m_server_sock, enabled);
+}
+
+bool ClientSocket::is_non_blocking() const {
+    return m_non_blocking;
+}
+
+SocketWaitResult ClientSocket::wait_readable(SocketDeadline deadline) {
+    if (!m_server_connected)
+    {
+        return SocketWaitResult::Error;
+    }
+
+#ifdef __linux__
+    epoll_event event = {};
+
+    while (true)
+    {
+        auto result = epoll_wait(m_epoll_fd, &event, 1, timeout_ms_until(deadline));
+
+        if (result > 0)
+        {
+            return SocketWaitResult::Ready;
+        }
+        else if (result == 0)
+        {
+            return SocketWaitResult::Timeout;
+        }
+        else if (errno != EINTR)
+        {
+            return SocketWaitResult::Error;
+        }
+    }
+#else
+    return wait_socket(m_server_sock, POLLIN, deadline);
+#endif
+}
+
+bool ClientSocket::create_poller() {
+#ifdef __linux__
+    m_epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+
+    if (m_epoll_fd == -1)
+    {
+        return false;
+    }
+
+    // Hang-ups and errors are always reported and also wake up the reader
+    epoll_event event = {};
+    event.events = EPOLLIN | EPOLLRDHUP;
+    event.data.fd = m_server_sock;
+
+    return epoll_ctl(m_epoll_fd, EPOLL_CTL_ADD, m_server_sock, &event) == 0;
+#else
+    return true;
+#endif
+}
+
+void ClientSocket::shutdown_connection() {
+    std::lock_guard<std::mutex> lock(m_close_mutex);
+
+    if (m_server_sock != INVALID_SOCKET)
+    {
+#ifdef _WIN32
+        shutdown(m_server_sock, SD_BOTH);
+#else
+        shutdown(m_server_sock, SHUT_RDWR);
+#endif
+    }
+}
+
+ssize_t ClientSocket::send_data(const std::vector<std::byte>& data) {
+    if (!m_server_connected)
+    {
+        return SOCKET_ERROR;
+    }
+
+    return socket_send(m_server_sock, data);
+}
+
+ssize_t ClientSocket::recv_data(std::byte* buffer, size_t size) {
+    if (!m_server_connected)
+    {
+        return SOCKET_ERROR;
+    }
+    
+    return socket_recv(m_server_sock, buffer, size);
+}
+
+std::optional<std::vector<std::byte>> ClientSocket::recv_exact(size_t size) {
+    if (!m_server_connected)
+    {
+        return std::nullopt;
+    }
+
+    return socket_recv_exact(m_server_sock, size);
+}
+
+ssize_t ClientSocket::recv_data(std::byte* buffer, size_t size, SocketDeadline deadline) {
+    return recv_data(buffer, size, nullptr, 0, deadline);
+}
+
+ssize_t ClientSocket::recv_data(
+    std::byte* first, size_t first_size,
+    std::byte* second, size_t second_size,
+    SocketDeadline deadline)
+{
+    if (m_uring_receiver)
+    {
+        if (!m_server_connected)
+        {
+            return SOCKET_ERROR;
+        }
+
+        auto received = m_uring_receiver->receive(first, first_size, second, second_size, deadline);
+
+        if (received > 0)
+        {
+            rearm_quick_ack();
+        }
+
+        return received;
+    }
+
+    if (m_options.spin_budget > std::chrono::microseconds::zero())
+    {
+        auto received = spin_receive(first, first_size, second, second_size, deadline);
+
+        if (received != SOCKET_TIMEOUT)
+        {
+            return received;
+        }
+    }
+
+    while (true)
+    {
+        /*
+            A non-blocking socket is read optimistically first,
+            the wait is only needed when there is nothing to read yet
+        */
+        if (!m_non_blocking)
+        {
+            m_stats.wait_calls++;
+
+            auto wait_result = wait_readable(deadline);
+
+            if (wait_result == SocketWaitResult::Timeout)
+            {
+                return SOCKET_TIMEOUT;
+            }
+            else if (wait_result == SocketWaitResult::Error)
+            {
+                return SOCKET_ERROR;
+            }
+        }
+
+        if (!m_server_connected)
+        {
+            return SOCKET_ERROR;
+        }
+
+        auto received = receive_message(first, first_size, second, second_size, 0);
+
+        if (received == SOCKET_ERROR && socket_would_block())
+        {
+            if (m_non_blocking)
+            {
+                // Nothing to wait for, this saves a system call when merely polling
+                if (deadline <= SocketClock::now())
+                {
+                    return SOCKET_TIMEOUT;
+                }
+
+                m_stats.wait_calls++;
+
+                auto wait_result = wait_readable(deadline);
+
+                if (wait_result == SocketWaitResult::Timeout)
+                {
+                    return SOCKET_TIMEOUT;
+                }
+                else if (wait_result == SocketWaitResult::Error)
+                {
+                    return SOCKET_ERROR;
+                }
+            }
+
+            // Readiness can be spurious, try again
+            continue;
+        }
+
+        if (received > 0)
         {
-            return;
+            rearm_quick_ack();
         }
 
-#ifdef _WIN32
-        closesocket(sock);
-#else
-        close(sock);
-#endif
+        return received;
     }
 }
 
-#ifdef _WIN32
-void WinsockManager::initialize() {
-    static WinsockManager instance; // Initialized once (Singleton pattern)
-    (void)instance; // Supress warnings
-}
-
-WinsockManager::WinsockManager() {
-    WSADATA wsa_data;
+bool ClientSocket::set_options(const SocketOptions& options) {
+    m_options = options;
 
-    if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0)
+    if (m_server_sock == INVALID_SOCKET)
     {
-        throw std::runtime_error("WSAStartup failed");
+        return true;
     }
+
+    return apply_options();
 }
 
-WinsockManager::~WinsockManager() {
-    WSACleanup();
+const SocketStats& ClientSocket::stats() const {
+    return m_stats;
 }
-#endif
 
-ClientSocket::ClientSocket(std::string_view server_addr, uint16_t server_port)
-    : m_server_addr(server_addr)
-    , m_server_port(server_port)
-    , m_server_sock(INVALID_SOCKET)
-    , m_server_connected(false)
-{}
+SocketReceiveBackend ClientSocket::receive_backend() const {
+    return m_uring_receiver ? SocketReceiveBackend::IoUring : SocketReceiveBackend::Recv;
+}
 
-ClientSocket::~ClientSocket() {
-    disconnect();
+std::optional<SocketClock::time_point> ClientSocket::last_receive_timestamp() const {
+    return m_last_receive_timestamp;
 }
 
-bool ClientSocket::connect_to_server() {
-#ifdef _WIN32
-    WinsockManager::initialize();
-#endif
+SOCKET ClientSocket::native_handle() const {
+    return m_server_sock;
+}
 
-    // Create socket
-    m_server_sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+bool ClientSocket::apply_options() {
+    bool succeed = true;
 
-    if (m_server_sock == INVALID_SOCKET)
+    if (m_options.receive_buffer_size > 0)
     {
-        return false;
+        int size = m_options.receive_buffer_size;
+
+        succeed &= setsockopt(
+            m_server_sock,
+            SOL_SOCKET,
+            SO_RCVBUF,
+            reinterpret_cast<const char*>(&size),
+            sizeof(size)
+        ) == 0;
     }
 
-    // Create address
-    sockaddr_in server_addr = {};
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(m_server_port);
-
-    auto pton_result = inet_pton(
-        AF_INET,
-        m_server_addr.data(),
-        &server_addr.sin_addr
-    );
-
-    if (pton_result <= 0)
+    // There is no Nagle on a Unix domain socket
+    if (!is_unix_socket())
     {
-        close_socket(m_server_sock);
-        
-        return false;
+        int no_delay = m_options.no_delay ? 1 : 0;
+
+        succeed &= setsockopt(
+            m_server_sock,
+            IPPROTO_TCP,
+            TCP_NODELAY,
+            reinterpret_cast<const char*>(&no_delay),
+            sizeof(no_delay)
+        ) == 0;
     }
 
-    // Try to connect to server
-    auto conn_result = connect(
-        m_server_sock,
-        reinterpret_cast<sockaddr*>(&server_addr),
-        sizeof(server_addr)
-    );
+    rearm_quick_ack();
 
-    if (conn_result == SOCKET_ERROR)
+#ifdef __linux__
+    if (m_options.busy_poll > 0)
     {
-        close_socket(m_server_sock);
+        int busy_poll = m_options.busy_poll;
 
-        return false;
+        succeed &= setsockopt(m_server_sock, SOL_SOCKET, SO_BUSY_POLL, &busy_poll, sizeof(busy_poll)) == 0;
     }
 
-    m_server_connected = true;
+    if (m_options.receive_timestamps)
+    {
+        int timestamping = SOF_TIMESTAMPING_RX_SOFTWARE | SOF_TIMESTAMPING_SOFTWARE;
 
-    return true;
+        succeed &= setsockopt(m_server_sock, SOL_SOCKET, SO_TIMESTAMPING, &timestamping, sizeof(timestamping)) == 0;
+    }
+#endif
+
+    return succeed;
 }
 
-void ClientSocket::disconnect() {
-    if (m_server_sock != INVALID_SOCKET)
+ssize_t ClientSocket::spin_receive(
+    std::byte* first, size_t first_size,
+    std::byte* second, size_t second_size,
+    SocketDeadline deadline)
+{
+#ifdef __linux__
+    // Never spins past the deadline, so polling with a past deadline does not spin at all
+    const auto spin_end = std::min<SocketDeadline>(SocketClock::now() + m_options.spin_budget, deadline);
+    bool spun = false;
+
+    while (m_server_connected && SocketClock::now() < spin_end)
     {
-        close_socket(m_server_sock);
-        m_server_sock = INVALID_SOCKET;
-        m_server_connected = false;
+        spun = true;
+
+        auto received = receive_message(first, first_size, second, second_size, MSG_DONTWAIT);
+
+        if (received != SOCKET_ERROR || !socket_would_block())
+        {
+            if (received > 0)
+            {
+                m_stats.spin_hits++;
+                rearm_quick_ack();
+            }
+
+            return received;
+        }
     }
+
+    if (spun)
+    {
+        m_stats.spin_misses++;
+    }
+#else
+    (void)first;
+    (void)first_size;
+    (void)second;
+    (void)second_size;
+    (void)deadline;
+#endif
+
+    // Left to the regular wait
+    return SOCKET_TIMEOUT;
 }
 
-ssize_t ClientSocket::send_data(const std::vector<std::byte>& data) {
-    if (!m_server_connected)
+ssize_t ClientSocket::receive_message(
+    std::byte* first, size_t first_size,
+    std::byte* second, size_t second_size,
+    int flags)
+{
+    m_stats.recv_calls++;
+    m_last_receive_timestamp.reset();
+
+#ifdef __linux__
+    if (flags == 0 && !m_options.receive_timestamps)
     {
-        return SOCKET_ERROR;
+        return socket_recv_scatter(m_server_sock, first, first_size, second, second_size);
     }
 
-    return socket_send(m_server_sock, data);
+    iovec buffers[2];
+    buffers[0].iov_base = first;
+    buffers[0].iov_len = first_size;
+    buffers[1].iov_base = second;
+    buffers[1].iov_len = second_size;
+
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(scm_timestamping))];
+
+    msghdr message = {};
+    message.msg_iov = buffers;
+    message.msg_iovlen = second_size > 0 ? 2 : 1;
+
+    if (m_options.receive_timestamps)
+    {
+        message.msg_control = control;
+        message.msg_controllen = sizeof(control);
+    }
+
+    auto received = recvmsg(m_server_sock, &message, flags);
+
+    if (received <= 0 || !m_options.receive_timestamps)
+    {
+        return received;
+    }
+
+    for (auto cmsg = CMSG_FIRSTHDR(&message); cmsg != nullptr; cmsg = CMSG_NXTHDR(&message, cmsg))
+    {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_TIMESTAMPING)
+        {
+            continue;
+        }
+
+        // ts[0] holds the software timestamp, the others are for hardware timestamping
+        scm_timestamping timestamping;
+        memcpy(&timestamping, CMSG_DATA(cmsg), sizeof(timestamping));
+
+        if (timestamping.ts[0].tv_sec != 0 || timestamping.ts[0].tv_nsec != 0)
+        {
+            m_last_receive_timestamp = realtime_to_socket_clock(timestamping.ts[0]);
+            m_stats.timestamped_reads++;
+        }
+    }
+
+    return received;
+#else
+    (void)flags;
+
+    return socket_recv_scatter(m_server_sock, first, first_size, second, second_size);
+#endif
 }
 
-ssize_t ClientSocket::recv_data(std::byte* buffer, size_t size) {
-    if (!m_server_connected)
+void ClientSocket::start_receive_backend() {
+    if (m_options.receive_backend != SocketReceiveBackend::IoUring)
     {
-        return SOCKET_ERROR;
+        return;
+    }
+
+    m_uring_receiver = std::make_unique<UringReceiver>(m_stats);
+
+    // Not fatal, the connection keeps working through recv
+    if (!m_uring_receiver->start(m_server_sock))
+    {
+        std::cerr << "io_uring is not available, falling back to recv" << "\n";
+
+        m_uring_receiver.reset();
     }
-    
-    return socket_recv(m_server_sock, buffer, size);
 }
 
-std::optional<std::vector<std::byte>> ClientSocket::recv_exact(size_t size) {
-    if (!m_server_connected)
+void ClientSocket::rearm_quick_ack() {
+    /*
+        The kernel clears TCP_QUICKACK on its own after a while,
+        so it has to be set again after every read to stay in effect
+    */
+#ifdef TCP_QUICKACK
+    if (m_options.quick_ack && !is_unix_socket())
     {
-        return std::nullopt;
+        int quick_ack = 1;
+        setsockopt(m_server_sock, IPPROTO_TCP, TCP_QUICKACK, &quick_ack, sizeof(quick_ack));
+        m_stats.setsockopt_calls++;
     }
+#endif
+}
 
-    return socket_recv_exact(m_server_sock, size);
+bool ClientSocket::is_unix_socket() const {
+    return is_unix_socket_address(m_server_addr);
 }
 
 ClientConnection::ClientConnection(SOCKET client_sock)
@@ -289,9 +1078,15 @@ std::optional<std::vector<std::byte>> ClientConnection::recv_exact(size_t size)
 }
 
 ServerSocket::ServerSocket(uint16_t server_port)
-    : m_server_port(server_port)
+    : ServerSocket(std::string_view(), server_port)
+{}
+
+ServerSocket::ServerSocket(std::string_view bind_addr, uint16_t server_port)
+    : m_bind_addr(bind_addr)
+    , m_server_port(server_port)
     , m_listen_sock(INVALID_SOCKET)
     , m_initialized(false)
+    , m_bound(false)
 {}
 
 ServerSocket::~ServerSocket() {
@@ -303,33 +1098,55 @@ bool ServerSocket::initialize() {
     WinsockManager::initialize();
 #endif
 
+    // Create address
+    SocketAddress server_hint;
+
+    if (!make_socket_address(m_bind_addr, m_server_port, server_hint))
+    {
+        return false;
+    }
+
     // Create listen socket
-    m_listen_sock = socket(AF_INET, SOCK_STREAM, 0);
+    m_listen_sock = socket(server_hint.family, SOCK_STREAM, 0);
 
     if (m_listen_sock == INVALID_SOCKET)
     {
         return false;
     }
 
-    // Create address
-    sockaddr_in server_hint = {};
-    server_hint.sin_family = AF_INET;
-    server_hint.sin_port = htons(m_server_port);
-    server_hint.sin_addr.s_addr = INADDR_ANY;
+#ifndef _WIN32
+    /*
+        A socket file left behind by a previous run would make bind fail.
+        Anything else at the path is left alone, bind fails on it instead
+    */
+    if (server_hint.family == AF_UNIX && !is_abstract_unix_socket(m_bind_addr))
+    {
+        const auto path = unix_socket_path(m_bind_addr);
+        struct stat path_stat = {};
+
+        if (lstat(path.c_str(), &path_stat) == 0 && S_ISSOCK(path_stat.st_mode))
+        {
+            unlink(path.c_str());
+        }
+    }
+#endif
 
     // Binding address to the listen socket
     auto bind_result = bind(
         m_listen_sock,
-        reinterpret_cast<sockaddr*>(&server_hint),
-        sizeof(server_hint)
+        reinterpret_cast<sockaddr*>(&server_hint.storage),
+        server_hint.size
     );
 
     if (bind_result == SOCKET_ERROR)
     {
-        close_socket(m_listen_sock);
+        // Someone else's socket file may sit at the path, it must survive the failure
+        disconnect();
         return false;
     }
 
+    m_bound = true;
+
     // Start listening
     auto listen_result = listen(
         m_listen_sock,
@@ -338,7 +1155,7 @@ bool ServerSocket::initialize() {
 
     if (listen_result == SOCKET_ERROR)
     {
-        close_socket(m_listen_sock);
+        disconnect();
         return false;
     }
 
@@ -352,7 +1169,17 @@ void ServerSocket::disconnect() {
     {
         close_socket(m_listen_sock);
         m_listen_sock = INVALID_SOCKET;
+
+#ifndef _WIN32
+        // Only a successful bind created the socket file
+        if (m_bound && is_unix_socket_address(m_bind_addr) && !is_abstract_unix_socket(m_bind_addr))
+        {
+            unlink(unix_socket_path(m_bind_addr).c_str());
+        }
+#endif
+
         m_initialized = false;
+        m_bound = false;
     }
 }
 
@@ -362,7 +1189,7 @@ std::optional<ClientConnection> ServerSocket::accept_client() {
         return std::nullopt;
     }
     
-    sockaddr_in client = {};
+    sockaddr_storage client = {};
 
 #ifdef _WIN32
     int client_size = sizeof(client);
@@ -383,4 +1210,207 @@ std::optional<ClientConnection> ServerSocket::accept_client() {
     }
 
     return ClientConnection(client_socket);
+}
+
+DatagramSocket::DatagramSocket()
+    : m_sock(INVALID_SOCKET)
+    , m_stats()
+    , m_shut_down(false)
+{}
+
+DatagramSocket::~DatagramSocket() {
+    close();
+}
+
+bool DatagramSocket::open(uint16_t local_port) {
+#ifdef _WIN32
+    WinsockManager::initialize();
+#endif
+
+    close();
+
+    m_sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+
+    if (m_sock == INVALID_SOCKET)
+    {
+        return false;
+    }
+
+    // Create address
+    sockaddr_in local_hint = {};
+    local_hint.sin_family = AF_INET;
+    local_hint.sin_port = htons(local_port);
+    local_hint.sin_addr.s_addr = INADDR_ANY;
+
+    auto bind_result = bind(
+        m_sock,
+        reinterpret_cast<sockaddr*>(&local_hint),
+        sizeof(local_hint)
+    );
+
+    if (bind_result == SOCKET_ERROR || !set_socket_non_blocking(m_sock, true))
+    {
+        close();
+
+        return false;
+    }
+
+    m_shut_down = false;
+
+    return true;
+}
+
+void DatagramSocket::close() {
+    std::lock_guard<std::mutex> lock(m_close_mutex);
+
+    close_socket(m_sock);
+    m_sock = INVALID_SOCKET;
+}
+
+bool DatagramSocket::is_open() const {
+    return m_sock != INVALID_SOCKET;
+}
+
+uint16_t DatagramSocket::local_port() const {
+    sockaddr_in local = {};
+
+#ifdef _WIN32
+    int local_size = sizeof(local);
+#else
+    socklen_t local_size = sizeof(local);
+#endif
+
+    if (getsockname(m_sock, reinterpret_cast<sockaddr*>(&local), &local_size) == SOCKET_ERROR)
+    {
+        return 0;
+    }
+
+    return ntohs(local.sin_port);
+}
+
+bool DatagramSocket::connect_to(std::string_view peer_addr, uint16_t peer_port) {
+    sockaddr_in peer = {};
+    peer.sin_family = AF_INET;
+    peer.sin_port = htons(peer_port);
+
+    if (inet_pton(AF_INET, std::string(peer_addr).c_str(), &peer.sin_addr) <= 0)
+    {
+        return false;
+    }
+
+    return connect(m_sock, reinterpret_cast<sockaddr*>(&peer), sizeof(peer)) == 0;
+}
+
+void DatagramSocket::shutdown_socket() {
+    std::lock_guard<std::mutex> lock(m_close_mutex);
+
+    m_shut_down = true;
+
+    if (m_sock != INVALID_SOCKET)
+    {
+#ifdef _WIN32
+        shutdown(m_sock, SD_BOTH);
+#else
+        shutdown(m_sock, SHUT_RDWR);
+#endif
+    }
+}
+
+ssize_t DatagramSocket::send_datagram(const std::byte* data, size_t size) {
+#ifdef _WIN32
+    return send(m_sock, reinterpret_cast<const char*>(data), static_cast<int>(size), 0);
+#else
+    return send(m_sock, data, size, 0);
+#endif
+}
+
+ssize_t DatagramSocket::send_datagram_to(const std::byte* data, size_t size, const sockaddr_in& peer) {
+    return sendto(
+        m_sock,
+        reinterpret_cast<const char*>(data),
+#ifdef _WIN32
+        static_cast<int>(size),
+#else
+        size,
+#endif
+        0,
+        reinterpret_cast<const sockaddr*>(&peer),
+        sizeof(peer)
+    );
+}
+
+ssize_t DatagramSocket::recv_datagram(std::byte* buffer, size_t size, SocketDeadline deadline, sockaddr_in* sender) {
+    while (!m_shut_down)
+    {
+        sockaddr_in peer = {};
+
+#ifdef _WIN32
+        int peer_size = sizeof(peer);
+        int safe_size = static_cast<int>(std::min<size_t>(size, std::numeric_limits<int>::max()));
+#else
+        socklen_t peer_size = sizeof(peer);
+        size_t safe_size = size;
+#endif
+
+        m_stats.recv_calls++;
+
+        auto received = recvfrom(
+            m_sock,
+            reinterpret_cast<char*>(buffer),
+            safe_size,
+            0,
+            reinterpret_cast<sockaddr*>(&peer),
+            &peer_size
+        );
+
+        if (received > 0)
+        {
+            if (sender != nullptr)
+            {
+                *sender = peer;
+            }
+
+            return received;
+        }
+
+        if (received == SOCKET_ERROR && !socket_would_block() && !socket_datagram_error_is_transient())
+        {
+            return SOCKET_ERROR;
+        }
+
+        // An empty datagram or a transient error is skipped, nothing to read means waiting
+        if (received == 0 || !socket_would_block())
+        {
+            continue;
+        }
+
+        m_stats.wait_calls++;
+
+        auto wait_result = wait_socket(m_sock, POLLIN, deadline);
+
+        if (wait_result == SocketWaitResult::Timeout)
+        {
+            return SOCKET_TIMEOUT;
+        }
+        else if (wait_result == SocketWaitResult::Error)
+        {
+            return SOCKET_ERROR;
+        }
+    }
+
+    return SOCKET_ERROR;
+}
+
+bool DatagramSocket::set_receive_buffer_size(int size) {
+    return setsockopt(
+        m_sock,
+        SOL_SOCKET,
+        SO_RCVBUF,
+        reinterpret_cast<const char*>(&size),
+        sizeof(size)
+    ) == 0;
+}
+
+const SocketStats& DatagramSocket::stats() const {
+    return m_stats;
 }
\ No newline at end of file
@@ -1,9 +1,14 @@
 #pragma once
 
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <memory>
 #include <string>
 #include <vector>
 #include <cstddef>
 #include <optional>
+#include <string_view>
 
 /*
     To-Do: Support send_data recv_data from multiple threads
@@ -38,6 +43,86 @@
     using SOCKET = int;
 #endif
 
+// Returned instead of a byte count when a deadline expires before any data arrived
+constexpr int SOCKET_TIMEOUT = -2;
+
+/*
+    Addresses starting with this scheme name a Unix domain stream socket
+    instead of an IPv4 address, e.g., "unix:/run/bh.sock". The port is
+    ignored for them. On Linux "unix:@name" uses the abstract namespace,
+    which leaves no file behind. Not supported on Windows
+*/
+constexpr std::string_view UNIX_SOCKET_SCHEME = "unix:";
+
+inline bool is_unix_socket_address(std::string_view address) {
+    return address.substr(0, UNIX_SOCKET_SCHEME.size()) == UNIX_SOCKET_SCHEME;
+}
+
+using SocketClock       = std::chrono::steady_clock;
+using SocketDeadline    = SocketClock::time_point;
+
+enum class SocketWaitResult {
+    Ready,
+    Timeout,
+    Error,
+};
+
+enum class SocketReceiveBackend {
+    Recv,       // epoll (poll on other platforms) and readv
+    IoUring,    // Multishot recv into registered buffers (Linux only), see uring_receiver.hpp
+};
+
+enum class SocketConnectResult {
+    Connected,
+    InProgress,     // The connect has been started, see ClientSocket::finish_connect()
+    Failed,
+};
+
+struct SocketOptions {
+    int     receive_buffer_size = 0;        // SO_RCVBUF in bytes, 0 keeps the system default
+    bool    no_delay            = true;     // TCP_NODELAY, disables Nagle's algorithm so small packets (input, acks) leave at once
+    bool    quick_ack           = false;    // TCP_QUICKACK (Linux only), re-armed after every read
+
+    /*
+        Low-latency receive for machines that can spare a core. busy_poll
+        sets SO_BUSY_POLL (Linux only, microseconds), raising it above the
+        net.core.busy_read sysctl needs CAP_NET_ADMIN. A read first spins on
+        a non-blocking recv for up to spin_budget before it waits for the
+        socket, each spin also polls the device queue when busy_poll is set.
+        Zero disables either. Neither applies to the io_uring backend
+    */
+    int                         busy_poll       = 0;
+    std::chrono::microseconds   spin_budget     = std::chrono::microseconds::zero();
+
+    /*
+        SO_TIMESTAMPING software receive timestamps (Linux only, Recv
+        backend), see ClientSocket::last_receive_timestamp()
+    */
+    bool    receive_timestamps  = false;
+
+    /*
+        Takes effect when the connection is established. IoUring falls
+        back to Recv if io_uring is not available on the system
+    */
+    SocketReceiveBackend receive_backend = SocketReceiveBackend::Recv;
+};
+
+struct SocketStats {
+    uint64_t recv_calls         = 0;    // recv/readv system calls
+    uint64_t wait_calls         = 0;    // epoll_wait/poll system calls
+    uint64_t ring_enter_calls   = 0;    // io_uring_enter system calls
+    uint64_t setsockopt_calls   = 0;    // setsockopt system calls on the receive path (TCP_QUICKACK re-arming)
+
+    // Reads that found data while spinning, and spins that ran out of budget
+    uint64_t spin_hits          = 0;
+    uint64_t spin_misses        = 0;
+
+    // Reads that came with a kernel receive timestamp
+    uint64_t timestamped_reads  = 0;
+};
+
+class UringReceiver;
+
 class ClientSocket {
 public:
     ClientSocket(std::string_view server_addr, uint16_t server_port);
@@ -50,15 +135,115 @@ public:
     bool connect_to_server();
     void disconnect();
 
+    /*
+        Connects in non-blocking mode and gives up after the timeout,
+        zero means the connect blocks like connect_to_server()
+    */
+    bool connect_to_server(std::chrono::milliseconds timeout);
+
+    /*
+        Non-blocking connect in two steps. begin_connect() starts it, then
+        finish_connect() waits for it until the deadline and can be called
+        again for as long as it returns InProgress. A failed connect leaves
+        the socket disconnected
+    */
+    SocketConnectResult begin_connect();
+    SocketConnectResult finish_connect(SocketDeadline deadline);
+    bool is_connect_pending() const;
+
+    /*
+        In non-blocking mode recv_data returns SOCKET_ERROR instead of waiting,
+        the deadline based functions below work in both modes
+    */
+    bool set_non_blocking(bool enabled);
+    bool is_non_blocking() const;
+
+    // Waits until data (or a hang-up) is available, driven by epoll on Linux
+    SocketWaitResult wait_readable(SocketDeadline deadline);
+
+    /*
+        Wakes up a send or recv that is blocked on another thread by shutting
+        down both directions of the connection, the socket itself stays open
+        until disconnect() is called by its owner
+    */
+    void shutdown_connection();
+
     ssize_t send_data(const std::vector<std::byte>& data);
     ssize_t recv_data(std::byte* buffer, size_t size);
     std::optional<std::vector<std::byte>> recv_exact(size_t size);
 
+    /*
+        Returns SOCKET_TIMEOUT if nothing arrived before the deadline, a
+        deadline that has already passed only reads what is available
+    */
+    ssize_t recv_data(std::byte* buffer, size_t size, SocketDeadline deadline);
+
+    /*
+        Scatter read into two buffers with a single system call, the second
+        buffer is only filled once the first one is full
+    */
+    ssize_t recv_data(
+        std::byte* first, size_t first_size,
+        std::byte* second, size_t second_size,
+        SocketDeadline deadline
+    );
+
+    // Applied immediately if connected, otherwise when the connection is established
+    bool set_options(const SocketOptions& options);
+    const SocketStats& stats() const;
+
+    // The backend in use by the current connection, after a possible fallback
+    SocketReceiveBackend receive_backend() const;
+
+    /*
+        When the kernel received the newest bytes of the last read, converted
+        to SocketClock. Only set with SocketOptions::receive_timestamps and
+        if the kernel attached a timestamp to that read
+    */
+    std::optional<SocketClock::time_point> last_receive_timestamp() const;
+
+    // For registering the connection with an external event loop, INVALID_SOCKET while disconnected
+    SOCKET native_handle() const;
+
 private:
+    SocketConnectResult open_connection(bool non_blocking);
+    bool is_unix_socket() const;
+    bool complete_connection();
+    bool create_poller();
+    bool apply_options();
+    void rearm_quick_ack();
+    void start_receive_backend();
+    ssize_t spin_receive(
+        std::byte* first, size_t first_size,
+        std::byte* second, size_t second_size,
+        SocketDeadline deadline
+    );
+    ssize_t receive_message(
+        std::byte* first, size_t first_size,
+        std::byte* second, size_t second_size,
+        int flags
+    );
+
     std::string_view    m_server_addr;
     uint16_t            m_server_port;
     SOCKET              m_server_sock;
     bool                m_server_connected;
+    bool                m_connect_pending;
+    bool                m_non_blocking;
+    SocketOptions       m_options;
+    SocketStats         m_stats;
+
+    std::optional<SocketClock::time_point> m_last_receive_timestamp;
+
+#ifdef __linux__
+    int                 m_epoll_fd;
+#endif
+
+    // Only created while the io_uring backend is in use
+    std::unique_ptr<UringReceiver>  m_uring_receiver;
+
+    // Serializes shutdown_connection() against disconnect() and open_connection()
+    std::mutex          m_close_mutex;
 };
 
 // A class to communicate with the ClientSocket
@@ -89,6 +274,9 @@ private:
 class ServerSocket {
 public:
     ServerSocket(uint16_t server_port);
+
+    // Listens on a Unix domain socket if bind_addr has the "unix:" scheme, an empty address means all interfaces
+    ServerSocket(std::string_view bind_addr, uint16_t server_port);
     ~ServerSocket();
 
     // Disable the copy constructor and copy assignment operator
@@ -101,7 +289,60 @@ public:
     std::optional<ClientConnection> accept_client();
 
 private:
+    std::string     m_bind_addr;
     uint16_t        m_server_port;
     SOCKET          m_listen_sock;
     bool            m_initialized;
+    bool            m_bound;        // bind() succeeded, so a Unix socket file is ours to remove
+};
+
+/*
+    Non-blocking UDP socket, every receive is bounded by a deadline
+    like the deadline based functions of ClientSocket
+*/
+class DatagramSocket {
+public:
+    DatagramSocket();
+    ~DatagramSocket();
+
+    // Disable the copy constructor and copy assignment operator
+    DatagramSocket(const DatagramSocket&) = delete;
+    DatagramSocket& operator=(const DatagramSocket&) = delete;
+
+    // Binds to the local port, 0 picks an ephemeral port
+    bool open(uint16_t local_port = 0);
+    void close();
+    bool is_open() const;
+    uint16_t local_port() const;
+
+    /*
+        Sets the default peer of send_datagram(), datagrams from any other
+        address are filtered out by the kernel from then on
+    */
+    bool connect_to(std::string_view peer_addr, uint16_t peer_port);
+
+    // Wakes up a receive that is waiting on another thread, see ClientSocket::shutdown_connection()
+    void shutdown_socket();
+
+    ssize_t send_datagram(const std::byte* data, size_t size);
+    ssize_t send_datagram_to(const std::byte* data, size_t size, const sockaddr_in& peer);
+
+    /*
+        Receives a single datagram, returns SOCKET_TIMEOUT if nothing arrived
+        before the deadline. Datagrams larger than size are truncated, empty
+        datagrams and ICMP errors of a connected socket are skipped
+    */
+    ssize_t recv_datagram(std::byte* buffer, size_t size, SocketDeadline deadline, sockaddr_in* sender = nullptr);
+
+    bool set_receive_buffer_size(int size);
+    const SocketStats& stats() const;
+
+private:
+    SOCKET              m_sock;
+    SocketStats         m_stats;
+
+    std::atomic<bool>   m_shut_down;
+
+    // Serializes shutdown_socket() against close()
+    std::mutex          m_close_mutex;
 };
\ No newline at end of file
@@ -0,0 +1,467 @@
+#include <cstring>
+#include <algorithm>
+#include "uring_receiver.hpp"
+
+#ifdef __linux__
+    #include <cerrno>
+    #include <sys/mman.h>
+    #include <sys/syscall.h>
+    #include <linux/io_uring.h>
+#endif
+
+namespace {
+    // Multishot recv and buffer rings need Linux 6.0, older headers lack them
+#if defined(__linux__) && defined(IORING_RECV_MULTISHOT) && defined(__NR_io_uring_setup)
+    #define URING_RECEIVER_SUPPORTED 1
+
+    constexpr unsigned  SUBMISSION_ENTRIES      = 4;
+    constexpr unsigned  COMPLETION_ENTRIES      = 256;
+    constexpr uint16_t  BUFFER_GROUP            = 0;
+    constexpr uint64_t  RECV_USER_DATA          = 1;
+
+    int io_uring_setup(unsigned entries, io_uring_params* params) {
+        return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+    }
+
+    int io_uring_enter(int ring_fd, unsigned to_submit, unsigned min_complete, unsigned flags, const void* arg, size_t arg_size) {
+        return static_cast<int>(syscall(__NR_io_uring_enter, ring_fd, to_submit, min_complete, flags, arg, arg_size));
+    }
+
+    int io_uring_register(int ring_fd, unsigned opcode, const void* arg, unsigned arg_count) {
+        return static_cast<int>(syscall(__NR_io_uring_register, ring_fd, opcode, arg, arg_count));
+    }
+
+    template <typename T>
+    T* ring_field(void* ring, uint32_t offset) {
+        return reinterpret_cast<T*>(static_cast<std::byte*>(ring) + offset);
+    }
+
+    void* map_ring(int ring_fd, size_t size, off_t offset) {
+        auto ring = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring_fd, offset);
+
+        return ring == MAP_FAILED ? nullptr : ring;
+    }
+
+    void unmap_ring(void*& ring, size_t size) {
+        if (ring != nullptr)
+        {
+            munmap(ring, size);
+            ring = nullptr;
+        }
+    }
+#endif
+}
+
+UringReceiver::UringReceiver(SocketStats& stats)
+    : m_stats(stats)
+    , m_sock(INVALID_SOCKET)
+    , m_ring_fd(-1)
+#ifdef __linux__
+    , m_sq_ring(nullptr)
+    , m_sq_ring_size(0)
+    , m_sq_tail(nullptr)
+    , m_sq_mask(nullptr)
+    , m_sq_array(nullptr)
+    , m_sqes(nullptr)
+    , m_sqes_size(0)
+    , m_to_submit(0)
+    , m_cq_ring(nullptr)
+    , m_cq_ring_size(0)
+    , m_cq_head(nullptr)
+    , m_cq_tail(nullptr)
+    , m_cq_mask(nullptr)
+    , m_cqes(nullptr)
+    , m_buffer_ring(nullptr)
+    , m_buffer_ring_size(0)
+    , m_buffer_ring_tail(0)
+#endif
+    , m_received()
+    , m_received_head(0)
+    , m_received_count(0)
+    , m_armed(false)
+    , m_end_of_stream(false)
+    , m_failed(false)
+{}
+
+UringReceiver::~UringReceiver() {
+    stop();
+}
+
+bool UringReceiver::is_started() const {
+    return m_ring_fd != -1;
+}
+
+#ifdef URING_RECEIVER_SUPPORTED
+
+bool UringReceiver::start(SOCKET sock) {
+    stop();
+
+    io_uring_params params = {};
+    params.flags = IORING_SETUP_CQSIZE;
+    params.cq_entries = COMPLETION_ENTRIES;
+
+    m_ring_fd = io_uring_setup(SUBMISSION_ENTRIES, &params);
+
+    if (m_ring_fd < 0)
+    {
+        m_ring_fd = -1;
+
+        return false;
+    }
+
+    // Waiting with a timeout relies on IORING_ENTER_EXT_ARG (Linux 5.11)
+    if ((params.features & IORING_FEAT_EXT_ARG) == 0)
+    {
+        stop();
+
+        return false;
+    }
+
+    m_sq_ring_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    m_cq_ring_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+    m_sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+
+    if (!map_rings())
+    {
+        stop();
+
+        return false;
+    }
+
+    m_sq_tail = ring_field<unsigned>(m_sq_ring, params.sq_off.tail);
+    m_sq_mask = ring_field<unsigned>(m_sq_ring, params.sq_off.ring_mask);
+    m_sq_array = ring_field<unsigned>(m_sq_ring, params.sq_off.array);
+
+    m_cq_head = ring_field<unsigned>(m_cq_ring, params.cq_off.head);
+    m_cq_tail = ring_field<unsigned>(m_cq_ring, params.cq_off.tail);
+    m_cq_mask = ring_field<unsigned>(m_cq_ring, params.cq_off.ring_mask);
+    m_cqes = ring_field<io_uring_cqe>(m_cq_ring, params.cq_off.cqes);
+
+    // Multishot recv needs a buffer ring (Linux 6.0)
+    if (!register_buffers())
+    {
+        stop();
+
+        return false;
+    }
+
+    m_sock = sock;
+    arm_recv();
+
+    if (enter(false, SocketDeadline::max()) == SocketWaitResult::Error)
+    {
+        stop();
+
+        return false;
+    }
+
+    /*
+        io_uring_enter succeeds even if the kernel rejects the recv, e.g.
+        multishot recv before Linux 6.0. The rejection is completed while
+        the request is submitted, so its -EINVAL is already in the queue.
+        IORING_REGISTER_PROBE cannot tell, it only knows the opcode
+    */
+    reap_completions();
+
+    if (m_failed)
+    {
+        stop();
+
+        return false;
+    }
+
+    return true;
+}
+
+void UringReceiver::stop() {
+    // Closing the ring cancels the armed recv
+    if (m_ring_fd != -1)
+    {
+        close(m_ring_fd);
+        m_ring_fd = -1;
+    }
+
+    unmap_ring(m_sq_ring, m_sq_ring_size);
+    unmap_ring(m_cq_ring, m_cq_ring_size);
+
+    void* sqes = m_sqes;
+    unmap_ring(sqes, m_sqes_size);
+    m_sqes = nullptr;
+
+    void* buffer_ring = m_buffer_ring;
+    unmap_ring(buffer_ring, m_buffer_ring_size);
+    m_buffer_ring = nullptr;
+
+    m_sock = INVALID_SOCKET;
+    m_to_submit = 0;
+    m_received_head = 0;
+    m_received_count = 0;
+    m_armed = false;
+    m_end_of_stream = false;
+    m_failed = false;
+}
+
+ssize_t UringReceiver::receive(
+    std::byte* first, size_t first_size,
+    std::byte* second, size_t second_size,
+    SocketDeadline deadline)
+{
+    if (!is_started())
+    {
+        return SOCKET_ERROR;
+    }
+
+    while (true)
+    {
+        reap_completions();
+
+        auto copied = copy_received(first, first_size);
+
+        if (copied == first_size)
+        {
+            copied += copy_received(second, second_size);
+        }
+
+        // The recv stopped when the kernel ran out of buffers, copying out just returned some
+        if (!m_armed && !m_end_of_stream && !m_failed)
+        {
+            arm_recv();
+        }
+
+        if (copied > 0)
+        {
+            // A re-armed recv is submitted right away so that data keeps flowing
+            if (m_to_submit > 0)
+            {
+                enter(false, deadline);
+            }
+
+            return static_cast<ssize_t>(copied);
+        }
+
+        // Everything received before the end of the stream has been handed out
+        if (m_end_of_stream)
+        {
+            return 0;
+        }
+
+        if (m_failed)
+        {
+            return SOCKET_ERROR;
+        }
+
+        auto wait_result = enter(true, deadline);
+
+        if (wait_result == SocketWaitResult::Error)
+        {
+            return SOCKET_ERROR;
+        }
+
+        // Completions may have arrived together with the timeout
+        if (wait_result == SocketWaitResult::Timeout && *m_cq_head == __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE))
+        {
+            return SOCKET_TIMEOUT;
+        }
+    }
+}
+
+bool UringReceiver::map_rings() {
+    m_sq_ring = map_ring(m_ring_fd, m_sq_ring_size, IORING_OFF_SQ_RING);
+    m_cq_ring = map_ring(m_ring_fd, m_cq_ring_size, IORING_OFF_CQ_RING);
+    m_sqes = static_cast<io_uring_sqe*>(map_ring(m_ring_fd, m_sqes_size, IORING_OFF_SQES));
+
+    return m_sq_ring != nullptr && m_cq_ring != nullptr && m_sqes != nullptr;
+}
+
+bool UringReceiver::register_buffers() {
+    // The ring has to be page aligned, an anonymous mapping always is
+    m_buffer_ring_size = BUFFER_COUNT * sizeof(io_uring_buf);
+
+    auto buffer_ring = mmap(nullptr, m_buffer_ring_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (buffer_ring == MAP_FAILED)
+    {
+        return false;
+    }
+
+    m_buffer_ring = static_cast<io_uring_buf_ring*>(buffer_ring);
+    m_buffer_ring_tail = 0;
+
+    io_uring_buf_reg registration = {};
+    registration.ring_addr = reinterpret_cast<uint64_t>(m_buffer_ring);
+    registration.ring_entries = BUFFER_COUNT;
+    registration.bgid = BUFFER_GROUP;
+
+    if (io_uring_register(m_ring_fd, IORING_REGISTER_PBUF_RING, &registration, 1) < 0)
+    {
+        return false;
+    }
+
+    m_buffers.resize(BUFFER_COUNT * BUFFER_SIZE);
+
+    for (uint32_t id = 0; id < BUFFER_COUNT; id++)
+    {
+        recycle_buffer(static_cast<uint16_t>(id));
+    }
+
+    return true;
+}
+
+void UringReceiver::arm_recv() {
+    auto tail = *m_sq_tail;
+    auto index = tail & *m_sq_mask;
+    auto& sqe = m_sqes[index];
+
+    memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode = IORING_OP_RECV;
+    sqe.fd = m_sock;
+    sqe.ioprio = IORING_RECV_MULTISHOT;
+    sqe.flags = IOSQE_BUFFER_SELECT;
+    sqe.buf_group = BUFFER_GROUP;
+    sqe.user_data = RECV_USER_DATA;
+
+    m_sq_array[index] = index;
+    __atomic_store_n(m_sq_tail, tail + 1, __ATOMIC_RELEASE);
+
+    m_to_submit++;
+    m_armed = true;
+}
+
+void UringReceiver::reap_completions() {
+    auto head = *m_cq_head;
+    auto tail = __atomic_load_n(m_cq_tail, __ATOMIC_ACQUIRE);
+
+    for (; head != tail; head++)
+    {
+        const auto& cqe = m_cqes[head & *m_cq_mask];
+
+        // Without IORING_CQE_F_MORE the multishot recv has ended
+        if ((cqe.flags & IORING_CQE_F_MORE) == 0)
+        {
+            m_armed = false;
+        }
+
+        if (cqe.res > 0)
+        {
+            ReceivedBuffer received;
+            received.id = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+            received.size = static_cast<uint32_t>(cqe.res);
+
+            m_received[(m_received_head + m_received_count) % BUFFER_COUNT] = received;
+            m_received_count++;
+        }
+        else if (cqe.res == 0)
+        {
+            m_end_of_stream = true;
+        }
+        else if (cqe.res == -ENOBUFS)
+        {
+            // The recv is re-armed once buffers are returned, which requires some to be held here
+            m_failed = m_failed || m_received_count == 0;
+        }
+        else if (cqe.res != -EINTR)
+        {
+            m_failed = true;
+        }
+    }
+
+    __atomic_store_n(m_cq_head, head, __ATOMIC_RELEASE);
+}
+
+size_t UringReceiver::copy_received(std::byte* destination, size_t size) {
+    size_t copied = 0;
+
+    while (copied < size && m_received_count > 0)
+    {
+        auto& received = m_received[m_received_head];
+        auto to_copy = std::min<size_t>(size - copied, received.size - received.offset);
+
+        memcpy(destination + copied, m_buffers.data() + received.id * BUFFER_SIZE + received.offset, to_copy);
+
+        copied += to_copy;
+        received.offset += static_cast<uint32_t>(to_copy);
+
+        if (received.offset == received.size)
+        {
+            recycle_buffer(received.id);
+
+            m_received_head = (m_received_head + 1) % BUFFER_COUNT;
+            m_received_count--;
+        }
+    }
+
+    return copied;
+}
+
+void UringReceiver::recycle_buffer(uint16_t id) {
+    /*
+        Indexed by hand, in C++ the flexible array of the kernel header
+        is placed behind an empty struct and no longer overlays the tail
+    */
+    auto& buffer = reinterpret_cast<io_uring_buf*>(m_buffer_ring)[m_buffer_ring_tail & (BUFFER_COUNT - 1)];
+    buffer.addr = reinterpret_cast<uint64_t>(m_buffers.data() + id * BUFFER_SIZE);
+    buffer.len = static_cast<uint32_t>(BUFFER_SIZE);
+    buffer.bid = id;
+
+    m_buffer_ring_tail++;
+    __atomic_store_n(&m_buffer_ring->tail, m_buffer_ring_tail, __ATOMIC_RELEASE);
+}
+
+SocketWaitResult UringReceiver::enter(bool wait, SocketDeadline deadline) {
+    __kernel_timespec timeout = {};
+    io_uring_getevents_arg arg = {};
+
+    if (wait && deadline != SocketDeadline::max())
+    {
+        auto remaining = std::max(deadline - SocketClock::now(), SocketClock::duration::zero());
+        auto seconds = std::chrono::duration_cast<std::chrono::seconds>(remaining);
+
+        timeout.tv_sec = seconds.count();
+        timeout.tv_nsec = std::chrono::duration_cast<std::chrono::nanoseconds>(remaining - seconds).count();
+        arg.ts = reinterpret_cast<uint64_t>(&timeout);
+    }
+
+    while (true)
+    {
+        m_stats.ring_enter_calls++;
+
+        auto result = io_uring_enter(
+            m_ring_fd,
+            m_to_submit,
+            wait ? 1 : 0,
+            IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+            &arg,
+            sizeof(arg)
+        );
+
+        if (result >= 0)
+        {
+            m_to_submit -= std::min(m_to_submit, static_cast<unsigned>(result));
+
+            return SocketWaitResult::Ready;
+        }
+
+        if (errno == ETIME)
+        {
+            return SocketWaitResult::Timeout;
+        }
+        else if (errno != EINTR)
+        {
+            return SocketWaitResult::Error;
+        }
+    }
+}
+
+#else
+
+bool UringReceiver::start(SOCKET) {
+    return false;
+}
+
+void UringReceiver::stop() {}
+
+ssize_t UringReceiver::receive(std::byte*, size_t, std::byte*, size_t, SocketDeadline) {
+    return SOCKET_ERROR;
+}
+
+#endif
\ No newline at end of file
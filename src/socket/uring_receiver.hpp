@@ -0,0 +1,118 @@
+#pragma once
+
+#include <array>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include "socket.hpp"
+
+#ifdef __linux__
+    struct io_uring_sqe;
+    struct io_uring_cqe;
+    struct io_uring_buf_ring;
+#endif
+
+/*
+    io_uring receive backend for a connected stream socket (Linux only)
+
+    A single multishot recv stays armed for the whole connection and picks
+    its buffers from a ring of buffers registered with the kernel, so data
+    is received without any system call while the application keeps up.
+    io_uring_enter is only called to wait once every completion has been
+    consumed, or to re-arm the recv after the kernel ran out of buffers.
+
+    The kernel chooses the buffer, so the received bytes are copied into
+    the destination once. That copy is cheap compared to the recv and
+    epoll_wait calls it replaces.
+
+    The ring is driven by raw system calls, liburing is not required. On
+    other platforms, older kernels, or when io_uring is blocked (seccomp,
+    kernel.io_uring_disabled) start() fails and the caller keeps using recv
+*/
+class UringReceiver {
+public:
+    UringReceiver(SocketStats& stats);
+    ~UringReceiver();
+
+    // Disable the copy constructor and copy assignment operator
+    UringReceiver(const UringReceiver&) = delete;
+    UringReceiver& operator=(const UringReceiver&) = delete;
+
+    // Sets up the ring for the socket and arms the multishot recv, false if io_uring is unavailable
+    bool start(SOCKET sock);
+    void stop();
+    bool is_started() const;
+
+    /*
+        Same contract as ClientSocket::recv_data with a deadline: fills the
+        first buffer, then the second one, and returns the byte count, 0 once
+        the peer closed the connection, SOCKET_TIMEOUT or SOCKET_ERROR
+    */
+    ssize_t receive(
+        std::byte* first, size_t first_size,
+        std::byte* second, size_t second_size,
+        SocketDeadline deadline
+    );
+
+private:
+    static constexpr uint32_t   BUFFER_COUNT    = 64;           // Power of two, required by the buffer ring
+    static constexpr size_t     BUFFER_SIZE     = 16 * 1024;
+
+    // A completed recv whose buffer has not been fully copied out yet
+    struct ReceivedBuffer {
+        uint16_t    id      = 0;
+        uint32_t    offset  = 0;
+        uint32_t    size    = 0;
+    };
+
+#ifdef __linux__
+    bool map_rings();
+    bool register_buffers();
+    void arm_recv();
+    void reap_completions();
+    size_t copy_received(std::byte* destination, size_t size);
+    void recycle_buffer(uint16_t id);
+
+    // Submits pending requests and waits for a completion unless wait is false
+    SocketWaitResult enter(bool wait, SocketDeadline deadline);
+#endif
+
+    SocketStats&                m_stats;
+    SOCKET                      m_sock;
+    int                         m_ring_fd;
+
+#ifdef __linux__
+    // Submission queue
+    void*                       m_sq_ring;
+    size_t                      m_sq_ring_size;
+    unsigned*                   m_sq_tail;
+    unsigned*                   m_sq_mask;
+    unsigned*                   m_sq_array;
+    io_uring_sqe*               m_sqes;
+    size_t                      m_sqes_size;
+    unsigned                    m_to_submit;
+
+    // Completion queue
+    void*                       m_cq_ring;
+    size_t                      m_cq_ring_size;
+    unsigned*                   m_cq_head;
+    unsigned*                   m_cq_tail;
+    unsigned*                   m_cq_mask;
+    io_uring_cqe*               m_cqes;
+
+    // Registered buffers and the ring through which they are handed to the kernel
+    io_uring_buf_ring*          m_buffer_ring;
+    size_t                      m_buffer_ring_size;
+    uint16_t                    m_buffer_ring_tail;
+    std::vector<std::byte>      m_buffers;
+#endif
+
+    // Completed buffers in the order the data arrived, at most one entry per buffer
+    std::array<ReceivedBuffer, BUFFER_COUNT>    m_received;
+    size_t                                      m_received_head;
+    size_t                                      m_received_count;
+
+    bool                        m_armed;
+    bool                        m_end_of_stream;
+    bool                        m_failed;
+};
\ No newline at end of file
@@ -0,0 +1,391 @@
+#include <array>
+#include <iostream>
+#include <algorithm>
+#include "stream_hub.hpp"
+
+#ifdef __linux__
+    #include <cerrno>
+    #include <sys/epoll.h>
+    #include <sys/eventfd.h>
+#endif
+
+namespace {
+    // Events handled per epoll_wait call, more ready sessions are picked up by the next call
+    constexpr size_t MAX_EVENTS_PER_WAKEUP = 256;
+}
+
+StreamHub::Session::Session(
+    StreamSessionId id,
+    std::string server_addr,
+    uint16_t server_port,
+    uint32_t magic_number,
+    uint32_t max_packet_size,
+    StreamFrameCallback callback)
+    : id(id)
+    , server_addr(std::move(server_addr))
+    , stream(this->server_addr, server_port, magic_number, max_packet_size)
+    , callback(std::move(callback))
+    , registered(false)
+{}
+
+StreamHub::StreamHub(uint32_t magic_number, uint32_t max_packet_size, size_t loop_count)
+    : m_magic_number(magic_number)
+    , m_max_packet_size(max_packet_size)
+    , m_running(false)
+    , m_next_session_id(0)
+{
+    for (size_t i = 0; i < std::max<size_t>(loop_count, 1); i++)
+    {
+        m_loops.push_back(std::make_unique<Loop>());
+    }
+}
+
+StreamHub::~StreamHub() {
+    stop();
+}
+
+bool StreamHub::start() {
+#ifdef __linux__
+    // Already started
+    if (m_running.exchange(true))
+    {
+        return true;
+    }
+
+    for (auto& loop : m_loops)
+    {
+        loop->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+        loop->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+        // The wake-up event is the only one without a session
+        epoll_event event = {};
+        event.events = EPOLLIN;
+        event.data.ptr = nullptr;
+
+        if (loop->epoll_fd == -1 || loop->wake_fd == -1 ||
+            epoll_ctl(loop->epoll_fd, EPOLL_CTL_ADD, loop->wake_fd, &event) != 0)
+        {
+            m_running = false;
+            close_loops();
+
+            return false;
+        }
+    }
+
+    for (auto& loop : m_loops)
+    {
+        // Sessions that survived a previous stop()
+        for (auto& [session_id, session] : loop->sessions)
+        {
+            register_session(*loop, *session);
+        }
+
+        loop->thread = std::thread(&StreamHub::run_loop, this, std::ref(*loop));
+    }
+
+    return true;
+#else
+    std::cerr << "StreamHub requires epoll" << "\n";
+
+    return false;
+#endif
+}
+
+void StreamHub::stop() {
+    m_running = false;
+
+    for (auto& loop : m_loops)
+    {
+        if (loop->thread.joinable())
+        {
+            wake(*loop);
+            loop->thread.join();
+        }
+    }
+
+    close_loops();
+}
+
+bool StreamHub::is_running() const {
+    return m_running;
+}
+
+std::optional<StreamSessionId> StreamHub::add_session(
+    std::string_view server_addr,
+    uint16_t server_port,
+    StreamFrameCallback callback,
+    const StreamSessionOptions& options)
+{
+    const auto session_id = m_next_session_id.fetch_add(1);
+
+    auto session = std::make_unique<Session>(
+        session_id,
+        std::string(server_addr),
+        server_port,
+        m_magic_number,
+        m_max_packet_size,
+        std::move(callback)
+    );
+
+    // An io_uring recv would take the data before the hub's epoll instance could see it
+    auto socket_options = options.socket_options;
+    socket_options.receive_backend = SocketReceiveBackend::Recv;
+
+    session->stream.set_socket_options(socket_options);
+    session->stream.set_delta_frames_enabled(options.delta_frames);
+    session->stream.set_catch_up_enabled(options.catch_up);
+
+    if (!session->stream.connect_to_server(options.connect_timeout))
+    {
+        return std::nullopt;
+    }
+
+    auto& loop = loop_of(session_id);
+
+    {
+        std::lock_guard<std::mutex> lock(loop.pending_mutex);
+        loop.pending_added.push_back(std::move(session));
+    }
+
+    wake(loop);
+
+    return session_id;
+}
+
+void StreamHub::remove_session(StreamSessionId session_id) {
+    auto& loop = loop_of(session_id);
+
+    {
+        std::lock_guard<std::mutex> lock(loop.pending_mutex);
+        loop.pending_removed.push_back(session_id);
+    }
+
+    wake(loop);
+}
+
+std::optional<PacketStreamStats> StreamHub::session_stats(StreamSessionId session_id) const {
+    auto& loop = loop_of(session_id);
+    std::lock_guard<std::mutex> lock(loop.mutex);
+
+    auto it = loop.sessions.find(session_id);
+
+    if (it == loop.sessions.end())
+    {
+        return std::nullopt;
+    }
+
+    return it->second->stream.stats();
+}
+
+bool StreamHub::is_session_connected(StreamSessionId session_id) const {
+    auto& loop = loop_of(session_id);
+    std::lock_guard<std::mutex> lock(loop.mutex);
+
+    auto it = loop.sessions.find(session_id);
+
+    return it != loop.sessions.end() && it->second->stream.is_connected();
+}
+
+StreamHubStats StreamHub::stats() const {
+    StreamHubStats stats;
+
+    for (auto& loop : m_loops)
+    {
+        std::lock_guard<std::mutex> lock(loop->mutex);
+
+        for (auto& [session_id, session] : loop->sessions)
+        {
+            stats.sessions++;
+            stats.connected_sessions += session->stream.is_connected() ? 1 : 0;
+        }
+
+        stats.wakeups += loop->wakeups.load(std::memory_order_relaxed);
+        stats.events += loop->events.load(std::memory_order_relaxed);
+        stats.frames_delivered += loop->frames.load(std::memory_order_relaxed);
+    }
+
+    return stats;
+}
+
+StreamHub::Loop& StreamHub::loop_of(StreamSessionId session_id) const {
+    return *m_loops[session_id % m_loops.size()];
+}
+
+void StreamHub::run_loop(Loop& loop) {
+#ifdef __linux__
+    std::array<epoll_event, MAX_EVENTS_PER_WAKEUP> events;
+
+    // Sessions added before start()
+    {
+        std::lock_guard<std::mutex> lock(loop.mutex);
+        apply_pending(loop);
+    }
+
+    while (m_running)
+    {
+        auto event_count = epoll_wait(loop.epoll_fd, events.data(), static_cast<int>(events.size()), -1);
+
+        if (event_count < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            std::cerr << "StreamHub: epoll_wait failed" << "\n";
+            break;
+        }
+
+        loop.wakeups.fetch_add(1, std::memory_order_relaxed);
+        loop.events.fetch_add(static_cast<uint64_t>(event_count), std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> lock(loop.mutex);
+        bool woken = false;
+
+        for (int i = 0; i < event_count; i++)
+        {
+            auto session = static_cast<Session*>(events[i].data.ptr);
+
+            if (session == nullptr)
+            {
+                woken = true;
+                continue;
+            }
+
+            drain_session(loop, *session);
+        }
+
+        // Applied after the batch, so that no event refers to a removed session
+        if (woken)
+        {
+            apply_pending(loop);
+        }
+    }
+#else
+    (void)loop;
+#endif
+}
+
+void StreamHub::apply_pending(Loop& loop) {
+#ifdef __linux__
+    // Reset the wake-up event before looking at the lists, a later wake() then triggers again
+    uint64_t wake_count = 0;
+    auto drained = read(loop.wake_fd, &wake_count, sizeof(wake_count));
+    (void)drained;
+#endif
+
+    std::vector<std::unique_ptr<Session>> added;
+    std::vector<StreamSessionId> removed;
+
+    {
+        std::lock_guard<std::mutex> lock(loop.pending_mutex);
+        added.swap(loop.pending_added);
+        removed.swap(loop.pending_removed);
+    }
+
+    for (auto& session : added)
+    {
+        register_session(loop, *session);
+        loop.sessions.emplace(session->id, std::move(session));
+    }
+
+    for (auto session_id : removed)
+    {
+        auto it = loop.sessions.find(session_id);
+
+        if (it != loop.sessions.end())
+        {
+            unregister_session(loop, *it->second);
+            loop.sessions.erase(it);
+        }
+    }
+}
+
+void StreamHub::register_session(Loop& loop, Session& session) {
+#ifdef __linux__
+    // Level-triggered, data that arrived before the registration is reported right away
+    epoll_event event = {};
+    event.events = EPOLLIN | EPOLLRDHUP;
+    event.data.ptr = &session;
+
+    session.registered = session.stream.is_connected() &&
+        epoll_ctl(loop.epoll_fd, EPOLL_CTL_ADD, session.stream.native_handle(), &event) == 0;
+#else
+    (void)loop;
+    (void)session;
+#endif
+}
+
+void StreamHub::drain_session(Loop& loop, Session& session) {
+    uint64_t frames = 0;
+
+    while (auto frame_view_opt = session.stream.poll_frame_view())
+    {
+        session.callback(session.id, frame_view_opt.value());
+        frames++;
+    }
+
+    loop.frames.fetch_add(frames, std::memory_order_relaxed);
+
+    // The stream disconnects itself once the server is gone
+    if (!session.stream.is_connected())
+    {
+        unregister_session(loop, session);
+    }
+}
+
+void StreamHub::unregister_session(Loop& loop, Session& session) {
+    if (!session.registered)
+    {
+        return;
+    }
+
+    session.registered = false;
+
+#ifdef __linux__
+    // A closed socket has already left the epoll set on its own
+    if (session.stream.native_handle() != INVALID_SOCKET)
+    {
+        epoll_ctl(loop.epoll_fd, EPOLL_CTL_DEL, session.stream.native_handle(), nullptr);
+    }
+#else
+    (void)loop;
+#endif
+}
+
+void StreamHub::wake(Loop& loop) {
+#ifdef __linux__
+    if (loop.wake_fd != -1)
+    {
+        uint64_t one = 1;
+        auto written = write(loop.wake_fd, &one, sizeof(one));
+        (void)written;
+    }
+#else
+    (void)loop;
+#endif
+}
+
+void StreamHub::close_loops() {
+#ifdef __linux__
+    for (auto& loop : m_loops)
+    {
+        for (auto& [session_id, session] : loop->sessions)
+        {
+            session->registered = false;
+        }
+
+        if (loop->epoll_fd != -1)
+        {
+            close(loop->epoll_fd);
+            loop->epoll_fd = -1;
+        }
+
+        if (loop->wake_fd != -1)
+        {
+            close(loop->wake_fd);
+            loop->wake_fd = -1;
+        }
+    }
+#endif
+}
\ No newline at end of file
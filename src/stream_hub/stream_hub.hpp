@@ -0,0 +1,144 @@
+#pragma once
+
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <optional>
+#include <functional>
+#include <unordered_map>
+#include "../packet_stream/packet_stream.hpp"
+
+using StreamSessionId = uint32_t;
+
+/*
+    Called on the loop thread of the session for every decoded frame. The
+    view points into the receive buffer of the session and is only valid
+    during the call, decode it with frame_view_to_frame() to keep it.
+    Callbacks must not block and must not call back into the hub, except
+    for remove_session()
+*/
+using StreamFrameCallback = std::function<void(StreamSessionId session_id, const FrameView& frame_view)>;
+
+struct StreamSessionOptions {
+    std::chrono::milliseconds   connect_timeout     = std::chrono::milliseconds(1000);
+    bool                        delta_frames        = false;
+
+    // Only the newest of the frames received together is delivered, see PacketStreamClient::set_catch_up_enabled()
+    bool                        catch_up            = false;
+
+    // The receive backend is always Recv, the hub's epoll instance does the waiting
+    SocketOptions               socket_options;
+};
+
+struct StreamHubStats {
+    uint64_t sessions           = 0;
+    uint64_t connected_sessions = 0;
+
+    // epoll_wait calls returning at least one event, and the events they returned
+    uint64_t wakeups            = 0;
+    uint64_t events             = 0;
+
+    uint64_t frames_delivered   = 0;
+};
+
+/*
+    Multiplexes many packet streams on a few event loops
+
+    Every loop is a thread with its own epoll instance, sessions are
+    sharded over the loops by id. A readable session is drained with
+    PacketStreamClient::poll_frame_view(), so a loop never blocks on a
+    single stream and one thread can serve hundreds of them.
+
+    Every session owns a receive buffer of max_packet_size bytes, so the
+    size should be kept close to the largest expected frame when running
+    many sessions. Sessions use the TCP transport. A session whose server
+    closed the connection stays in the hub, disconnected, until it is
+    removed. Requires epoll (Linux), start() fails elsewhere
+*/
+class StreamHub {
+public:
+    StreamHub(uint32_t magic_number, uint32_t max_packet_size, size_t loop_count = 1);
+    ~StreamHub();
+
+    // Disable the copy constructor and copy assignment operator
+    StreamHub(const StreamHub&) = delete;
+    StreamHub& operator=(const StreamHub&) = delete;
+
+    bool start();
+    void stop();
+    bool is_running() const;
+
+    /*
+        Connects on the calling thread, then hands the session to its loop.
+        Can be called before or after start(), returns std::nullopt if the
+        connection failed
+    */
+    std::optional<StreamSessionId> add_session(
+        std::string_view server_addr,
+        uint16_t server_port,
+        StreamFrameCallback callback,
+        const StreamSessionOptions& options = StreamSessionOptions()
+    );
+
+    // Disconnects the session on its loop thread, its stats are gone afterwards
+    void remove_session(StreamSessionId session_id);
+
+    // Waits for the loop of the session, not to be called from a callback
+    std::optional<PacketStreamStats> session_stats(StreamSessionId session_id) const;
+    bool is_session_connected(StreamSessionId session_id) const;
+
+    StreamHubStats stats() const;
+
+private:
+    struct Session {
+        Session(StreamSessionId id, std::string server_addr, uint16_t server_port, uint32_t magic_number, uint32_t max_packet_size, StreamFrameCallback callback);
+
+        StreamSessionId         id;
+
+        // Owns the address, PacketStreamClient only keeps a view of it
+        std::string             server_addr;
+        PacketStreamClient      stream;
+        StreamFrameCallback     callback;
+
+        // Whether the connection is in the epoll set of its loop
+        bool                    registered;
+    };
+
+    struct Loop {
+        int                                     epoll_fd    = -1;
+        int                                     wake_fd     = -1;
+        std::thread                             thread;
+
+        // Held by the loop thread while it handles events, guards the sessions
+        mutable std::mutex                      mutex;
+        std::unordered_map<StreamSessionId, std::unique_ptr<Session>> sessions;
+
+        // Handed over by add_session()/remove_session(), applied by the loop thread
+        std::mutex                              pending_mutex;
+        std::vector<std::unique_ptr<Session>>   pending_added;
+        std::vector<StreamSessionId>            pending_removed;
+
+        std::atomic<uint64_t>                   wakeups     {0};
+        std::atomic<uint64_t>                   events      {0};
+        std::atomic<uint64_t>                   frames      {0};
+    };
+
+    Loop& loop_of(StreamSessionId session_id) const;
+    void run_loop(Loop& loop);
+    void apply_pending(Loop& loop);
+    void register_session(Loop& loop, Session& session);
+    void drain_session(Loop& loop, Session& session);
+    void unregister_session(Loop& loop, Session& session);
+    void wake(Loop& loop);
+    void close_loops();
+
+    uint32_t                                m_magic_number;
+    uint32_t                                m_max_packet_size;
+
+    std::vector<std::unique_ptr<Loop>>      m_loops;
+    std::atomic<bool>                       m_running;
+    std::atomic<StreamSessionId>            m_next_session_id;
+};
\ No newline at end of file
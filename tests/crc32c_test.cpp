@@ -0,0 +1,92 @@
+#include <random>
+#include <vector>
+#include <cstdint>
+#include "test_check.hpp"
+#include "crc32c/crc32c.hpp"
+
+namespace {
+    // Bit at a time, slow but obviously right
+    uint32_t reference_crc32c(const std::byte* data, size_t size) {
+        uint32_t crc = 0xFFFFFFFF;
+
+        for (size_t i = 0; i < size; i++)
+        {
+            crc ^= static_cast<uint32_t>(data[i]);
+
+            for (int bit = 0; bit < 8; bit++)
+            {
+                crc = (crc >> 1) ^ (0x82F63B78 & (0 - (crc & 1)));
+            }
+        }
+
+        return ~crc;
+    }
+
+    uint32_t crc32c_of(const std::vector<uint8_t>& bytes) {
+        return crc32c(reinterpret_cast<const std::byte*>(bytes.data()), bytes.size());
+    }
+
+    // Test vectors of RFC 3720 (iSCSI), appendix B.4
+    void test_known_vectors() {
+        const std::vector<uint8_t> check = { '1', '2', '3', '4', '5', '6', '7', '8', '9' };
+        CHECK(crc32c_of(check) == 0xE3069283);
+
+        CHECK(crc32c_of(std::vector<uint8_t>(32, 0x00)) == 0x8A9136AA);
+        CHECK(crc32c_of(std::vector<uint8_t>(32, 0xFF)) == 0x62A8AB43);
+
+        std::vector<uint8_t> ascending(32);
+        std::vector<uint8_t> descending(32);
+
+        for (uint8_t i = 0; i < 32; i++)
+        {
+            ascending[i] = i;
+            descending[i] = static_cast<uint8_t>(31 - i);
+        }
+
+        CHECK(crc32c_of(ascending) == 0x46DD794E);
+        CHECK(crc32c_of(descending) == 0x113FDB5C);
+
+        CHECK(crc32c(nullptr, 0) == 0);
+    }
+
+    /*
+        Every length around the 8 byte steps, at every alignment, in one
+        call and continued from a split point, against the reference
+    */
+    void test_against_reference() {
+        std::mt19937 rng(17);
+        std::vector<std::byte> data(4096 + 16);
+
+        for (auto& byte : data)
+        {
+            byte = static_cast<std::byte>(rng());
+        }
+
+        bool one_shot_matches = true;
+        bool continued_matches = true;
+
+        for (size_t size : { 1, 2, 3, 7, 8, 9, 15, 16, 17, 63, 64, 65, 1000, 4095, 4096 })
+        {
+            for (size_t offset = 0; offset < 8; offset++)
+            {
+                const auto source = data.data() + offset;
+                const auto expected = reference_crc32c(source, size);
+
+                one_shot_matches = one_shot_matches && crc32c(source, size) == expected;
+
+                const auto split = size / 3;
+                continued_matches = continued_matches && crc32c(source + split, size - split, crc32c(source, split)) == expected;
+            }
+        }
+
+        CHECK(one_shot_matches);
+        CHECK(continued_matches);
+    }
+}
+
+int main() {
+    test_known_vectors();
+    test_against_reference();
+
+    return test_exit_code();
+}
\ No newline at end of file
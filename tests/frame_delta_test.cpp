@@ -0,0 +1,172 @@
+#include <random>
+#include <vector>
+#include <cstdint>
+#include "test_check.hpp"
+#include "frame/frame_delta.hpp"
+#include "frame/frame_serializer.hpp"
+
+namespace {
+    constexpr uint32_t FRAME_COUNT = 300;
+    constexpr uint32_t INITIAL_BULLET_COUNT = 500;
+
+    Frame make_first_frame() {
+        Frame frame = {};
+        frame.client_id = 1;
+        frame.timestamp = 1;
+
+        frame.enemy_vector.resize(8);
+
+        for (uint32_t i = 0; i < frame.enemy_vector.size(); i++)
+        {
+            frame.enemy_vector[i].id = i;
+            frame.enemy_vector[i].health = 100;
+        }
+
+        frame.bullet_vector.resize(INITIAL_BULLET_COUNT);
+
+        for (uint32_t i = 0; i < INITIAL_BULLET_COUNT; i++)
+        {
+            frame.bullet_vector[i].id = i;
+            frame.bullet_vector[i].radius = 3.0f;
+        }
+
+        frame.enemy_count = static_cast<uint32_t>(frame.enemy_vector.size());
+        frame.bullet_count = INITIAL_BULLET_COUNT;
+
+        return frame;
+    }
+
+    /*
+        Moves some bullets, despawns a few and spawns new ones at the end,
+        which is the order the decoder rebuilds the arrays in
+    */
+    Frame make_next_frame(const Frame& previous, uint32_t& next_bullet_id, std::mt19937& rng) {
+        Frame frame = previous;
+        frame.timestamp++;
+        frame.score += 10;
+
+        for (auto& bullet : frame.bullet_vector)
+        {
+            if (rng() % 4 == 0)
+            {
+                bullet.pos.x += 1.5f;
+                bullet.pos.y -= 0.5f;
+            }
+        }
+
+        for (auto despawned = rng() % 6; despawned > 0 && !frame.bullet_vector.empty(); despawned--)
+        {
+            frame.bullet_vector.erase(frame.bullet_vector.begin() + rng() % frame.bullet_vector.size());
+        }
+
+        for (auto spawned = rng() % 6; spawned > 0; spawned--)
+        {
+            Bullet bullet = {};
+            bullet.id = next_bullet_id++;
+            bullet.pos = { static_cast<float>(rng() % 640), 0.0f };
+            bullet.radius = 3.0f;
+
+            frame.bullet_vector.push_back(bullet);
+        }
+
+        frame.enemy_vector[rng() % frame.enemy_vector.size()].health--;
+        frame.bullet_count = static_cast<uint32_t>(frame.bullet_vector.size());
+
+        return frame;
+    }
+
+    bool same_frame(const Frame& frame, const Frame& other) {
+        return serialize_frame(frame) == serialize_frame(other);
+    }
+
+    /*
+        Runs an acknowledging client against the encoder. Every frame must
+        come out of either a keyframe or a delta exactly as it was sent
+    */
+    void test_round_trip() {
+        std::mt19937 rng(11);
+        FrameDeltaEncoder encoder;
+        FrameDeltaDecoder decoder;
+
+        std::vector<std::byte> body;
+        Frame received;
+        uint32_t next_bullet_id = INITIAL_BULLET_COUNT;
+        uint32_t keyframes = 0;
+        uint32_t deltas = 0;
+        size_t keyframe_bytes = 0;
+        size_t delta_bytes = 0;
+        bool all_match = true;
+
+        auto frame = make_first_frame();
+
+        for (uint32_t i = 0; i < FRAME_COUNT; i++)
+        {
+            body.clear();
+
+            if (encoder.encode(frame, body) == PacketType::FrameDelta)
+            {
+                CHECK(decoder.apply(body.data(), body.size(), received) == FrameDeltaResult::Ok);
+
+                deltas++;
+                delta_bytes += body.size();
+            }
+            else
+            {
+                CHECK(deserialize_frame(body.data(), body.size(), received));
+
+                keyframes++;
+                keyframe_bytes += body.size();
+            }
+
+            all_match = all_match && same_frame(received, frame);
+
+            decoder.store_baseline(make_frame_view(received));
+            encoder.acknowledge(FrameAck{ received.timestamp, 0 });
+
+            frame = make_next_frame(frame, next_bullet_id, rng);
+        }
+
+        CHECK(all_match);
+        CHECK(keyframes > 0 && deltas > keyframes);
+
+        // A few moved bullets must cost far less than the whole frame
+        CHECK(delta_bytes / deltas < keyframe_bytes / keyframes / 2);
+    }
+
+    void test_unknown_baseline() {
+        FrameDeltaEncoder encoder;
+        std::vector<std::byte> body;
+
+        auto frame = make_first_frame();
+        encoder.encode(frame, body);
+        encoder.acknowledge(FrameAck{ frame.timestamp, 0 });
+
+        std::mt19937 rng(13);
+        uint32_t next_bullet_id = INITIAL_BULLET_COUNT;
+        frame = make_next_frame(frame, next_bullet_id, rng);
+
+        body.clear();
+        CHECK(encoder.encode(frame, body) == PacketType::FrameDelta);
+
+        // The decoder never saw the keyframe
+        FrameDeltaDecoder decoder;
+        Frame received;
+        CHECK(decoder.apply(body.data(), body.size(), received) == FrameDeltaResult::UnknownBaseline);
+
+        // Nor does it after its baselines were dropped, e.g., on a resumed session
+        decoder.store_baseline(make_frame_view(make_first_frame()));
+        decoder.clear();
+        CHECK(decoder.apply(body.data(), body.size(), received) == FrameDeltaResult::UnknownBaseline);
+
+        // A truncated body is malformed rather than a reason to ask for a keyframe
+        decoder.store_baseline(make_frame_view(make_first_frame()));
+        CHECK(decoder.apply(body.data(), body.size() / 2, received) == FrameDeltaResult::Malformed);
+    }
+}
+
+int main() {
+    test_round_trip();
+    test_unknown_baseline();
+
+    return test_exit_code();
+}
\ No newline at end of file
@@ -0,0 +1,97 @@
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include "test_check.hpp"
+#include "frame_ingest/latest_mailbox.hpp"
+
+namespace {
+    constexpr uint32_t PUBLISH_COUNT = 200000;
+    constexpr size_t PAYLOAD_SIZE = 64;
+
+    void test_latest_value_wins() {
+        LatestMailbox<uint32_t> mailbox;
+        uint32_t value = 0;
+
+        CHECK(!mailbox.try_take(value));
+
+        mailbox.back_slot() = 1;
+        CHECK(!mailbox.publish());
+
+        mailbox.back_slot() = 2;
+        CHECK(mailbox.publish());   // 1 was never taken
+
+        CHECK(mailbox.try_take(value));
+        CHECK(value == 2);
+
+        // Taking twice without a new publish finds nothing
+        CHECK(!mailbox.try_take(value));
+
+        mailbox.back_slot() = 3;
+        CHECK(!mailbox.publish());
+        CHECK(mailbox.try_take(value));
+        CHECK(value == 3);
+    }
+
+    /*
+        The producer fills every element of the payload with the same
+        sequence number, so a torn read shows up as a mixed payload, and
+        the sequence numbers the consumer sees must only ever grow
+    */
+    void test_concurrent_publish() {
+        LatestMailbox<std::vector<uint32_t>> mailbox;
+
+        std::thread producer([&]() {
+            for (uint32_t sequence = 1; sequence <= PUBLISH_COUNT; sequence++)
+            {
+                auto& payload = mailbox.back_slot();
+                payload.assign(PAYLOAD_SIZE, sequence);
+
+                mailbox.publish();
+            }
+        });
+
+        std::vector<uint32_t> payload;
+        uint32_t last_sequence = 0;
+        uint64_t taken = 0;
+        bool torn = false;
+        bool reordered = false;
+
+        while (last_sequence < PUBLISH_COUNT)
+        {
+            if (!mailbox.try_take(payload))
+            {
+                continue;
+            }
+
+            taken++;
+
+            if (payload.size() != PAYLOAD_SIZE)
+            {
+                torn = true;
+                break;
+            }
+
+            for (auto sequence : payload)
+            {
+                torn = torn || sequence != payload.front();
+            }
+
+            reordered = reordered || payload.front() <= last_sequence;
+            last_sequence = payload.front();
+        }
+
+        producer.join();
+
+        CHECK(!torn);
+        CHECK(!reordered);
+        CHECK(taken > 0);
+        CHECK(last_sequence == PUBLISH_COUNT);
+    }
+}
+
+int main() {
+    test_latest_value_wins();
+    test_concurrent_publish();
+
+    return test_exit_code();
+}
\ No newline at end of file
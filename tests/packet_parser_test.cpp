@@ -0,0 +1,151 @@
+#include <random>
+#include <algorithm>
+#include <vector>
+#include <cstdint>
+#include <stdexcept>
+#include "test_check.hpp"
+#include "frame/frame_serializer.hpp"
+#include "packet_stream/packet_parser.hpp"
+
+namespace {
+    constexpr uint32_t TEST_MAGIC_NUMBER = 0x7F3B29D1;
+    constexpr uint32_t TEST_MAX_PACKET_SIZE = 4096;
+    constexpr uint32_t PACKET_COUNT = 500;
+
+    // The body of packet i, so every parsed packet can be matched against what was sent
+    std::vector<std::byte> make_body(uint32_t index, uint32_t size) {
+        std::vector<std::byte> body(size);
+
+        for (uint32_t i = 0; i < size; i++)
+        {
+            body[i] = static_cast<std::byte>((index + i) & 0xFF);
+        }
+
+        return body;
+    }
+
+    // Feeds the stream in random chunks and returns the bodies of every packet parsed
+    std::vector<std::vector<std::byte>> parse_stream(PacketParser& parser, const std::vector<std::byte>& stream, std::mt19937& rng) {
+        std::vector<std::vector<std::byte>> bodies;
+        size_t position = 0;
+
+        while (position < stream.size())
+        {
+            const auto chunk = std::min<size_t>(1 + rng() % 700, stream.size() - position);
+            const auto written = parser.feed(stream.data() + position, chunk);
+
+            position += written;
+
+            while (auto packet_opt = parser.next_packet())
+            {
+                bodies.emplace_back(packet_opt->body, packet_opt->body + packet_opt->body_size);
+                parser.release_packet();
+            }
+
+            // A full buffer without a complete packet would stall the stream
+            if (written == 0)
+            {
+                CHECK(written != 0);
+
+                break;
+            }
+        }
+
+        return bodies;
+    }
+
+    /*
+        Garbage between the packets, rich in the first byte of the magic
+        number, makes the parser lose the boundary before every packet.
+        Each packet must still come out exactly once and in order
+    */
+    void test_resync_after_garbage(uint8_t packet_flags) {
+        std::mt19937 rng(3);
+        std::vector<std::byte> stream;
+        std::vector<std::vector<std::byte>> sent;
+
+        for (uint32_t i = 0; i < PACKET_COUNT; i++)
+        {
+            for (auto garbage = rng() % 20; garbage > 0; garbage--)
+            {
+                stream.push_back(static_cast<std::byte>(rng() % 3 == 0 ? 0xD1 : rng() & 0xFF));
+            }
+
+            sent.push_back(make_body(i, 1 + rng() % 3000));
+            CHECK(append_packet(stream, TEST_MAGIC_NUMBER, PacketType::Frame, sent.back().data(), sent.back().size(), packet_flags));
+        }
+
+        PacketParser parser(TEST_MAGIC_NUMBER, TEST_MAX_PACKET_SIZE);
+        const auto received = parse_stream(parser, stream, rng);
+
+        CHECK(received == sent);
+        CHECK(parser.stats().packets_parsed == PACKET_COUNT);
+        CHECK(parser.stats().resync_count > 0);
+        CHECK(parser.stats().checksum_failures == 0);
+    }
+
+    // A magic number followed by an impossible size is counted and stepped over
+    void test_invalid_size_is_skipped() {
+        const auto bogus_header = make_packet_header(TEST_MAGIC_NUMBER, PacketType::Frame, TEST_MAX_PACKET_SIZE * 2);
+        const auto bogus_bytes = reinterpret_cast<const std::byte*>(&bogus_header);
+
+        std::vector<std::byte> stream(bogus_bytes, bogus_bytes + sizeof(PacketHeader));
+
+        const auto body = make_body(7, 100);
+        CHECK(append_packet(stream, TEST_MAGIC_NUMBER, PacketType::Frame, body.data(), body.size()));
+
+        PacketParser parser(TEST_MAGIC_NUMBER, TEST_MAX_PACKET_SIZE);
+        std::mt19937 rng(5);
+        const auto received = parse_stream(parser, stream, rng);
+
+        CHECK(received.size() == 1 && received.front() == body);
+        CHECK(parser.stats().invalid_sizes == 1);
+    }
+
+    // A corrupted checksummed packet is dropped without losing the one behind it
+    void test_corrupted_packet_is_dropped() {
+        const auto flags = static_cast<uint8_t>(PacketFlag::Checksummed);
+        const auto first = make_body(1, 200);
+        const auto second = make_body(2, 300);
+
+        std::vector<std::byte> stream;
+        CHECK(append_packet(stream, TEST_MAGIC_NUMBER, PacketType::Frame, first.data(), first.size(), flags));
+        CHECK(append_packet(stream, TEST_MAGIC_NUMBER, PacketType::Frame, second.data(), second.size(), flags));
+
+        stream[sizeof(PacketHeader) + sizeof(PacketChecksum) + 50] ^= std::byte(0x40);
+
+        PacketParser parser(TEST_MAGIC_NUMBER, TEST_MAX_PACKET_SIZE);
+        parser.set_checksum_required(true);
+
+        std::mt19937 rng(7);
+        const auto received = parse_stream(parser, stream, rng);
+
+        CHECK(received.size() == 1 && received.front() == second);
+        CHECK(parser.stats().checksum_failures == 1);
+    }
+
+    void test_max_packet_size_is_checked() {
+        auto rejected = false;
+
+        try
+        {
+            PacketParser parser(TEST_MAGIC_NUMBER, PACKET_BODY_SIZE_MASK + 1);
+        }
+        catch (const std::invalid_argument&)
+        {
+            rejected = true;
+        }
+
+        CHECK(rejected);
+    }
+}
+
+int main() {
+    test_resync_after_garbage(0);
+    test_resync_after_garbage(static_cast<uint8_t>(PacketFlag::Checksummed));
+    test_invalid_size_is_skipped();
+    test_corrupted_packet_is_dropped();
+    test_max_packet_size_is_checked();
+
+    return test_exit_code();
+}
\ No newline at end of file
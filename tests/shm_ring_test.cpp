@@ -0,0 +1,165 @@
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <unistd.h>
+#include "test_check.hpp"
+#include "shm_ring/shm_ring.hpp"
+
+namespace {
+    constexpr size_t RING_CAPACITY = 4096;
+    constexpr uint32_t CHUNK_COUNT = 20000;
+    constexpr auto WAIT_TIMEOUT = std::chrono::seconds(5);
+
+    // One segment name per process and test, so concurrent runs do not share a ring
+    std::string ring_name(const char* test_name) {
+        return "/bullet_hell_test_" + std::to_string(getpid()) + "_" + test_name;
+    }
+
+    // Byte i of the stream, the reader checks every byte against it
+    std::byte stream_byte(uint64_t position) {
+        return static_cast<std::byte>((position * 31 + (position >> 8)) & 0xFF);
+    }
+
+    /*
+        Chunks of varying size through a ring much smaller than the stream,
+        so both sides keep wrapping around and waiting for each other
+    */
+    void test_stream_through_small_ring() {
+        const auto name = ring_name("stream");
+
+        ShmRingWriter writer;
+        CHECK(writer.create(name, RING_CAPACITY));
+
+        ShmRingReader reader;
+        CHECK(reader.open(name));
+        CHECK(reader.capacity() == writer.capacity());
+
+        std::atomic<bool> writes_ok(true);
+        std::atomic<uint64_t> written(0);
+
+        std::thread writer_thread([&]() {
+            std::vector<std::byte> chunk;
+            uint64_t position = 0;
+
+            for (uint32_t i = 0; i < CHUNK_COUNT; i++)
+            {
+                chunk.resize(1 + (i * 97) % 1500);
+
+                for (auto& byte : chunk)
+                {
+                    byte = stream_byte(position++);
+                }
+
+                if (!writer.write(chunk, SocketClock::now() + WAIT_TIMEOUT))
+                {
+                    writes_ok = false;
+                    break;
+                }
+            }
+
+            written = position;
+            writer.close();
+        });
+
+        uint64_t position = reader.read_position();
+        bool bytes_match = true;
+
+        while (true)
+        {
+            const auto available = reader.wait_for_data(position, SocketClock::now() + WAIT_TIMEOUT);
+
+            if (available <= 0)
+            {
+                CHECK(available == 0);
+
+                break;
+            }
+
+            for (ssize_t i = 0; i < available; i++, position++)
+            {
+                bytes_match = bytes_match && reader.data()[position & (reader.capacity() - 1)] == stream_byte(position);
+            }
+
+            reader.release(position);
+        }
+
+        writer_thread.join();
+        reader.close();
+
+        CHECK(writes_ok);
+        CHECK(bytes_match);
+        CHECK(position == written);
+    }
+
+    // A writer waiting for room on a full ring gives up once the reader goes away
+    void test_writer_stops_when_reader_closes() {
+        const auto name = ring_name("close");
+
+        ShmRingWriter writer;
+        CHECK(writer.create(name, RING_CAPACITY));
+
+        ShmRingReader reader;
+        CHECK(reader.open(name));
+
+        const std::vector<std::byte> chunk(RING_CAPACITY / 4);
+
+        for (size_t i = 0; i < 4; i++)
+        {
+            CHECK(writer.write(chunk, SocketClock::now() + WAIT_TIMEOUT));
+        }
+
+        std::atomic<bool> write_result(true);
+        std::thread writer_thread([&]() {
+            write_result = writer.write(chunk, SocketClock::now() + WAIT_TIMEOUT);
+        });
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+
+        const auto start = SocketClock::now();
+        reader.close();
+        writer_thread.join();
+
+        CHECK(!write_result);
+        CHECK(SocketClock::now() - start < WAIT_TIMEOUT / 2);
+
+        writer.close();
+    }
+
+    // interrupt() wakes a reader waiting on an empty ring
+    void test_interrupt_wakes_reader() {
+        const auto name = ring_name("interrupt");
+
+        ShmRingWriter writer;
+        CHECK(writer.create(name, RING_CAPACITY));
+
+        ShmRingReader reader;
+        CHECK(reader.open(name));
+
+        std::thread interrupt_thread([&]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            reader.interrupt();
+        });
+
+        const auto start = SocketClock::now();
+        const auto available = reader.wait_for_data(reader.read_position(), SocketClock::now() + WAIT_TIMEOUT);
+
+        interrupt_thread.join();
+
+        CHECK(available == 0);
+        CHECK(SocketClock::now() - start < WAIT_TIMEOUT / 2);
+
+        reader.close();
+        writer.close();
+    }
+}
+
+int main() {
+    test_stream_through_small_ring();
+    test_writer_stops_when_reader_closes();
+    test_interrupt_wakes_reader();
+
+    return test_exit_code();
+}
\ No newline at end of file
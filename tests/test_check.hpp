@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdlib>
+#include <iostream>
+
+/*
+    Minimal checks for the test executables
+
+    CHECK keeps going after a failure, so one run reports every broken
+    expectation, and test_exit_code() turns the count into the exit status
+    ctest looks at. Unlike assert it stays active in release builds.
+    Only call it from the main thread
+*/
+inline int& test_failure_count() {
+    static int failure_count = 0;
+
+    return failure_count;
+}
+
+#define CHECK(condition)                                                                    \
+    do                                                                                      \
+    {                                                                                       \
+        if (!(condition))                                                                   \
+        {                                                                                   \
+            test_failure_count()++;                                                         \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed\n"; \
+        }                                                                                   \
+    } while (false)
+
+inline int test_exit_code() {
+    if (test_failure_count() != 0)
+    {
+        std::cerr << test_failure_count() << " checks failed" << "\n";
+
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
\ No newline at end of file